@@ -20,8 +20,9 @@
 
 #include "backends.h"
 
+#include "log.h"
+
 #include <string.h>
-#include <stdio.h>
 
 /**
  * Public interface
@@ -43,10 +44,10 @@ const char *backends_backends[] = {
 backends_backend_id_t backends_find_backend_with_name(const char *name) {
     for (int i = 0; backends_backends[i] != NULL; ++i) {
         if (strcmp(backends_backends[i], name) == 0) {
-            printf("Found backend: %s\n", name);
+            log_verbose("Found backend: %s", name);
             return i;
         }
     }
-    printf("Backend %s not found\n", name);
+    log_warning("Backend %s not found", name);
     return BACKENDS_BACKEND_NONE;
 }
@@ -0,0 +1,233 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "backlight.h"
+
+#include "log.h"
+
+#include "lvgl/lvgl.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * Defines
+ */
+
+#define BACKLIGHT_CLASS_PATH "/sys/class/backlight"
+#define BACKLIGHT_LED_PATH "/sys/class/leds/lcd-backlight"
+/* Used if max_brightness can't be read */
+#define BACKLIGHT_DEFAULT_MAX 255
+
+
+/**
+ * Static variables
+ */
+
+/* Preference order of backlight types, see Documentation/ABI/stable/sysfs-class-backlight */
+static const char *types[] = { "firmware", "platform", "raw", NULL };
+
+static bool is_initialised = false;
+static int brightness_fd = -1;
+static int max_brightness = BACKLIGHT_DEFAULT_MAX;
+static int brightness = BACKLIGHT_DEFAULT_MAX;
+static int written_brightness = -1;
+static lv_timer_t *write_timer = NULL;
+
+
+/**
+ * Static prototypes
+ */
+
+/**
+ * Read an integer from a sysfs attribute.
+ *
+ * @param dir device directory
+ * @param name attribute name
+ * @param value pointer for writing the value into
+ * @return true on success, false otherwise
+ */
+static bool read_int(const char *dir, const char *name, int *value);
+
+/**
+ * Find the preferred device in the backlight class.
+ *
+ * @param dir pointer for writing the device directory into
+ * @param size size of dir
+ * @return true if a device was found, false otherwise
+ */
+static bool find_device(char *dir, size_t size);
+
+/**
+ * Write the latest brightness.
+ *
+ * @param timer the write timer
+ */
+static void write_timer_cb(lv_timer_t *timer);
+
+
+/**
+ * Static functions
+ */
+
+static bool read_int(const char *dir, const char *name, int *value) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        return false;
+    }
+
+    long parsed = 0;
+    bool ok = fscanf(file, "%ld", &parsed) == 1 && parsed >= 0 && parsed <= INT_MAX;
+    fclose(file);
+
+    if (ok) {
+        *value = (int)parsed;
+    }
+    return ok;
+}
+
+static bool find_device(char *dir, size_t size) {
+    DIR *class_dir = opendir(BACKLIGHT_CLASS_PATH);
+    if (class_dir == NULL) {
+        return false;
+    }
+
+    int best_rank = -1;
+    struct dirent *entry;
+    while ((entry = readdir(class_dir)) != NULL) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+
+        char device[PATH_MAX];
+        char path[PATH_MAX];
+        char type[32] = "";
+        snprintf(device, sizeof(device), "%s/%s", BACKLIGHT_CLASS_PATH, entry->d_name);
+        snprintf(path, sizeof(path), "%s/type", device);
+
+        FILE *file = fopen(path, "r");
+        if (file != NULL) {
+            if (fgets(type, sizeof(type), file) == NULL) {
+                type[0] = '\0';
+            }
+            type[strcspn(type, "\n")] = '\0';
+            fclose(file);
+        }
+
+        /* Unknown types rank below all known ones */
+        int rank = 0;
+        for (int i = 0; types[i] != NULL; ++i) {
+            if (strcmp(type, types[i]) == 0) {
+                rank = (int)(sizeof(types) / sizeof(types[0])) - i;
+                break;
+            }
+        }
+
+        if (rank > best_rank) {
+            best_rank = rank;
+            snprintf(dir, size, "%s", device);
+        }
+    }
+
+    closedir(class_dir);
+    return best_rank >= 0;
+}
+
+static void write_timer_cb(lv_timer_t *timer) {
+    lv_timer_pause(timer);
+
+    if (brightness_fd < 0 || brightness == written_brightness) {
+        return;
+    }
+
+    char buffer[16];
+    int len = snprintf(buffer, sizeof(buffer), "%d", brightness);
+    if (pwrite(brightness_fd, buffer, len, 0) < 0) {
+        log_error("Failed to write brightness (Error: %s)", strerror(errno));
+        return;
+    }
+
+    written_brightness = brightness;
+}
+
+
+/**
+ * Public functions
+ */
+
+bool backlight_init(void) {
+    if (is_initialised) {
+        return brightness_fd >= 0;
+    }
+    is_initialised = true;
+
+    char dir[PATH_MAX];
+    if (!find_device(dir, sizeof(dir))) {
+        snprintf(dir, sizeof(dir), "%s", BACKLIGHT_LED_PATH);
+    }
+
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/brightness", dir);
+    brightness_fd = open(path, O_WRONLY | O_CLOEXEC);
+    if (brightness_fd < 0) {
+        log_error("No usable backlight found (Error: %s)", strerror(errno));
+        return false;
+    }
+
+    if (!read_int(dir, "max_brightness", &max_brightness) || max_brightness == 0) {
+        max_brightness = BACKLIGHT_DEFAULT_MAX;
+    }
+    if (!read_int(dir, "brightness", &brightness)) {
+        brightness = max_brightness;
+    }
+    written_brightness = brightness;
+
+    write_timer = lv_timer_create(write_timer_cb, LV_DISP_DEF_REFR_PERIOD, NULL);
+    lv_timer_pause(write_timer);
+
+    log_info("Using backlight %s", dir);
+    return true;
+}
+
+int backlight_get_max(void) {
+    return max_brightness;
+}
+
+int backlight_get(void) {
+    return brightness;
+}
+
+void backlight_set(int value) {
+    brightness = LV_MAX(0, LV_MIN(value, max_brightness));
+
+    if (write_timer != NULL && write_timer->paused) {
+        lv_timer_reset(write_timer);
+        lv_timer_resume(write_timer);
+    }
+}
@@ -0,0 +1,57 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef BACKLIGHT_H
+#define BACKLIGHT_H
+
+#include <stdbool.h>
+
+/**
+ * Find the backlight device and open its brightness file. Devices in /sys/class/backlight are
+ * preferred by type (firmware, platform, raw), the lcd-backlight LED is used as a fallback. Must
+ * be called after lv_init. Calling it again has no effect.
+ *
+ * @return true if a backlight was found, false otherwise
+ */
+bool backlight_init(void);
+
+/**
+ * Get the maximum brightness.
+ *
+ * @return maximum brightness, 255 if no backlight was found
+ */
+int backlight_get_max(void);
+
+/**
+ * Get the brightness, including a change that wasn't written yet.
+ *
+ * @return brightness
+ */
+int backlight_get(void);
+
+/**
+ * Change the brightness. The value is written on the next frame, so repeated changes within a
+ * frame only cost one write.
+ *
+ * @param value brightness between 0 and the maximum
+ */
+void backlight_set(int value);
+
+#endif /* BACKLIGHT_H */
@@ -0,0 +1,207 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Run factory_reset() once and report its wall time, throughput, CPU time and the bytes that reached
+ * the given block devices. Meant to be started by run-factory-reset-bench.sh inside a fake
+ * environment of loop devices.
+ */
+
+#include "event_loop.h"
+#include "factory_reset.h"
+#include "tick.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/resource.h>
+
+/**
+ * Defines
+ */
+
+/* Maximum number of block devices whose writes are counted */
+#define MAX_DEVICES 8
+
+
+/**
+ * Static types
+ */
+
+/* Progress of the reset as seen through its progress callback */
+typedef struct {
+    /* Phase reported last */
+    const char *phase;
+    /* Time the userdata phase started and ended, 0 if it didn't */
+    uint64_t userdata_start_us;
+    uint64_t userdata_end_us;
+    /* Size of the userdata image */
+    uint64_t userdata_bytes;
+} progress;
+
+
+/**
+ * Static prototypes
+ */
+
+/**
+ * Get the number of bytes written to a block device since boot.
+ *
+ * @param name device name in /sys/class/block, e.g. loop0
+ * @return number of bytes
+ */
+static uint64_t bytes_written(const char *name);
+
+/**
+ * Track phase changes of the reset.
+ *
+ * @param phase current phase
+ * @param bytes_done number of bytes processed in the current phase
+ * @param bytes_total total number of bytes of the current phase
+ * @param user_data the progress
+ */
+static void progress_cb(const char *phase, uint64_t bytes_done, uint64_t bytes_total, void *user_data);
+
+/**
+ * Get the CPU time of the process and its waited for children.
+ *
+ * @param user_us pointer for writing the user time in microseconds into
+ * @param sys_us pointer for writing the system time in microseconds into
+ */
+static void cpu_time(uint64_t *user_us, uint64_t *sys_us);
+
+
+/**
+ * Static functions
+ */
+
+static uint64_t bytes_written(const char *name) {
+    char path[256];
+    snprintf(path, sizeof(path), "/sys/class/block/%s/stat", name);
+
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        perror(path);
+        return 0;
+    }
+
+    /* The seventh field counts written sectors of 512 bytes, see Documentation/block/stat.rst */
+    unsigned long long fields[7] = { 0 };
+    int n = fscanf(file, "%llu %llu %llu %llu %llu %llu %llu", &fields[0], &fields[1], &fields[2], &fields[3],
+        &fields[4], &fields[5], &fields[6]);
+    fclose(file);
+
+    return n == 7 ? fields[6] * 512 : 0;
+}
+
+static void progress_cb(const char *phase, uint64_t bytes_done, uint64_t bytes_total, void *user_data) {
+    (void)bytes_done;
+    progress *p = user_data;
+
+    if (phase != p->phase) {
+        if (strcmp(phase, "Restoring userdata") == 0) {
+            p->userdata_start_us = tick_now_us();
+        } else if (p->userdata_start_us != 0 && p->userdata_end_us == 0) {
+            p->userdata_end_us = tick_now_us();
+        }
+        p->phase = phase;
+    }
+
+    if (strcmp(phase, "Restoring userdata") == 0 && bytes_total > 0) {
+        p->userdata_bytes = bytes_total;
+    }
+}
+
+static void cpu_time(uint64_t *user_us, uint64_t *sys_us) {
+    struct rusage self;
+    struct rusage children;
+    getrusage(RUSAGE_SELF, &self);
+    getrusage(RUSAGE_CHILDREN, &children);
+
+    *user_us = (uint64_t)(self.ru_utime.tv_sec + children.ru_utime.tv_sec) * 1000000
+        + self.ru_utime.tv_usec + children.ru_utime.tv_usec;
+    *sys_us = (uint64_t)(self.ru_stime.tv_sec + children.ru_stime.tv_sec) * 1000000
+        + self.ru_stime.tv_usec + children.ru_stime.tv_usec;
+}
+
+
+/**
+ * Public functions
+ */
+
+/* The benchmark has no event loop, so the device state is only probed once */
+bool event_loop_add_fd(int fd, event_loop_fd_cb cb, void *user_data) {
+    (void)fd;
+    (void)cb;
+    (void)user_data;
+    return false;
+}
+
+
+/**
+ * Main
+ */
+
+int main(int argc, char *argv[]) {
+    const char *devices[MAX_DEVICES];
+    uint64_t written_before[MAX_DEVICES];
+    int num_devices = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (num_devices == MAX_DEVICES) {
+            fprintf(stderr, "At most %d devices can be counted\n", MAX_DEVICES);
+            return EXIT_FAILURE;
+        }
+        devices[num_devices] = argv[i];
+        written_before[num_devices] = bytes_written(argv[i]);
+        ++num_devices;
+    }
+
+    progress p;
+    memset(&p, 0, sizeof(p));
+    uint64_t user_before, sys_before;
+    cpu_time(&user_before, &sys_before);
+    const uint64_t start = tick_now_us();
+
+    const int result = factory_reset(progress_cb, &p);
+
+    const uint64_t end = tick_now_us();
+    uint64_t user_after, sys_after;
+    cpu_time(&user_after, &sys_after);
+
+    uint64_t written = 0;
+    for (int i = 0; i < num_devices; ++i) {
+        written += bytes_written(devices[i]) - written_before[i];
+    }
+
+    if (p.userdata_start_us != 0 && p.userdata_end_us == 0) {
+        p.userdata_end_us = end;
+    }
+    const double userdata_s = (p.userdata_end_us - p.userdata_start_us) / 1e6;
+
+    printf("bench result=%d wall_s=%.3f userdata_s=%.3f userdata_mb_per_s=%.1f cpu_user_s=%.3f cpu_sys_s=%.3f "
+        "image_bytes=%llu bytes_written=%llu\n",
+        result, (end - start) / 1e6, userdata_s, userdata_s > 0 ? p.userdata_bytes / 1e6 / userdata_s : 0.0,
+        (user_after - user_before) / 1e6, (sys_after - sys_before) / 1e6,
+        (unsigned long long)p.userdata_bytes, (unsigned long long)written);
+
+    return result == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+# Copyright 2026 FuriLabs
+# SPDX-License-Identifier: GPL-3.0-or-later
+#
+# Build a minimal Android super partition image holding a single logical
+# partition, for exercising the dynamic partition mapping without a phone.
+# The layout follows AOSP's liblp metadata format (version 10.0).
+#
+# Usage: ./make-super.py PARTITION_IMAGE SUPER_IMAGE [PARTITION_NAME]
+
+import hashlib
+import os
+import struct
+import sys
+
+SECTOR_SIZE = 512
+RESERVED_BYTES = 4096
+GEOMETRY_SIZE = 4096
+METADATA_MAX_SIZE = 65536
+METADATA_SLOT_COUNT = 1
+# Partition data starts at 1 MiB, like on real devices
+ALIGNMENT = 1024 * 1024
+
+GEOMETRY_MAGIC = 0x616C4467
+HEADER_MAGIC = 0x414C5030
+HEADER_SIZE = 128
+
+
+def geometry():
+    fields = (GEOMETRY_MAGIC, 52, bytes(32), METADATA_MAX_SIZE, METADATA_SLOT_COUNT, 4096)
+    blank = struct.pack('<II32sIII', *fields)
+    checksum = hashlib.sha256(blank).digest()
+    return struct.pack('<II32sIII', GEOMETRY_MAGIC, 52, checksum, METADATA_MAX_SIZE, METADATA_SLOT_COUNT, 4096)
+
+
+def metadata(name, num_sectors, super_size):
+    first_sector = ALIGNMENT // SECTOR_SIZE
+
+    partitions = struct.pack('<36sIIII', name.encode(), 0, 0, 1, 0)
+    extents = struct.pack('<QIQI', num_sectors, 0, first_sector, 0)
+    groups = struct.pack('<36sIQ', b'default', 0, 0)
+    block_devices = struct.pack('<QIIQ36sI', first_sector, ALIGNMENT, 0, super_size, b'super', 0)
+    tables = partitions + extents + groups + block_devices
+
+    descriptors = b''
+    offset = 0
+    for table, size in ((partitions, 52), (extents, 24), (groups, 48), (block_devices, 64)):
+        descriptors += struct.pack('<III', offset, len(table) // size, size)
+        offset += len(table)
+
+    def header(checksum):
+        return struct.pack('<IHHI32sI32s', HEADER_MAGIC, 10, 0, HEADER_SIZE, checksum, len(tables),
+                           hashlib.sha256(tables).digest()) + descriptors
+
+    return header(hashlib.sha256(header(bytes(32))).digest()) + tables
+
+
+def main():
+    if len(sys.argv) < 3:
+        sys.exit(f'Usage: {sys.argv[0]} PARTITION_IMAGE SUPER_IMAGE [PARTITION_NAME]')
+
+    image, super_image = sys.argv[1:3]
+    name = sys.argv[3] if len(sys.argv) > 3 else 'system_a'
+
+    size = os.path.getsize(image)
+    num_sectors = (size + SECTOR_SIZE - 1) // SECTOR_SIZE
+    super_size = ALIGNMENT + num_sectors * SECTOR_SIZE
+
+    slot = metadata(name, num_sectors, super_size).ljust(METADATA_MAX_SIZE, b'\0')
+    geo = geometry().ljust(GEOMETRY_SIZE, b'\0')
+
+    with open(super_image, 'wb') as out:
+        out.write(bytes(RESERVED_BYTES))
+        # Primary and backup geometry, then primary and backup metadata
+        out.write(geo * 2)
+        out.write(slot * METADATA_SLOT_COUNT * 2)
+        out.seek(ALIGNMENT)
+        with open(image, 'rb') as src:
+            while True:
+                chunk = src.read(4 * 1024 * 1024)
+                if not chunk:
+                    break
+                out.write(chunk)
+        out.truncate(super_size)
+
+
+if __name__ == '__main__':
+    main()
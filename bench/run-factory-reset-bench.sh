@@ -0,0 +1,189 @@
+#!/bin/sh -e
+# Copyright 2026 FuriLabs
+# SPDX-License-Identifier: GPL-3.0-or-later
+#
+# Run a factory reset against loop devices instead of a phone's partitions
+# and print its timings. A synthetic userdata image is packed into a system
+# partition inside a fake super partition; boot and dtbo come either from the
+# system partition or, with --rootfs-fallback, from a stub droidian rootfs LV.
+# The partition labels are faked in a private mount namespace. Needs root,
+# losetup, dmsetup, mkfs.ext4, tar, gzip and python3.
+#
+# Usage: ./run-factory-reset-bench.sh BENCH [--size MIB] [--zero-pct PCT]
+#                                           [--indexed] [--rootfs-fallback]
+#                                           [--rootfs-in-userdata]
+#
+# --size        size of the userdata image in MiB (default 256)
+# --zero-pct    percentage of 1 MiB blocks that are zero (default 0)
+# --indexed     pack the archive with make-userdata-archive.sh
+# --rootfs-fallback
+#               leave boot.img and dtbo.img out of the system partition
+# --rootfs-in-userdata
+#               like --rootfs-fallback, but carve the rootfs LV out of the end
+#               of the userdata partition like on a real device. Before the
+#               reset it holds a rootfs with stale images, so flashing them
+#               fails the check that the images on boot and dtbo are current.
+
+if [ $# -lt 1 ]; then
+    echo "Usage: $0 BENCH [--size MIB] [--zero-pct PCT] [--indexed] [--rootfs-fallback] [--rootfs-in-userdata]" >&2
+    exit 1
+fi
+
+bench="$(realpath "$1")"
+shift
+here="$(dirname "$(realpath "$0")")"
+
+size=256
+zero_pct=0
+indexed=false
+rootfs_fallback=false
+rootfs_in_userdata=false
+while [ $# -gt 0 ]; do
+    case "$1" in
+        --size) size="$2"; shift ;;
+        --zero-pct) zero_pct="$2"; shift ;;
+        --indexed) indexed=true ;;
+        --rootfs-fallback) rootfs_fallback=true ;;
+        --rootfs-in-userdata) rootfs_fallback=true; rootfs_in_userdata=true ;;
+        *) echo "Unknown option $1" >&2; exit 1 ;;
+    esac
+    shift
+done
+
+# The rootfs is 128 MiB
+rootfs_mib=128
+if $rootfs_in_userdata && [ "$size" -le "$rootfs_mib" ]; then
+    echo "--rootfs-in-userdata needs a userdata image larger than $rootfs_mib MiB" >&2
+    exit 1
+fi
+rootfs_offset_mib=$((size - rootfs_mib))
+
+if [ "$(id -u)" -ne 0 ]; then
+    echo "The benchmark needs root for loop and device-mapper devices, skipping" >&2
+    # Tells meson test that the benchmark was skipped
+    exit 77
+fi
+
+if ! dmsetup version > /dev/null 2>&1; then
+    echo "The benchmark needs device-mapper and dmsetup, skipping" >&2
+    exit 77
+fi
+
+# Never touch a real device's mappings
+for name in dynpart-system_a dynpart-system_b droidian-droidian--rootfs; do
+    if [ -e "/dev/mapper/$name" ]; then
+        echo "/dev/mapper/$name exists, refusing to run on a real device" >&2
+        exit 1
+    fi
+done
+
+tmp="$(mktemp -d "${BENCH_TMPDIR:-/var/tmp}/factory-reset-bench.XXXXXX")"
+created_dirs=""
+
+cleanup() {
+    dmsetup remove dynpart-system_a 2>/dev/null || true
+    dmsetup remove droidian-droidian--rootfs 2>/dev/null || true
+    rm -f /dev/mapper/dynpart-system_a
+    for file in "$tmp"/*.img "$tmp"/*.part; do
+        for loop in $(losetup -n -O NAME -j "$file"); do
+            losetup -d "$loop" || true
+        done
+    done
+    for dir in $created_dirs; do
+        rmdir "$dir" 2>/dev/null || true
+    done
+    rm -rf "$tmp"
+}
+trap cleanup EXIT
+
+# Userdata image with the zero blocks spread evenly. The same random block is
+# repeated since gzip can't see across 1 MiB anyway.
+head -c 1M /dev/urandom > "$tmp/random.bin"
+truncate -s "${size}M" "$tmp/userdata.img"
+i=0
+while [ "$i" -lt "$size" ]; do
+    if [ $(((i + 1) * zero_pct / 100)) -eq $((i * zero_pct / 100)) ]; then
+        dd if="$tmp/random.bin" of="$tmp/userdata.img" bs=1M seek="$i" conv=notrunc status=none
+    fi
+    i=$((i + 1))
+done
+
+head -c 32M /dev/urandom > "$tmp/boot.img"
+head -c 8M /dev/urandom > "$tmp/dtbo.img"
+mkdir "$tmp/system" "$tmp/rootfs" "$tmp/rootfs/boot"
+if $rootfs_fallback; then
+    cp "$tmp/boot.img" "$tmp/rootfs/boot/boot.img"
+    cp "$tmp/dtbo.img" "$tmp/rootfs/boot/dtbo.img"
+else
+    cp "$tmp/boot.img" "$tmp/dtbo.img" "$tmp/system/"
+fi
+mkfs.ext4 -q -d "$tmp/rootfs" "$tmp/rootfs.img" "${rootfs_mib}M" > /dev/null
+
+truncate -s "${size}M" "$tmp/userdata.part"
+if $rootfs_in_userdata; then
+    # The restored image brings the current rootfs, the partition holds an outdated one until then
+    dd if="$tmp/rootfs.img" of="$tmp/userdata.img" bs=1M seek="$rootfs_offset_mib" conv=notrunc status=none
+    mkdir "$tmp/old-rootfs" "$tmp/old-rootfs/boot"
+    head -c 32M /dev/urandom > "$tmp/old-rootfs/boot/boot.img"
+    head -c 8M /dev/urandom > "$tmp/old-rootfs/boot/dtbo.img"
+    mkfs.ext4 -q -d "$tmp/old-rootfs" "$tmp/old-rootfs.img" "${rootfs_mib}M" > /dev/null
+    dd if="$tmp/old-rootfs.img" of="$tmp/userdata.part" bs=1M seek="$rootfs_offset_mib" conv=notrunc status=none
+fi
+
+if $indexed; then
+    "$here/../make-userdata-archive.sh" "$tmp/userdata.img" "$tmp/system/userdata.img.tar.gz"
+else
+    tar -cf - -C "$tmp" userdata.img | gzip -1 > "$tmp/system/userdata.img.tar.gz"
+fi
+
+archive_mib=$(( $(du -sm "$tmp/system" | cut -f 1) + 64 ))
+mkfs.ext4 -q -d "$tmp/system" "$tmp/system.img" "${archive_mib}M" > /dev/null
+"$here/make-super.py" "$tmp/system.img" "$tmp/super.img"
+rm "$tmp/system.img"
+
+truncate -s 64M "$tmp/boot.part" "$tmp/dtbo.part"
+
+super_loop="$(losetup -f --show "$tmp/super.img")"
+userdata_loop="$(losetup -f --show "$tmp/userdata.part")"
+boot_loop="$(losetup -f --show "$tmp/boot.part")"
+dtbo_loop="$(losetup -f --show "$tmp/dtbo.part")"
+if $rootfs_in_userdata; then
+    dmsetup create droidian-droidian--rootfs \
+        --table "0 $((rootfs_mib * 2048)) linear $userdata_loop $((rootfs_offset_mib * 2048))"
+else
+    rootfs_loop="$(losetup -f --show "$tmp/rootfs.img")"
+    dmsetup create droidian-droidian--rootfs --table "0 $(blockdev --getsz "$rootfs_loop") linear $rootfs_loop 0"
+fi
+
+for dir in /dev/disk /dev/disk/by-partlabel /system_mnt /rootfs_mnt; do
+    if [ ! -d "$dir" ]; then
+        mkdir "$dir"
+        created_dirs="$dir $created_dirs"
+    fi
+done
+
+echo "bench size_mib=$size zero_pct=$zero_pct indexed=$indexed rootfs_fallback=$rootfs_fallback rootfs_in_userdata=$rootfs_in_userdata"
+
+# Only this process sees the fake partition labels
+unshare --mount --propagation private sh -e -c '
+    mount -t tmpfs tmpfs /dev/disk/by-partlabel
+    ln -s "$2" /dev/disk/by-partlabel/super
+    ln -s "$3" /dev/disk/by-partlabel/userdata
+    ln -s "$4" /dev/disk/by-partlabel/boot
+    ln -s "$5" /dev/disk/by-partlabel/dtbo
+    exec "$1" "$(basename "$3")" "$(basename "$4")" "$(basename "$5")"
+' sh "$bench" "$super_loop" "$userdata_loop" "$boot_loop" "$dtbo_loop"
+
+if ! cmp -s "$tmp/userdata.img" "$userdata_loop"; then
+    echo "Restored userdata doesn't match the image" >&2
+    exit 1
+fi
+
+# Catches images flashed from a rootfs that was read before userdata was restored
+for pair in "boot.img:$boot_loop" "dtbo.img:$dtbo_loop"; do
+    image="$tmp/${pair%%:*}"
+    if ! cmp -s -n "$(stat -c %s "$image")" "$image" "${pair#*:}"; then
+        echo "Flashed ${pair%%:*} doesn't match the image" >&2
+        exit 1
+    fi
+done
@@ -57,12 +57,20 @@ static void init_opts(cli_opts *opts) {
         exit(EXIT_FAILURE);
     }
     opts->config_files[0] = "/etc/furios-recovery.conf";
+    opts->config_snapshot = "/etc/furios-recovery.snapshot";
+    opts->compile_config = false;
 
     opts->hor_res = -1;
     opts->ver_res = -1;
     opts->x_offset = 0;
     opts->y_offset = 0;
     opts->verbose = false;
+    opts->log_kmsg = false;
+    opts->log_file = "/run/furios-recovery.log";
+    opts->profile = false;
+    opts->profile_file = NULL;
+    opts->profile_overlay = false;
+    opts->exit_after_first_frame = false;
 }
 
 static void print_usage() {
@@ -77,11 +85,30 @@ static void print_usage() {
         "                            the main config file. If specified multiple\n"
         "                            times, the values from consecutive files will be\n"
         "                            merged in order.\n"
+        "  -s, --config-snapshot=PATH\n"
+        "                            Location of the precompiled config snapshot,\n"
+        "                            used instead of the config files unless they\n"
+        "                            changed since. Defaults to\n"
+        "                            /etc/furios-recovery.snapshot.\n"
+        "  -S, --compile-config      Merge the config files into the config snapshot\n"
+        "                            and exit\n"
         "  -g, --geometry=NxM[@X,Y]  Force a display size of N horizontal times M\n"
         "                            vertical pixels, offset horizontally by X\n"
         "                            pixels and vertically by Y pixels\n"
         "  -d  --dpi=N               Override the display's DPI value\n"
         "  -h, --help                Print this message and exit\n"
+        "  -v, --verbose             Enable more detailed logging output on STDERR\n"
+        "  -k, --kmsg                Log to the kernel log instead of STDERR\n"
+        "  -l, --log-file=PATH       Keep the last 64 KiB of the log in PATH and\n"
+        "                            PATH.old. Defaults to /run/furios-recovery.log,\n"
+        "                            an empty PATH disables it.\n"
+        "  -p, --profile[=PATH]      Record render, flush, input and latency\n"
+        "                            timings and print their percentiles to STDERR\n"
+        "                            or PATH on exit\n"
+        "  -P, --profile-overlay     Like --profile, and show live timings on screen\n"
+        "  -x, --exit-after-first-frame\n"
+        "                            Print the startup trace and exit as soon as the\n"
+        "                            first frame is on screen\n"
         "  -V, --version             Print the furios-recovery version and exit\n");
         /*-------------------------------- 78 CHARS --------------------------------*/
 }
@@ -97,16 +124,24 @@ void cli_parse_opts(int argc, char *argv[], cli_opts *opts) {
     struct option long_opts[] = {
         { "config",          required_argument, NULL, 'c' },
         { "config-override", required_argument, NULL, 'C' },
+        { "config-snapshot", required_argument, NULL, 's' },
+        { "compile-config",  no_argument,       NULL, 'S' },
         { "geometry",        required_argument, NULL, 'g' },
         { "dpi",             required_argument, NULL, 'd' },
         { "help",            no_argument,       NULL, 'h' },
+        { "verbose",         no_argument,       NULL, 'v' },
+        { "kmsg",            no_argument,       NULL, 'k' },
+        { "log-file",        required_argument, NULL, 'l' },
+        { "profile",         optional_argument, NULL, 'p' },
+        { "profile-overlay", no_argument,       NULL, 'P' },
+        { "exit-after-first-frame", no_argument, NULL, 'x' },
         { "version",         no_argument,       NULL, 'V' },
         { NULL, 0, NULL, 0 }
     };
 
     int opt, index = 0;
 
-    while ((opt = getopt_long(argc, argv, "c:C:g:d:hvV", long_opts, &index)) != -1) {
+    while ((opt = getopt_long(argc, argv, "c:C:s:Sg:d:hvkl:p::PxV", long_opts, &index)) != -1) {
         switch (opt) {
         case 'c':
             opts->config_files[0] = optarg;
@@ -120,6 +155,12 @@ void cli_parse_opts(int argc, char *argv[], cli_opts *opts) {
             opts->config_files[opts->num_config_files] = optarg;
             opts->num_config_files++;
             break;
+        case 's':
+            opts->config_snapshot = optarg;
+            break;
+        case 'S':
+            opts->compile_config = true;
+            break;
         case 'g':
             if (sscanf(optarg, "%ix%i@%i,%i", &(opts->hor_res), &(opts->ver_res), &(opts->x_offset), &(opts->y_offset)) != 4) {
                 if (sscanf(optarg, "%ix%i", &(opts->hor_res), &(opts->ver_res)) != 2) {
@@ -137,6 +178,26 @@ void cli_parse_opts(int argc, char *argv[], cli_opts *opts) {
         case 'h':
             print_usage();
             exit(EXIT_SUCCESS);
+        case 'v':
+            opts->verbose = true;
+            break;
+        case 'k':
+            opts->log_kmsg = true;
+            break;
+        case 'l':
+            opts->log_file = optarg[0] != '\0' ? optarg : NULL;
+            break;
+        case 'p':
+            opts->profile = true;
+            opts->profile_file = optarg;
+            break;
+        case 'P':
+            opts->profile = true;
+            opts->profile_overlay = true;
+            break;
+        case 'x':
+            opts->exit_after_first_frame = true;
+            break;
         case 'V':
             fprintf(stderr, "furios-recovery %s\n", VERSION);
             exit(0);
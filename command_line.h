@@ -31,6 +31,10 @@ typedef struct {
     int num_config_files;
     /* Paths of config file */
     const char **config_files;
+    /* Path of the precompiled config snapshot */
+    const char *config_snapshot;
+    /* If true, compile the config files into the snapshot and exit */
+    bool compile_config;
     /* Horizontal display resolution */
     int hor_res;
     /* Vertical display resolution */
@@ -43,6 +47,18 @@ typedef struct {
     int dpi;
     /* Verbose mode. If true, provide more detailed logging output on STDERR. */
     bool verbose;
+    /* If true, log to the kernel log instead of STDERR */
+    bool log_kmsg;
+    /* File to keep the tail of the log in, NULL to not keep one */
+    const char *log_file;
+    /* If true, record frame timings and summarise them on exit */
+    bool profile;
+    /* File to write the timing summary to, NULL for STDERR */
+    const char *profile_file;
+    /* If true, show live timings on screen */
+    bool profile_overlay;
+    /* If true, print the startup trace and exit once the first frame was flushed */
+    bool exit_after_first_frame;
 } cli_opts;
 
 /**
@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+# Copyright 2026 FuriLabs
+# SPDX-License-Identifier: GPL-3.0-or-later
+#
+# Generate keyboard_layers.c and keyboard_layers.h from the layouts that
+# squeek2lvgl wrote to sq2lv_layouts.c. Every layer gets a bitset of its
+# layer switching buttons and a table of the layer each button switches to,
+# so handling a key press is a bit test instead of a scan of the switchers.
+#
+# Usage: ./compact-layouts.py [LAYOUTS.c] [OUTPUT_DIR]
+
+import os
+import re
+import sys
+
+# Keyboard modes available for layers in LVGL, assigned in enum order
+MAX_LAYERS = 8
+# Marks buttons that don't switch layers
+NONE = -1
+# Bits in a layer's switcher bitset
+MAX_BUTTONS = 64
+
+LAYOUTS_ARRAY = re.compile(r'const sq2lv_layout_t sq2lv_layouts\[\] = \{(.*?)\n\};', re.S)
+LAYERS_ARRAY = r'static const sq2lv_layer_t {}\[\] = \{{(.*?)\n\}};'
+FIELD = r'\.{} = (\w+)'
+INT_CONSTANT = r'static const int {} = (\d+);'
+INT_ARRAY = r'static const int {}\[\] = \{{(.*?)\}};'
+
+
+def int_constant(source, name):
+    return int(re.search(INT_CONSTANT.format(re.escape(name)), source).group(1))
+
+
+def int_array(source, name, length):
+    if length == 0:
+        return []
+    body = re.search(INT_ARRAY.format(re.escape(name)), source, re.S).group(1)
+    values = [int(v) for v in re.findall(r'-?\d+', body)]
+    if len(values) != length:
+        sys.exit(f'{name} has {len(values)} entries, expected {length}')
+    return values
+
+
+def parse(source):
+    layouts = []
+    for layers_name in re.findall(FIELD.format('layers'), LAYOUTS_ARRAY.search(source).group(1)):
+        body = re.search(LAYERS_ARRAY.format(re.escape(layers_name)), source, re.S).group(1)
+        fields = lambda field: re.findall(FIELD.format(field), body)
+
+        layers = []
+        for num_keys, num_switchers, idxs, dests in zip(fields('num_keys'), fields('num_switchers'),
+                                                        fields('switcher_idxs'), fields('switcher_dests')):
+            n = int_constant(source, num_switchers)
+            layers.append((int_constant(source, num_keys), zip(int_array(source, idxs, n), int_array(source, dests, n))))
+        layouts.append((layers_name, layers))
+    return layouts
+
+
+def main():
+    args = sys.argv[1:]
+    layouts_path = args[0] if args else 'sq2lv_layouts.c'
+    output_dir = args[1] if len(args) > 1 else '.'
+
+    with open(layouts_path) as f:
+        layouts = parse(f.read())
+
+    max_layers = max(len(layers) for _, layers in layouts)
+    max_buttons = max(num_keys for _, layers in layouts for num_keys, _ in layers)
+    if max_layers > MAX_LAYERS:
+        sys.exit(f'Layouts have up to {max_layers} layers, LVGL keyboards only have {MAX_LAYERS} modes')
+    if max_buttons > MAX_BUTTONS:
+        sys.exit(f'Layers have up to {max_buttons} buttons, switcher bitsets only have {MAX_BUTTONS} bits')
+
+    switcher_rows = []
+    target_rows = []
+    for name, layers in layouts:
+        switcher_rows.append(f'    /* {name} */\n    {{')
+        target_rows.append(f'    /* {name} */\n    {{')
+        for i in range(max_layers):
+            bits = 0
+            targets = [NONE] * max_buttons
+            if i < len(layers):
+                for idx, dest in layers[i][1]:
+                    bits |= 1 << idx
+                    targets[idx] = dest
+            switcher_rows.append(f'        0x{bits:016x}u,')
+            target_rows.append('        { ' + ', '.join(str(t) for t in targets) + ' },')
+        switcher_rows.append('    },')
+        target_rows.append('    },')
+
+    header = '/**\n * Auto-generated with compact-layouts.py\n **/\n\n'
+
+    with open(os.path.join(output_dir, 'keyboard_layers.h'), 'w') as f:
+        f.write(header)
+        f.write('#ifndef KEYBOARD_LAYERS_H\n#define KEYBOARD_LAYERS_H\n\n#include <stdint.h>\n\n')
+        f.write(f'/* Number of layouts, same order as sq2lv_layouts */\n#define KEYBOARD_LAYERS_NUM_LAYOUTS {len(layouts)}\n')
+        f.write(f'/* Largest number of layers of any layout */\n#define KEYBOARD_LAYERS_MAX_LAYERS {max_layers}\n')
+        f.write(f'/* Largest number of buttons of any layer */\n#define KEYBOARD_LAYERS_MAX_BUTTONS {max_buttons}\n')
+        f.write(f'/* Marks buttons that don\'t switch layers */\n#define KEYBOARD_LAYERS_NONE ({NONE})\n\n')
+        f.write('/* Bitset of the layer switching buttons, indexed by layout and layer, bit N is button ID N */\n')
+        f.write('extern const uint64_t keyboard_layers_switchers[KEYBOARD_LAYERS_NUM_LAYOUTS][KEYBOARD_LAYERS_MAX_LAYERS];\n\n')
+        f.write('/* Layer each button switches to, indexed by layout, layer and button ID */\n')
+        f.write('extern const int8_t keyboard_layers_targets[KEYBOARD_LAYERS_NUM_LAYOUTS][KEYBOARD_LAYERS_MAX_LAYERS][KEYBOARD_LAYERS_MAX_BUTTONS];\n\n')
+        f.write('#endif /* KEYBOARD_LAYERS_H */\n')
+
+    with open(os.path.join(output_dir, 'keyboard_layers.c'), 'w') as f:
+        f.write(header)
+        f.write('#include "keyboard_layers.h"\n\n')
+        f.write('const uint64_t keyboard_layers_switchers[KEYBOARD_LAYERS_NUM_LAYOUTS][KEYBOARD_LAYERS_MAX_LAYERS] = {\n')
+        f.write('\n'.join(switcher_rows) + '\n};\n\n')
+        f.write('const int8_t keyboard_layers_targets[KEYBOARD_LAYERS_NUM_LAYOUTS][KEYBOARD_LAYERS_MAX_LAYERS][KEYBOARD_LAYERS_MAX_BUTTONS] = {\n')
+        f.write('\n'.join(target_rows) + '\n};\n')
+
+
+if __name__ == '__main__':
+    main()
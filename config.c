@@ -20,14 +20,75 @@
 
 #include "config.h"
 
+#include "furios-recovery.h"
+#include "log.h"
+
 #include "lvgl/lvgl.h"
 
+#include <errno.h>
+#include <fcntl.h>
 #include <ini.h>
+#include <limits.h>
+#include <stddef.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
 
 #include "squeek2lvgl/sq2lv.h"
 
 
+/**
+ * Defines
+ */
+
+/* Identifies snapshot files, "FRCS" */
+#define CONFIG_SNAPSHOT_MAGIC 0x53435246
+/* Bump when the snapshot layout changes */
+#define CONFIG_SNAPSHOT_VERSION 2
+/* Maximum number of configuration files in a snapshot */
+#define CONFIG_SNAPSHOT_MAX_FILES 16
+/* Maximum length of a configuration file path including the terminator */
+#define CONFIG_SNAPSHOT_MAX_PATH 256
+/* Maximum length of the bullet including the terminator */
+#define CONFIG_SNAPSHOT_MAX_BULLET 32
+
+
+/**
+ * Static types
+ */
+
+/* Configuration file a snapshot was compiled from */
+typedef struct {
+    char path[CONFIG_SNAPSHOT_MAX_PATH];
+    /* Size in bytes or -1 if the file didn't exist or couldn't be read */
+    int64_t size;
+    /* CRC32 of the contents, timestamps don't survive packing the initramfs */
+    uint32_t crc;
+    uint32_t reserved;
+} snapshot_source;
+
+/* Snapshot file contents */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    /* Size of config_opts in the build that wrote the snapshot */
+    uint32_t opts_size;
+    /* Version of the build that wrote the snapshot, enum values may change between versions */
+    char build[32];
+    uint32_t num_sources;
+    snapshot_source sources[CONFIG_SNAPSHOT_MAX_FILES];
+    /* Merged options, the bullet pointer is replaced with bullet */
+    config_opts opts;
+    char bullet[CONFIG_SNAPSHOT_MAX_BULLET];
+    /* CRC32 of everything above */
+    uint32_t crc;
+} snapshot;
+
+
 /**
  * Static prototypes
  */
@@ -67,6 +128,45 @@ static int parsing_handler(void* user_data, const char* section, const char* key
  */
 static bool parse_bool(const char *value, bool *result);
 
+/**
+ * Record the current size and contents checksum of a configuration file.
+ *
+ * @param path path to the configuration file
+ * @param source pointer for writing the record into
+ * @return true on success, false if the path is too long
+ */
+static bool record_source(const char *path, snapshot_source *source);
+
+/**
+ * Count the entries of a NULL terminated list of names.
+ *
+ * @param names the list
+ * @return number of entries
+ */
+static int count_names(const char **names);
+
+/**
+ * Check whether a snapshot is intact, belongs to this build, holds valid options and was compiled
+ * from the current versions of the given configuration files.
+ *
+ * @param snap the snapshot
+ * @param files paths to configuration files
+ * @param num_files number of configuration files
+ * @return true if the snapshot can be used, false otherwise
+ */
+static bool is_snapshot_valid(const snapshot *snap, const char **files, int num_files);
+
+/**
+ * Map a snapshot and copy its options out.
+ *
+ * @param snapshot_path path to the snapshot
+ * @param files paths to configuration files
+ * @param num_files number of configuration files
+ * @param opts pointer for writing the options into
+ * @return true if the options were loaded, false otherwise
+ */
+static bool load_snapshot(const char *snapshot_path, const char **files, int num_files, config_opts *opts);
+
 
 /**
  * Static functions
@@ -76,6 +176,10 @@ static void init_opts(config_opts *opts) {
     opts->general.animations = false;
     opts->general.backend = backends_backends[0] == NULL ? BACKENDS_BACKEND_NONE : 0;
     opts->general.timeout = 0;
+    opts->general.dim_timeout = 0;
+    opts->general.blank_timeout = 0;
+    opts->general.render_mode = RENDER_MODE_SINGLE;
+    opts->general.glyph_cache = 0;
     opts->keyboard.autohide = true;
     opts->keyboard.layout_id = SQ2LV_LAYOUT_US;
     opts->keyboard.popovers = false;
@@ -86,11 +190,12 @@ static void init_opts(config_opts *opts) {
     opts->input.keyboard = true;
     opts->input.pointer = true;
     opts->input.touchscreen = true;
+    opts->input.low_latency = false;
 }
 
 static void parse_file(const char *path, config_opts *opts) {
     if (ini_parse(path, parsing_handler, opts) != 0) {
-        printf("Ignoring invalid config file %s\n", path);
+        log_warning("Ignoring invalid config file %s", path);
     }
 }
 
@@ -112,6 +217,22 @@ static int parsing_handler(void* user_data, const char* section, const char* key
             /* Use a max ceiling of 60 minutes (3600 secs) */
             opts->general.timeout = (uint16_t)LV_MIN(strtoul(value, (char **)NULL, 10), 3600);
             return 1;
+        } else if (strcmp(key, "dim_timeout") == 0) {
+            opts->general.dim_timeout = (uint16_t)LV_MIN(strtoul(value, (char **)NULL, 10), 3600);
+            return 1;
+        } else if (strcmp(key, "blank_timeout") == 0) {
+            opts->general.blank_timeout = (uint16_t)LV_MIN(strtoul(value, (char **)NULL, 10), 3600);
+            return 1;
+        } else if (strcmp(key, "render") == 0) {
+            render_mode_id_t id = render_find_mode_with_name(value);
+            if (id != RENDER_MODE_NONE) {
+                opts->general.render_mode = id;
+                return 1;
+            }
+        } else if (strcmp(key, "glyph_cache") == 0) {
+            /* More entries than glyphs in the font only waste memory */
+            opts->general.glyph_cache = (uint16_t)LV_MIN(strtoul(value, (char **)NULL, 10), 4096);
+            return 1;
         }
     } else if (strcmp(section, "keyboard") == 0) {
         if (strcmp(key, "autohide") == 0) {
@@ -168,10 +289,14 @@ static int parsing_handler(void* user_data, const char* section, const char* key
             if (parse_bool(value, &(opts->input.touchscreen))) {
                 return 1;
             }
+        } else if (strcmp(key, "low_latency") == 0) {
+            if (parse_bool(value, &(opts->input.low_latency))) {
+                return 1;
+            }
         }
     }
 
-    printf("Ignoring invalid config value \"%s\" for key \"%s\" in section \"%s\"\n", value, key, section);
+    log_warning("Ignoring invalid config value \"%s\" for key \"%s\" in section \"%s\"", value, key, section);
     return 1; /* Return 1 (true) so that we can use the return value of ini_parse exclusively for file-level errors (e.g. file not found) */
 }
 
@@ -189,6 +314,116 @@ static bool parse_bool(const char *value, bool *result) {
     return false;
 }
 
+static bool record_source(const char *path, snapshot_source *source) {
+    memset(source, 0, sizeof(snapshot_source));
+    if (strlen(path) >= sizeof(source->path)) {
+        return false;
+    }
+    strcpy(source->path, path);
+
+    source->size = -1;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return true;
+    }
+
+    unsigned char buf[4096];
+    int64_t size = 0;
+    uLong crc = crc32(0, Z_NULL, 0);
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+        crc = crc32(crc, buf, (uInt)n);
+        size += n;
+    }
+    close(fd);
+
+    if (n == 0) {
+        source->size = size;
+        source->crc = (uint32_t)crc;
+    }
+    return true;
+}
+
+static int count_names(const char **names) {
+    int count = 0;
+    while (names[count] != NULL) {
+        ++count;
+    }
+    return count;
+}
+
+static bool is_snapshot_valid(const snapshot *snap, const char **files, int num_files) {
+    if (snap->magic != CONFIG_SNAPSHOT_MAGIC || snap->version != CONFIG_SNAPSHOT_VERSION
+            || snap->opts_size != sizeof(config_opts) || strncmp(snap->build, VERSION, sizeof(snap->build)) != 0) {
+        log_warning("Ignoring config snapshot from another build");
+        return false;
+    }
+
+    if (snap->crc != crc32(0, (const Bytef *)snap, offsetof(snapshot, crc))) {
+        log_warning("Ignoring corrupt config snapshot");
+        return false;
+    }
+
+    const config_opts *o = &snap->opts;
+    if ((o->general.backend != BACKENDS_BACKEND_NONE && (o->general.backend < 0 || o->general.backend >= count_names(backends_backends)))
+            || o->general.render_mode < 0 || o->general.render_mode >= count_names(render_modes)
+            || o->keyboard.layout_id < 0 || o->keyboard.layout_id >= sq2lv_num_layouts
+            || o->theme.default_id < 0 || o->theme.default_id >= themes_num_themes
+            || o->theme.alternate_id < 0 || o->theme.alternate_id >= themes_num_themes
+            || memchr(snap->bullet, '\0', sizeof(snap->bullet)) == NULL) {
+        log_warning("Ignoring config snapshot with invalid values");
+        return false;
+    }
+
+    if (snap->num_sources != (uint32_t)num_files) {
+        log_warning("Ignoring config snapshot of other config files");
+        return false;
+    }
+
+    for (int i = 0; i < num_files; ++i) {
+        snapshot_source current;
+        if (!record_source(files[i], &current) || memcmp(&current, &snap->sources[i], sizeof(snapshot_source)) != 0) {
+            log_warning("Ignoring config snapshot, %s changed since it was compiled", files[i]);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool load_snapshot(const char *snapshot_path, const char **files, int num_files, config_opts *opts) {
+    int fd = open(snapshot_path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size != sizeof(snapshot)) {
+        log_warning("Ignoring config snapshot %s of unexpected size", snapshot_path);
+        close(fd);
+        return false;
+    }
+
+    const snapshot *snap = mmap(NULL, sizeof(snapshot), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (snap == MAP_FAILED) {
+        log_error("Could not map config snapshot: %s", strerror(errno));
+        return false;
+    }
+
+    bool is_valid = is_snapshot_valid(snap, files, num_files);
+    if (is_valid) {
+        *opts = snap->opts;
+        opts->textarea.bullet = strdup(snap->bullet);
+        if (opts->textarea.bullet == NULL) {
+            opts->textarea.bullet = LV_SYMBOL_BULLET;
+        }
+    }
+
+    munmap((void *)snap, sizeof(snapshot));
+    return is_valid;
+}
+
 
 /**
  * Public functions
@@ -200,3 +435,80 @@ void config_parse(const char **files, int num_files, config_opts *opts) {
         parse_file(files[i], opts);
     }
 }
+
+void config_load(const char *snapshot_path, const char **files, int num_files, config_opts *opts) {
+    if (!load_snapshot(snapshot_path, files, num_files, opts)) {
+        config_parse(files, num_files, opts);
+    }
+}
+
+bool config_compile(const char *snapshot_path, const char **files, int num_files) {
+    if (num_files > CONFIG_SNAPSHOT_MAX_FILES) {
+        log_error("Cannot compile more than %d config files", CONFIG_SNAPSHOT_MAX_FILES);
+        return false;
+    }
+
+    snapshot *snap = calloc(1, sizeof(snapshot));
+    if (snap == NULL) {
+        log_error("Could not allocate config snapshot");
+        return false;
+    }
+
+    snap->magic = CONFIG_SNAPSHOT_MAGIC;
+    snap->version = CONFIG_SNAPSHOT_VERSION;
+    snap->opts_size = sizeof(config_opts);
+    strncpy(snap->build, VERSION, sizeof(snap->build) - 1);
+    snap->num_sources = num_files;
+
+    /* Record the files before parsing them so that edits made in between make the snapshot stale */
+    for (int i = 0; i < num_files; ++i) {
+        if (!record_source(files[i], &snap->sources[i])) {
+            log_error("Config file path %s is too long for a snapshot", files[i]);
+            free(snap);
+            return false;
+        }
+    }
+
+    config_parse(files, num_files, &snap->opts);
+    if (strlen(snap->opts.textarea.bullet) >= sizeof(snap->bullet)) {
+        log_error("Bullet \"%s\" is too long for a snapshot", snap->opts.textarea.bullet);
+        free(snap);
+        return false;
+    }
+    strcpy(snap->bullet, snap->opts.textarea.bullet);
+    snap->opts.textarea.bullet = NULL;
+    snap->crc = crc32(0, (const Bytef *)snap, offsetof(snapshot, crc));
+
+    /* Write next to the target and rename so that a concurrent load never sees a partial file */
+    char tmp_path[PATH_MAX];
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", snapshot_path) >= (int)sizeof(tmp_path)) {
+        log_error("Config snapshot path %s is too long", snapshot_path);
+        free(snap);
+        return false;
+    }
+
+    bool is_written = false;
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        log_error("Could not create config snapshot: %s", strerror(errno));
+    } else {
+        is_written = write(fd, snap, sizeof(snapshot)) == (ssize_t)sizeof(snapshot) && fsync(fd) == 0;
+        if (!is_written) {
+            log_error("Could not write config snapshot: %s", strerror(errno));
+        }
+        close(fd);
+    }
+    free(snap);
+
+    if (is_written && rename(tmp_path, snapshot_path) != 0) {
+        log_error("Could not move config snapshot into place: %s", strerror(errno));
+        is_written = false;
+    }
+    if (!is_written) {
+        unlink(tmp_path);
+        return false;
+    }
+
+    log_info("Compiled %d config file(s) into %s", num_files, snapshot_path);
+    return true;
+}
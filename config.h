@@ -23,6 +23,8 @@
 
 #include "backends.h"
 
+#include "render.h"
+
 #include "themes.h"
 
 #include "sq2lv_layouts.h"
@@ -40,6 +42,14 @@ typedef struct {
     bool animations;
     /* Timeout (in seconds) - once elapsed, the device will shutdown. 0 (default) to disable */
     uint16_t timeout;
+    /* Seconds without input until the backlight is dimmed. 0 (default) to disable */
+    uint16_t dim_timeout;
+    /* Seconds without input until the backlight is turned off and drawing stops. 0 (default) to disable */
+    uint16_t blank_timeout;
+    /* Draw buffer setup */
+    render_mode_id_t render_mode;
+    /* Number of glyphs to keep in the glyph cache. 0 (default) to disable */
+    uint16_t glyph_cache;
 } config_opts_general;
 
 /**
@@ -84,6 +94,8 @@ typedef struct {
     bool pointer;
     /* If true and a touchscreen device is connected, use it for input */
     bool touchscreen;
+    /* If true, draw presses and releases right away instead of on the next refresh period */
+    bool low_latency;
 } config_opts_input;
 
 /**
@@ -111,4 +123,26 @@ typedef struct {
  */
 void config_parse(const char **files, int num_files, config_opts *opts);
 
+/**
+ * Load options from a snapshot written by config_compile. If the snapshot is missing, invalid or
+ * was compiled from other files or older versions of them, parse the configuration files instead.
+ *
+ * @param snapshot_path path to the snapshot
+ * @param files paths to configuration files
+ * @param num_files number of configuration files
+ * @param opts pointer for writing the options into
+ */
+void config_load(const char *snapshot_path, const char **files, int num_files, config_opts *opts);
+
+/**
+ * Parse options from one or more configuration files and write the merged result into a
+ * snapshot for config_load.
+ *
+ * @param snapshot_path path to write the snapshot to
+ * @param files paths to configuration files
+ * @param num_files number of configuration files
+ * @return true on success, false otherwise
+ */
+bool config_compile(const char *snapshot_path, const char **files, int num_files);
+
 #endif /* CONFIG_H */
@@ -0,0 +1,186 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "deferred.h"
+
+#include "log.h"
+
+#include "lvgl/lvgl.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+
+/**
+ * Static variables
+ */
+
+static const char *pending_text = NULL;
+static deferred_action_cb pending_action = NULL;
+static int seconds_left = 0;
+static lv_obj_t *mbox = NULL;
+static lv_timer_t *countdown_timer = NULL;
+
+
+/**
+ * Static prototypes
+ */
+
+/**
+ * Flush all filesystems on a background thread.
+ */
+static void start_background_sync(void);
+
+/**
+ * Background sync thread main function.
+ *
+ * @param arg unused
+ * @return NULL
+ */
+static void *sync_thread(void *arg);
+
+/**
+ * Show the remaining time in the message box.
+ */
+static void update_text(void);
+
+/**
+ * Close the message box and forget the pending action.
+ */
+static void clear(void);
+
+/**
+ * Run the pending action.
+ */
+static void run(void);
+
+/**
+ * Count down one second and run the action when the countdown ends.
+ *
+ * @param timer the countdown timer
+ */
+static void countdown_timer_cb(lv_timer_t *timer);
+
+/**
+ * Handle LV_EVENT_VALUE_CHANGED events from the message box.
+ *
+ * @param event the event object
+ */
+static void mbox_value_changed_cb(lv_event_t *event);
+
+
+/**
+ * Static functions
+ */
+
+static void start_background_sync(void) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, sync_thread, NULL) != 0) {
+        log_error("pthread_create: %s", strerror(errno));
+        return;
+    }
+    pthread_detach(thread);
+}
+
+static void *sync_thread(void *arg) {
+    LV_UNUSED(arg);
+    sync();
+    return NULL;
+}
+
+static void update_text(void) {
+    lv_label_set_text_fmt(lv_msgbox_get_text(mbox), "%s in %d s", pending_text, seconds_left);
+}
+
+static void clear(void) {
+    if (countdown_timer != NULL) {
+        lv_timer_del(countdown_timer);
+        countdown_timer = NULL;
+    }
+    if (mbox != NULL) {
+        lv_msgbox_close(mbox);
+        mbox = NULL;
+    }
+    pending_action = NULL;
+    pending_text = NULL;
+}
+
+static void run(void) {
+    deferred_action_cb action = pending_action;
+    clear();
+    if (action != NULL) {
+        action();
+    }
+}
+
+static void countdown_timer_cb(lv_timer_t *timer) {
+    LV_UNUSED(timer);
+
+    if (--seconds_left > 0) {
+        update_text();
+        return;
+    }
+    run();
+}
+
+static void mbox_value_changed_cb(lv_event_t *event) {
+    LV_UNUSED(event);
+
+    /* Both buttons close the message box from its own event, which lv_msgbox_close allows */
+    if (lv_msgbox_get_active_btn(mbox) == 0) {
+        run();
+    } else {
+        deferred_action_cancel();
+    }
+}
+
+
+/**
+ * Public functions
+ */
+
+void deferred_action_schedule(const char *text, int seconds, bool can_cancel, deferred_action_cb action) {
+    static const char *btns[] = { "Now", "Cancel", "" };
+    static const char *btns_no_cancel[] = { "Now", "" };
+
+    clear();
+    start_background_sync();
+
+    pending_text = text;
+    pending_action = action;
+    seconds_left = seconds > 0 ? seconds : 1;
+
+    mbox = lv_msgbox_create(NULL, NULL, "", can_cancel ? btns : btns_no_cancel, false);
+    lv_obj_set_size(mbox, 400, LV_SIZE_CONTENT);
+    lv_obj_add_event_cb(mbox, mbox_value_changed_cb, LV_EVENT_VALUE_CHANGED, NULL);
+    lv_obj_center(mbox);
+    update_text();
+
+    countdown_timer = lv_timer_create(countdown_timer_cb, 1000, NULL);
+}
+
+void deferred_action_cancel(void) {
+    if (pending_action != NULL) {
+        log_info("Cancelled: %s", pending_text);
+    }
+    clear();
+}
@@ -0,0 +1,48 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef DEFERRED_H
+#define DEFERRED_H
+
+#include <stdbool.h>
+
+/**
+ * Action run once the countdown of a deferred action ends.
+ */
+typedef void (*deferred_action_cb)(void);
+
+/**
+ * Show a message box counting down to an action, which the user can run right away and, if
+ * allowed, cancel. A background sync() is started immediately, so the action doesn't have to wait
+ * for the disks. An action that is already pending is cancelled.
+ *
+ * @param text description of the action, shown as "TEXT in N s"
+ * @param seconds length of the countdown
+ * @param can_cancel true to offer a cancel button
+ * @param action the action
+ */
+void deferred_action_schedule(const char *text, int seconds, bool can_cancel, deferred_action_cb action);
+
+/**
+ * Cancel the pending action, if any, and close its message box.
+ */
+void deferred_action_cancel(void);
+
+#endif /* DEFERRED_H */
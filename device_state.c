@@ -0,0 +1,263 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "device_state.h"
+
+#include "event_loop.h"
+#include "log.h"
+#include "lvm.h"
+
+#include "lvgl/lvgl.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/inotify.h>
+#include <sys/stat.h>
+
+/**
+ * Defines
+ */
+
+#define CMDLINE_PATH "/proc/cmdline"
+#define SLOT_SUFFIX_ARG "androidboot.slot_suffix="
+/* Device-mapper devices, including the LVs and the unlocked LUKS device, show up here */
+#define MAPPER_PATH "/dev/mapper"
+/* LV holding the LUKS header, see lvm.c */
+#define LVM_HEADER_PATH "/dev/droidian/droidian-reserved"
+#define LVM_HEADER_BYTES 64
+#define ROOTFS_LV_PATH "/dev/mapper/droidian-droidian--rootfs"
+
+
+/**
+ * Static types
+ */
+
+/* Cached answers of the probes */
+typedef struct {
+    /* Result of is_lv_encrypted_with_luks for the LUKS header LV */
+    int lvm_encrypted;
+    /* Boot slot suffix, empty on single slot devices */
+    char slot_suffix[8];
+} state;
+
+
+/**
+ * Static variables
+ */
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t probed_cond = PTHREAD_COND_INITIALIZER;
+static bool is_started = false;
+static bool is_probed = false;
+static state current = { -1, "" };
+
+static int inotify_fd = -1;
+
+
+/**
+ * Static prototypes
+ */
+
+/**
+ * Read the slot suffix from the kernel command line.
+ *
+ * @param suffix buffer for writing the suffix into, left empty if there is none
+ * @param size size of suffix
+ */
+static void read_slot_suffix(char *suffix, size_t size);
+
+/**
+ * Probe the block devices, which change while the program runs.
+ *
+ * @param result state to write into
+ */
+static void probe_devices(state *result);
+
+/**
+ * Run the initial probe.
+ *
+ * @param arg unused
+ * @return NULL
+ */
+static void *probe_thread(void *arg);
+
+/**
+ * Wait until the initial probe finished. Falls back to probing on the calling thread if it was never
+ * started.
+ */
+static void wait_for_probe(void);
+
+/**
+ * Re-probe the block devices after a change in /dev/mapper.
+ *
+ * @param fd the inotify file descriptor
+ * @param events ready events
+ * @param user_data unused
+ */
+static void inotify_ready_cb(int fd, uint32_t events, void *user_data);
+
+
+/**
+ * Static functions
+ */
+
+static void read_slot_suffix(char *suffix, size_t size) {
+    suffix[0] = '\0';
+
+    FILE *cmdline = fopen(CMDLINE_PATH, "r");
+    if (cmdline == NULL) {
+        log_error("Error opening " CMDLINE_PATH ": %s", strerror(errno));
+        return;
+    }
+
+    char buffer[4096];
+    if (fgets(buffer, sizeof(buffer), cmdline) != NULL) {
+        const char *token = strstr(buffer, SLOT_SUFFIX_ARG);
+        if (token != NULL) {
+            token += strlen(SLOT_SUFFIX_ARG);
+            snprintf(suffix, size, "%.*s", (int)strcspn(token, " \n"), token);
+        }
+    }
+
+    fclose(cmdline);
+}
+
+static void probe_devices(state *result) {
+    result->lvm_encrypted = is_lv_encrypted_with_luks(LVM_HEADER_PATH, LVM_HEADER_BYTES);
+}
+
+static void *probe_thread(void *arg) {
+    LV_UNUSED(arg);
+
+    state result;
+    read_slot_suffix(result.slot_suffix, sizeof(result.slot_suffix));
+    probe_devices(&result);
+
+    pthread_mutex_lock(&lock);
+    current = result;
+    is_probed = true;
+    pthread_cond_broadcast(&probed_cond);
+    pthread_mutex_unlock(&lock);
+
+    return NULL;
+}
+
+static void wait_for_probe(void) {
+    pthread_mutex_lock(&lock);
+    const bool needs_probe = !is_started;
+    is_started = true;
+    pthread_mutex_unlock(&lock);
+
+    if (needs_probe) {
+        probe_thread(NULL);
+        return;
+    }
+
+    pthread_mutex_lock(&lock);
+    while (!is_probed) {
+        pthread_cond_wait(&probed_cond, &lock);
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+static void inotify_ready_cb(int fd, uint32_t events, void *user_data) {
+    LV_UNUSED(events);
+    LV_UNUSED(user_data);
+
+    /* Only the fact that something changed matters, not what */
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    while (read(fd, buffer, sizeof(buffer)) > 0) {
+    }
+
+    wait_for_probe();
+
+    state result;
+    probe_devices(&result);
+
+    pthread_mutex_lock(&lock);
+    current.lvm_encrypted = result.lvm_encrypted;
+    pthread_mutex_unlock(&lock);
+}
+
+
+/**
+ * Public functions
+ */
+
+void device_state_start(void) {
+    pthread_mutex_lock(&lock);
+    if (is_started) {
+        pthread_mutex_unlock(&lock);
+        return;
+    }
+    is_started = true;
+    pthread_mutex_unlock(&lock);
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, probe_thread, NULL) != 0) {
+        log_error("pthread_create: %s", strerror(errno));
+        probe_thread(NULL);
+        return;
+    }
+    pthread_detach(thread);
+}
+
+void device_state_watch(void) {
+    if (inotify_fd >= 0) {
+        return;
+    }
+
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd < 0) {
+        log_error("Failed to create inotify instance: %s", strerror(errno));
+        return;
+    }
+
+    if (inotify_add_watch(inotify_fd, MAPPER_PATH, IN_CREATE | IN_DELETE | IN_MOVED_TO | IN_MOVED_FROM) < 0
+        || !event_loop_add_fd(inotify_fd, inotify_ready_cb, NULL)) {
+        log_warning("Not watching %s for changes (Error: %s)", MAPPER_PATH, strerror(errno));
+        close(inotify_fd);
+        inotify_fd = -1;
+    }
+}
+
+int device_state_get_lvm_encrypted(void) {
+    wait_for_probe();
+    pthread_mutex_lock(&lock);
+    int result = current.lvm_encrypted;
+    pthread_mutex_unlock(&lock);
+    return result;
+}
+
+const char *device_state_get_slot_suffix(void) {
+    /* Written once by the initial probe and never changed afterwards */
+    wait_for_probe();
+    return current.slot_suffix;
+}
+
+bool device_state_has_rootfs_lv(void) {
+    /* Not cached, the inotify refresh may not have run yet right after an unlock created the LVs */
+    struct stat st;
+    return stat(ROOTFS_LV_PATH, &st) == 0;
+}
@@ -0,0 +1,63 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef DEVICE_STATE_H
+#define DEVICE_STATE_H
+
+#include <stdbool.h>
+
+/**
+ * Probe the boot environment and block devices on a background thread, so the answers are ready by
+ * the time the UI needs them. Call this once, as early as possible.
+ */
+void device_state_start(void);
+
+/**
+ * Re-probe the block devices whenever device-mapper devices appear or disappear. Call this from the
+ * LVGL thread after event_loop_init.
+ */
+void device_state_watch(void);
+
+/**
+ * Check whether the root LV is encrypted and still locked. Waits for the initial probe if it didn't
+ * finish yet.
+ *
+ * @return 1 if it is encrypted and locked, 0 if it isn't encrypted or was unlocked, -1 if the LVM
+ *         header couldn't be read
+ */
+int device_state_get_lvm_encrypted(void);
+
+/**
+ * Get the boot slot suffix from the kernel command line. Safe to call from any thread, waits for the
+ * initial probe if it didn't finish yet.
+ *
+ * @return the suffix, e.g. "_a", or an empty string on single slot devices
+ */
+const char *device_state_get_slot_suffix(void);
+
+/**
+ * Check whether the droidian rootfs LV is mapped. Safe to call from any thread, the device node is
+ * checked on every call so the answer is never stale.
+ *
+ * @return true if /dev/mapper/droidian-droidian--rootfs exists, false otherwise
+ */
+bool device_state_has_rootfs_lv(void);
+
+#endif /* DEVICE_STATE_H */
@@ -0,0 +1,439 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "dynparts.h"
+
+#include "log.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <linux/dm-ioctl.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+/**
+ * Defines
+ */
+
+#define SUPER_PATH "/dev/disk/by-partlabel/super"
+#define DM_CONTROL_PATH "/dev/mapper/control"
+#define DM_DEV_DIR "/dev/mapper"
+/* Prefix of mapped device names, matches parse-android-dynparts */
+#define DM_NAME_PREFIX "dynpart-"
+
+/* On-disk layout, see system/core/fs_mgr/liblp/include/liblp/metadata_format.h in AOSP */
+#define LP_PARTITION_RESERVED_BYTES 4096
+#define LP_METADATA_GEOMETRY_SIZE 4096
+#define LP_METADATA_GEOMETRY_MAGIC 0x616c4467
+#define LP_METADATA_HEADER_MAGIC 0x414c5030
+#define LP_METADATA_MAJOR_VERSION 10
+#define LP_SECTOR_SIZE 512
+#define LP_TARGET_TYPE_LINEAR 0
+#define LP_TARGET_TYPE_ZERO 1
+/* Metadata slot to read, every slot describes all partitions */
+#define LP_METADATA_SLOT 0
+
+/* Size of the buffer for device-mapper ioctls without a table */
+#define DM_IOCTL_SIZE 16384
+
+
+/**
+ * Static types
+ */
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint32_t struct_size;
+    uint8_t checksum[32];
+    uint32_t metadata_max_size;
+    uint32_t metadata_slot_count;
+    uint32_t logical_block_size;
+} lp_geometry;
+
+typedef struct __attribute__((packed)) {
+    uint32_t offset;
+    uint32_t num_entries;
+    uint32_t entry_size;
+} lp_table;
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint16_t major_version;
+    uint16_t minor_version;
+    uint32_t header_size;
+    uint8_t header_checksum[32];
+    uint32_t tables_size;
+    uint8_t tables_checksum[32];
+    lp_table partitions;
+    lp_table extents;
+    lp_table groups;
+    lp_table block_devices;
+} lp_header;
+
+typedef struct __attribute__((packed)) {
+    char name[36];
+    uint32_t attributes;
+    uint32_t first_extent_index;
+    uint32_t num_extents;
+    uint32_t group_index;
+} lp_partition;
+
+typedef struct __attribute__((packed)) {
+    uint64_t num_sectors;
+    uint32_t target_type;
+    uint64_t target_data;
+    uint32_t target_source;
+} lp_extent;
+
+/* Metadata of the super partition, kept for the whole session */
+typedef struct {
+    /* Metadata slot as read from disk, NULL until loaded */
+    unsigned char *buffer;
+    const lp_header *header;
+    /* Start of the tables within buffer */
+    const unsigned char *tables;
+    /* Device number of the super partition, targets are expressed relative to it */
+    dev_t super_dev;
+} metadata;
+
+
+/**
+ * Static variables
+ */
+
+static metadata cache = { NULL, NULL, NULL, 0 };
+
+
+/**
+ * Static prototypes
+ */
+
+/**
+ * Check that a table lies within the tables area and has entries of at least the expected size.
+ *
+ * @param table the table descriptor
+ * @param tables_size size of the tables area
+ * @param entry_size minimum entry size
+ * @return true if the table is valid, false otherwise
+ */
+static bool is_valid_table(const lp_table *table, uint32_t tables_size, size_t entry_size);
+
+/**
+ * Read and validate a copy of the metadata.
+ *
+ * @param fd file descriptor of the super partition
+ * @param offset offset of the copy
+ * @param max_size size reserved for the copy
+ * @param buffer buffer of max_size bytes for reading into
+ * @return true if the copy is valid, false otherwise
+ */
+static bool read_metadata_copy(int fd, off_t offset, uint32_t max_size, unsigned char *buffer);
+
+/**
+ * Read the metadata of the super partition into the cache, falling back to the backup copy.
+ *
+ * @return true on success, false otherwise
+ */
+static bool load_metadata(void);
+
+/**
+ * Look up a partition in the cached metadata.
+ *
+ * @param name partition name
+ * @return the partition or NULL if it doesn't exist or has no extents
+ */
+static const lp_partition *find_partition(const char *name);
+
+/**
+ * Prepare a device-mapper ioctl buffer.
+ *
+ * @param io buffer
+ * @param size size of the buffer
+ * @param name device name
+ */
+static void init_dm_ioctl(struct dm_ioctl *io, size_t size, const char *name);
+
+/**
+ * Load a partition's extents as the table of a created device.
+ *
+ * @param control_fd file descriptor of the device-mapper control node
+ * @param dm_name device name
+ * @param partition the partition
+ * @return true on success, false otherwise
+ */
+static bool load_table(int control_fd, const char *dm_name, const lp_partition *partition);
+
+/**
+ * Create the device node of a mapped device, for systems where udev doesn't do it.
+ *
+ * @param path node path
+ * @param dev encoded device number returned by device-mapper
+ * @return true if the node exists afterwards, false otherwise
+ */
+static bool make_node(const char *path, uint64_t dev);
+
+
+/**
+ * Static functions
+ */
+
+static bool is_valid_table(const lp_table *table, uint32_t tables_size, size_t entry_size) {
+    if (table->num_entries > 0 && table->entry_size < entry_size) {
+        return false;
+    }
+    return (uint64_t)table->offset + (uint64_t)table->num_entries * table->entry_size <= tables_size;
+}
+
+static bool read_metadata_copy(int fd, off_t offset, uint32_t max_size, unsigned char *buffer) {
+    if (pread(fd, buffer, max_size, offset) != (ssize_t)max_size) {
+        return false;
+    }
+
+    const lp_header *header = (const lp_header *)buffer;
+    if (header->magic != LP_METADATA_HEADER_MAGIC || header->major_version != LP_METADATA_MAJOR_VERSION) {
+        return false;
+    }
+    if (header->header_size < sizeof(lp_header) || (uint64_t)header->header_size + header->tables_size > max_size) {
+        return false;
+    }
+
+    return is_valid_table(&(header->partitions), header->tables_size, sizeof(lp_partition))
+        && is_valid_table(&(header->extents), header->tables_size, sizeof(lp_extent));
+}
+
+static bool load_metadata(void) {
+    if (cache.buffer != NULL) {
+        return true;
+    }
+
+    int fd = open(SUPER_PATH, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    lp_geometry geometry;
+    bool has_geometry = false;
+    for (int i = 0; i < 2 && !has_geometry; ++i) {
+        /* The primary geometry is followed by a backup */
+        const off_t offset = LP_PARTITION_RESERVED_BYTES + i * LP_METADATA_GEOMETRY_SIZE;
+        has_geometry = pread(fd, &geometry, sizeof(geometry), offset) == sizeof(geometry)
+            && geometry.magic == LP_METADATA_GEOMETRY_MAGIC
+            && geometry.struct_size == sizeof(geometry)
+            && geometry.metadata_max_size >= sizeof(lp_header)
+            && geometry.metadata_max_size % LP_SECTOR_SIZE == 0
+            && geometry.metadata_slot_count > LP_METADATA_SLOT;
+    }
+
+    if (!has_geometry || fstat(fd, &st) != 0) {
+        log_error("Failed to read the geometry of %s", SUPER_PATH);
+        close(fd);
+        return false;
+    }
+
+    unsigned char *buffer = malloc(geometry.metadata_max_size);
+    if (buffer == NULL) {
+        close(fd);
+        return false;
+    }
+
+    /* All primary copies come first, then all backups */
+    const off_t primary = LP_PARTITION_RESERVED_BYTES + 2 * LP_METADATA_GEOMETRY_SIZE
+        + (off_t)LP_METADATA_SLOT * geometry.metadata_max_size;
+    const off_t backup = primary + (off_t)geometry.metadata_slot_count * geometry.metadata_max_size;
+    bool ok = read_metadata_copy(fd, primary, geometry.metadata_max_size, buffer)
+        || read_metadata_copy(fd, backup, geometry.metadata_max_size, buffer);
+    close(fd);
+
+    if (!ok) {
+        log_error("Failed to read the metadata of %s", SUPER_PATH);
+        free(buffer);
+        return false;
+    }
+
+    cache.buffer = buffer;
+    cache.header = (const lp_header *)buffer;
+    cache.tables = buffer + cache.header->header_size;
+    cache.super_dev = st.st_rdev;
+    return true;
+}
+
+static const lp_partition *find_partition(const char *name) {
+    const lp_header *header = cache.header;
+
+    for (uint32_t i = 0; i < header->partitions.num_entries; ++i) {
+        const lp_partition *partition = (const lp_partition *)(cache.tables + header->partitions.offset
+            + (size_t)i * header->partitions.entry_size);
+        if (strncmp(partition->name, name, sizeof(partition->name)) != 0) {
+            continue;
+        }
+
+        if (partition->num_extents == 0
+            || (uint64_t)partition->first_extent_index + partition->num_extents > header->extents.num_entries) {
+            return NULL;
+        }
+        return partition;
+    }
+
+    return NULL;
+}
+
+static void init_dm_ioctl(struct dm_ioctl *io, size_t size, const char *name) {
+    memset(io, 0, size);
+    io->version[0] = DM_VERSION_MAJOR;
+    io->version[1] = DM_VERSION_MINOR;
+    io->version[2] = DM_VERSION_PATCHLEVEL;
+    io->data_size = size;
+    io->data_start = sizeof(struct dm_ioctl);
+    snprintf(io->name, sizeof(io->name), "%s", name);
+}
+
+static bool load_table(int control_fd, const char *dm_name, const lp_partition *partition) {
+    /* Every target is a spec followed by its parameters, padded to 8 bytes */
+    const size_t params_size = 64;
+    const size_t target_size = sizeof(struct dm_target_spec) + params_size;
+    const size_t size = sizeof(struct dm_ioctl) + partition->num_extents * target_size;
+
+    struct dm_ioctl *io = malloc(size);
+    if (io == NULL) {
+        return false;
+    }
+    init_dm_ioctl(io, size, dm_name);
+    io->target_count = partition->num_extents;
+
+    const lp_header *header = cache.header;
+    uint64_t sector = 0;
+    for (uint32_t i = 0; i < partition->num_extents; ++i) {
+        const lp_extent *extent = (const lp_extent *)(cache.tables + header->extents.offset
+            + (size_t)(partition->first_extent_index + i) * header->extents.entry_size);
+        struct dm_target_spec *spec = (struct dm_target_spec *)((unsigned char *)(io + 1) + i * target_size);
+        char *params = (char *)(spec + 1);
+
+        spec->sector_start = sector;
+        spec->length = extent->num_sectors;
+        spec->next = target_size;
+
+        if (extent->target_type == LP_TARGET_TYPE_LINEAR && extent->target_source == 0) {
+            snprintf(spec->target_type, sizeof(spec->target_type), "linear");
+            snprintf(params, params_size, "%u:%u %llu", major(cache.super_dev), minor(cache.super_dev),
+                (unsigned long long)extent->target_data);
+        } else if (extent->target_type == LP_TARGET_TYPE_ZERO) {
+            snprintf(spec->target_type, sizeof(spec->target_type), "zero");
+        } else {
+            /* Extents on other block devices only exist on retrofitted devices */
+            log_error("Unsupported extent in dynamic partition %.36s", partition->name);
+            free(io);
+            return false;
+        }
+
+        sector += extent->num_sectors;
+    }
+
+    bool ok = ioctl(control_fd, DM_TABLE_LOAD, io) == 0;
+    if (!ok) {
+        log_error("Failed to load device-mapper table: %s", strerror(errno));
+    }
+
+    free(io);
+    return ok;
+}
+
+static bool make_node(const char *path, uint64_t dev) {
+    if (mknod(path, S_IFBLK | 0600, makedev(major((dev_t)dev), minor((dev_t)dev))) != 0 && errno != EEXIST) {
+        log_error("Failed to create device-mapper node: %s", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+
+/**
+ * Public functions
+ */
+
+int dynparts_map(const char *name, char *path, size_t size) {
+    char dm_name[DM_NAME_LEN];
+    snprintf(dm_name, sizeof(dm_name), "%s%s", DM_NAME_PREFIX, name);
+    snprintf(path, size, "%s/%s", DM_DEV_DIR, dm_name);
+
+    struct stat st;
+    if (stat(path, &st) == 0) {
+        return 0;
+    }
+
+    if (!load_metadata()) {
+        return -1;
+    }
+
+    const lp_partition *partition = find_partition(name);
+    if (partition == NULL) {
+        return -1;
+    }
+
+    int control_fd = open(DM_CONTROL_PATH, O_RDWR | O_CLOEXEC);
+    if (control_fd < 0) {
+        log_error("Failed to open " DM_CONTROL_PATH ": %s", strerror(errno));
+        return -1;
+    }
+
+    static _Alignas(struct dm_ioctl) unsigned char buffer[DM_IOCTL_SIZE];
+    struct dm_ioctl *io = (struct dm_ioctl *)buffer;
+    init_dm_ioctl(io, sizeof(buffer), dm_name);
+
+    if (ioctl(control_fd, DM_DEV_CREATE, io) != 0) {
+        /* Mapped before but without a node, e.g. because udev isn't running */
+        init_dm_ioctl(io, sizeof(buffer), dm_name);
+        bool ok = errno == EBUSY && ioctl(control_fd, DM_DEV_STATUS, io) == 0 && make_node(path, io->dev);
+        if (!ok) {
+            log_error("Failed to create device-mapper device %s", dm_name);
+        }
+        close(control_fd);
+        return ok ? 0 : -1;
+    }
+
+    if (!load_table(control_fd, dm_name, partition)) {
+        init_dm_ioctl(io, sizeof(buffer), dm_name);
+        ioctl(control_fd, DM_DEV_REMOVE, io);
+        close(control_fd);
+        return -1;
+    }
+
+    /* Resuming a device without DM_SUSPEND_FLAG activates its table */
+    init_dm_ioctl(io, sizeof(buffer), dm_name);
+    if (ioctl(control_fd, DM_DEV_SUSPEND, io) != 0) {
+        log_error("Failed to activate device-mapper device: %s", strerror(errno));
+        init_dm_ioctl(io, sizeof(buffer), dm_name);
+        ioctl(control_fd, DM_DEV_REMOVE, io);
+        close(control_fd);
+        return -1;
+    }
+
+    close(control_fd);
+    log_info("Mapped dynamic partition %s to %s", name, path);
+    return make_node(path, io->dev) ? 0 : -1;
+}
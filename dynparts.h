@@ -0,0 +1,40 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef DYNPARTS_H
+#define DYNPARTS_H
+
+#include <stddef.h>
+
+/**
+ * Map a logical partition of Android's super partition to /dev/mapper/dynpart-NAME through the
+ * device-mapper ioctls, the in-process equivalent of
+ * dmsetup create --concise "$(parse-android-dynparts /dev/disk/by-partlabel/super)" limited to a
+ * single partition. An existing mapping is reused. The super partition's metadata is read on first
+ * use and kept for the rest of the session.
+ *
+ * @param name logical partition name, e.g. system_a
+ * @param path buffer for writing the mapped device's path into
+ * @param size size of path
+ * @return 0 on success, -1 if there is no super partition, it holds no such partition or mapping failed
+ */
+int dynparts_map(const char *name, char *path, size_t size);
+
+#endif /* DYNPARTS_H */
@@ -0,0 +1,289 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "event_loop.h"
+
+#include "indev.h"
+#include "log.h"
+#include "tick.h"
+
+#include "lvgl/lvgl.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+
+/**
+ * Defines
+ */
+
+/* Maximum number of watched file descriptors, including the timerfd */
+#define EVENT_LOOP_MAX_FDS 16
+
+
+/**
+ * Static types
+ */
+
+/* A watched file descriptor */
+typedef struct {
+    /* File descriptor, -1 if the slot is free */
+    int fd;
+    /* Readiness callback, may be NULL */
+    event_loop_fd_cb cb;
+    /* User data for the callback */
+    void *user_data;
+} watch;
+
+
+/**
+ * Static variables
+ */
+
+static int epoll_fd = -1;
+static int timer_fd = -1;
+static watch watches[EVENT_LOOP_MAX_FDS];
+
+static unsigned int wakeups = 0;
+static unsigned int wakeups_per_second = 0;
+static uint64_t wakeups_second = 0;
+
+
+/**
+ * Static prototypes
+ */
+
+/**
+ * Drain the timerfd after it expired.
+ *
+ * @param fd the timerfd
+ * @param events ready events
+ * @param user_data unused
+ */
+static void timer_fd_cb(int fd, uint32_t events, void *user_data);
+
+/**
+ * Get the time until the next unpaused LVGL timer is due.
+ *
+ * @return time in ms or LV_NO_TIMER_READY if all timers are paused
+ */
+static uint32_t time_till_next_timer(void);
+
+/**
+ * Pause the display refresh timer while nothing is invalidated or animating. Invalidating an area
+ * or marking a layout dirty resumes it from within LVGL.
+ */
+static void pause_idle_refresh(void);
+
+/**
+ * Arm the timerfd for the given delay, or disarm it.
+ *
+ * @param delay_ms delay in ms or LV_NO_TIMER_READY to disarm
+ */
+static void arm_timer(uint32_t delay_ms);
+
+/**
+ * Count a wakeup and roll the per-second statistics over.
+ *
+ * @param log_wakeups if true, log the count of each completed second
+ */
+static void count_wakeup(bool log_wakeups);
+
+
+/**
+ * Static functions
+ */
+
+static void timer_fd_cb(int fd, uint32_t events, void *user_data) {
+    LV_UNUSED(events);
+    LV_UNUSED(user_data);
+
+    uint64_t expirations;
+    if (read(fd, &expirations, sizeof(expirations)) < 0 && errno != EAGAIN) {
+        log_error("Failed to read timerfd: %s", strerror(errno));
+    }
+}
+
+static uint32_t time_till_next_timer(void) {
+    uint32_t next = LV_NO_TIMER_READY;
+
+    for (lv_timer_t *timer = lv_timer_get_next(NULL); timer != NULL; timer = lv_timer_get_next(timer)) {
+        if (timer->paused) {
+            continue;
+        }
+
+        uint32_t elapsed = lv_tick_elaps(timer->last_run);
+        uint32_t remaining = elapsed >= timer->period ? 0 : timer->period - elapsed;
+        if (remaining < next) {
+            next = remaining;
+        }
+    }
+
+    return next;
+}
+
+static void pause_idle_refresh(void) {
+    for (lv_disp_t *disp = lv_disp_get_next(NULL); disp != NULL; disp = lv_disp_get_next(disp)) {
+        if (disp->refr_timer != NULL && disp->inv_p == 0 && lv_anim_count_running() == 0) {
+            lv_timer_pause(disp->refr_timer);
+        }
+    }
+}
+
+static void arm_timer(uint32_t delay_ms) {
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+
+    if (delay_ms != LV_NO_TIMER_READY) {
+        spec.it_value.tv_sec = delay_ms / 1000;
+        spec.it_value.tv_nsec = (long)(delay_ms % 1000) * 1000000;
+    }
+
+    /* An all-zero it_value disarms the timer */
+    if (timerfd_settime(timer_fd, 0, &spec, NULL) != 0) {
+        log_error("Failed to arm timerfd: %s", strerror(errno));
+    }
+}
+
+static void count_wakeup(bool log_wakeups) {
+    const uint64_t second = tick_now_us() / 1000000;
+
+    if (second != wakeups_second) {
+        /* Seconds without any wakeup are reported as the first wakeup after them */
+        wakeups_per_second = second == wakeups_second + 1 ? wakeups : 0;
+        wakeups_second = second;
+        wakeups = 0;
+
+        if (log_wakeups) {
+            log_info("Event loop: %u wakeups/s", wakeups_per_second);
+        }
+    }
+
+    ++wakeups;
+}
+
+
+/**
+ * Public functions
+ */
+
+bool event_loop_init(void) {
+    for (int i = 0; i < EVENT_LOOP_MAX_FDS; ++i) {
+        watches[i].fd = -1;
+    }
+
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) {
+        log_error("Failed to create epoll instance: %s", strerror(errno));
+        return false;
+    }
+
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd < 0) {
+        log_error("Failed to create timerfd: %s", strerror(errno));
+        close(epoll_fd);
+        epoll_fd = -1;
+        return false;
+    }
+
+    return event_loop_add_fd(timer_fd, timer_fd_cb, NULL);
+}
+
+bool event_loop_add_fd(int fd, event_loop_fd_cb cb, void *user_data) {
+    watch *slot = NULL;
+    for (int i = 0; i < EVENT_LOOP_MAX_FDS; ++i) {
+        if (watches[i].fd < 0) {
+            slot = &watches[i];
+            break;
+        }
+    }
+
+    if (slot == NULL) {
+        log_error("Too many file descriptors in event loop, not watching %d", fd);
+        return false;
+    }
+
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.ptr = slot;
+
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+        log_error("Failed to add file descriptor to epoll instance: %s", strerror(errno));
+        return false;
+    }
+
+    slot->fd = fd;
+    slot->cb = cb;
+    slot->user_data = user_data;
+    return true;
+}
+
+void event_loop_remove_fd(int fd) {
+    for (int i = 0; i < EVENT_LOOP_MAX_FDS; ++i) {
+        if (watches[i].fd == fd) {
+            epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+            watches[i].fd = -1;
+            return;
+        }
+    }
+}
+
+unsigned int event_loop_get_wakeups_per_second(void) {
+    return wakeups_per_second;
+}
+
+void event_loop_run(bool log_wakeups) {
+    struct epoll_event events[EVENT_LOOP_MAX_FDS];
+
+    while (1) {
+        lv_timer_handler();
+
+        /* Let idle timers go to sleep, they are woken by input or invalidation */
+        indev_pause_idle_read_timers();
+        pause_idle_refresh();
+
+        uint32_t delay_ms = time_till_next_timer();
+        if (delay_ms == 0) {
+            continue;
+        }
+        arm_timer(delay_ms);
+
+        int num_events = epoll_wait(epoll_fd, events, EVENT_LOOP_MAX_FDS, -1);
+        if (num_events < 0) {
+            if (errno != EINTR) {
+                log_error("epoll_wait: %s", strerror(errno));
+            }
+            continue;
+        }
+
+        count_wakeup(log_wakeups);
+
+        for (int i = 0; i < num_events; ++i) {
+            watch *w = events[i].data.ptr;
+            if (w->fd >= 0 && w->cb != NULL) {
+                w->cb(w->fd, events[i].events, w->user_data);
+            }
+        }
+    }
+}
@@ -0,0 +1,76 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Callback for a file descriptor that became ready. Runs on the LVGL thread.
+ *
+ * @param fd the file descriptor
+ * @param events ready events (EPOLLIN etc.)
+ * @param user_data user data passed to event_loop_add_fd
+ */
+typedef void (*event_loop_fd_cb)(int fd, uint32_t events, void *user_data);
+
+/**
+ * Create the epoll instance and the LVGL timer timerfd.
+ *
+ * @return true on success, false otherwise
+ */
+bool event_loop_init(void);
+
+/**
+ * Wake the event loop whenever a file descriptor becomes readable.
+ *
+ * @param fd the file descriptor
+ * @param cb callback to run when the descriptor is readable, may be NULL to only wake the loop
+ * @param user_data user data to pass to the callback
+ * @return true on success, false otherwise
+ */
+bool event_loop_add_fd(int fd, event_loop_fd_cb cb, void *user_data);
+
+/**
+ * Stop watching a file descriptor.
+ *
+ * @param fd the file descriptor
+ */
+void event_loop_remove_fd(int fd);
+
+/**
+ * Get the number of times the loop woke up during the last full second.
+ *
+ * @return number of wakeups
+ */
+unsigned int event_loop_get_wakeups_per_second(void);
+
+/**
+ * Run LVGL until the process exits. Between timer runs the loop sleeps in epoll until a watched
+ * descriptor becomes readable or the next LVGL timer is due. Display refresh is paused while nothing
+ * is invalidated or animating, and input read timers are paused while no input is in progress.
+ *
+ * @param log_wakeups if true, log the number of wakeups per second
+ */
+void event_loop_run(bool log_wakeups);
+
+#endif /* EVENT_LOOP_H */
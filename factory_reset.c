@@ -0,0 +1,474 @@
+/**
+ * Copyright 2024 Bardia Moshiri
+ * Copyright 2024 David Badiei
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "factory_reset.h"
+#include "device_state.h"
+#include "dynparts.h"
+#include "flash.h"
+#include "job.h"
+#include "log.h"
+#include "restore.h"
+
+#include <dirent.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/mount.h>
+#include <sys/stat.h>
+
+/**
+ * Static types
+ */
+
+/**
+ * Userdata archive candidates
+ */
+typedef struct {
+    /* Path of the archive */
+    const char *path;
+    /* If true, the image may be flashed sparsely (discard, then skip zero blocks) */
+    bool sparse;
+} userdata_archive;
+
+/**
+ * State shared by the stages of a reset
+ */
+typedef struct {
+    /* Suffix of the current slot, may be empty */
+    const char *slot_suffix;
+    /* Device the system partition was mapped to */
+    char system_device[256];
+} reset_context;
+
+/**
+ * Context of the restore callbacks
+ */
+typedef struct {
+    job *j;
+    /* Index of the restoring stage */
+    int stage;
+} progress_context;
+
+/* Stages of a reset, indexes into reset_stages */
+enum {
+    RESET_STAGE_MAP_SYSTEM = 0,
+    RESET_STAGE_MOUNT_SYSTEM,
+    RESET_STAGE_RESTORE_USERDATA,
+    RESET_STAGE_FLASH_SYSTEM_IMAGES,
+    RESET_STAGE_MOUNT_ROOTFS,
+    RESET_STAGE_FLASH_ROOTFS_IMAGES,
+    RESET_NUM_STAGES
+};
+
+
+/**
+ * Static prototypes
+ */
+
+/**
+ * Forward restore progress to the job.
+ *
+ * @param bytes_done number of bytes of the image restored so far
+ * @param bytes_total size of the image
+ * @param user_data the progress context
+ */
+static void restore_progress_cb_forward(uint64_t bytes_done, uint64_t bytes_total, void *user_data);
+
+/**
+ * Stop the restore once the job was cancelled.
+ *
+ * @param user_data the progress context
+ * @return true if the job was cancelled
+ */
+static bool restore_cancel_cb_forward(void *user_data);
+
+/**
+ * Flash an image to a partition of the current slot.
+ *
+ * @param image_path path of the image
+ * @param partition name of the partition without slot suffix
+ * @param slot_suffix suffix of the current slot, may be empty
+ * @param source description of where the image came from, for messages
+ * @return 0 on success, -1 on failure
+ */
+static int flash_partition(const char *image_path, const char *partition, const char *slot_suffix, const char *source);
+
+/**
+ * Check whether the system partition lacks a boot or dtbo image.
+ *
+ * @return true if an image is missing
+ */
+static bool has_missing_system_images(void);
+
+/**
+ * Find an image in /rootfs_mnt/boot whose name starts with a prefix.
+ *
+ * @param dir the opened boot directory
+ * @param prefix start of the file name
+ * @param path buffer for writing the path of the image into
+ * @param size size of the buffer
+ * @return true if an image was found
+ */
+static bool find_rootfs_image(DIR *dir, const char *prefix, char *path, size_t size);
+
+/**
+ * Map the dynamic system partition. Stage function of the reset job.
+ *
+ * @param j the job
+ * @param stage index of the stage
+ * @param ctx the reset context
+ * @return 0 on success, -1 on failure
+ */
+static int map_system(job *j, int stage, void *ctx);
+
+/**
+ * Mount the system partition. Stage function of the reset job.
+ *
+ * @param j the job
+ * @param stage index of the stage
+ * @param ctx the reset context
+ * @return 0 on success, -1 on failure
+ */
+static int mount_system(job *j, int stage, void *ctx);
+
+/**
+ * Unmount the system partition. Cleanup function of the reset job.
+ *
+ * @param ctx the reset context
+ */
+static void unmount_system(void *ctx);
+
+/**
+ * Restore userdata from the archive on the system partition. Stage function of the reset job.
+ *
+ * @param j the job
+ * @param stage index of the stage
+ * @param ctx the reset context
+ * @return 0 on success, -1 on failure
+ */
+static int restore_userdata(job *j, int stage, void *ctx);
+
+/**
+ * Flash the boot and dtbo images found on the system partition. Stage function of the reset job.
+ *
+ * @param j the job
+ * @param stage index of the stage
+ * @param ctx the reset context
+ * @return 0 on success or if images are missing, -1 if an image fails to flash
+ */
+static int flash_system_images(job *j, int stage, void *ctx);
+
+/**
+ * Mount the rootfs if the system partition lacks an image. Stage function of the reset job.
+ *
+ * @param j the job
+ * @param stage index of the stage
+ * @param ctx the reset context
+ * @return 0 on success, JOB_STAGE_SKIPPED if the rootfs isn't needed or available, -1 on failure
+ */
+static int mount_rootfs(job *j, int stage, void *ctx);
+
+/**
+ * Unmount the rootfs. Cleanup function of the reset job.
+ *
+ * @param ctx the reset context
+ */
+static void unmount_rootfs(void *ctx);
+
+/**
+ * Flash the boot and dtbo images found in the rootfs. Stage function of the reset job.
+ *
+ * @param j the job
+ * @param stage index of the stage
+ * @param ctx the reset context
+ * @return 0 on success, -1 if the rootfs has no boot directory or an image fails to flash
+ */
+static int flash_rootfs_images(job *j, int stage, void *ctx);
+
+
+/**
+ * Static variables
+ */
+
+/* Userdata archives in order of preference */
+static const userdata_archive userdata_archives[] = {
+    { "/system_mnt/userdata.img.tar.gz", true },
+    { "/system_mnt/userdata-raw.img.tar.gz", true },
+};
+
+/* Logical partitions holding the system image, in order of preference */
+static const char *system_partitions[] = { "system_a", "system_b" };
+
+/* Phases reported to the progress callback */
+static const char phase_prepare[] = "Preparing";
+static const char phase_userdata[] = "Restoring userdata";
+static const char phase_boot[] = "Flashing boot images";
+static const char phase_cleanup[] = "Cleaning up";
+
+/* The system images are flashed while userdata streams. The rootfs LV lives on the userdata partition,
+ * so it is only mounted once the restore rewrote it. */
+static const job_stage reset_stages[RESET_NUM_STAGES] = {
+    [RESET_STAGE_MAP_SYSTEM] = { "map-system", phase_prepare, map_system, NULL, 0, true },
+    [RESET_STAGE_MOUNT_SYSTEM] = { "mount-system", phase_prepare, mount_system, unmount_system,
+        JOB_DEP(RESET_STAGE_MAP_SYSTEM), true },
+    [RESET_STAGE_RESTORE_USERDATA] = { "restore-userdata", phase_userdata, restore_userdata, NULL,
+        JOB_DEP(RESET_STAGE_MOUNT_SYSTEM), true },
+    [RESET_STAGE_FLASH_SYSTEM_IMAGES] = { "flash-system-images", phase_boot, flash_system_images, NULL,
+        JOB_DEP(RESET_STAGE_MOUNT_SYSTEM), true },
+    [RESET_STAGE_MOUNT_ROOTFS] = { "mount-rootfs", NULL, mount_rootfs, unmount_rootfs,
+        JOB_DEP(RESET_STAGE_RESTORE_USERDATA), true },
+    /* Runs after the system images so that the rootfs images win, like they always did */
+    [RESET_STAGE_FLASH_ROOTFS_IMAGES] = { "flash-rootfs-images", phase_boot, flash_rootfs_images, NULL,
+        JOB_DEP(RESET_STAGE_RESTORE_USERDATA) | JOB_DEP(RESET_STAGE_MOUNT_ROOTFS)
+        | JOB_DEP(RESET_STAGE_FLASH_SYSTEM_IMAGES), true },
+};
+
+static const job_desc reset_job = {
+    .name = "factory-reset",
+    .stages = reset_stages,
+    .num_stages = RESET_NUM_STAGES,
+    .cleanup_phase = phase_cleanup
+};
+
+
+/**
+ * Static functions
+ */
+
+static void restore_progress_cb_forward(uint64_t bytes_done, uint64_t bytes_total, void *user_data) {
+    const progress_context *progress = user_data;
+    job_report_progress(progress->j, progress->stage, bytes_done, bytes_total);
+}
+
+static bool restore_cancel_cb_forward(void *user_data) {
+    const progress_context *progress = user_data;
+    return job_is_cancelled(progress->j);
+}
+
+static int flash_partition(const char *image_path, const char *partition, const char *slot_suffix, const char *source) {
+    char device_path[256];
+    snprintf(device_path, sizeof(device_path), "/dev/disk/by-partlabel/%s%s", partition, slot_suffix);
+
+    if (flash_image_to_device(image_path, device_path, NULL) != 0) {
+        log_error("Failed to flash %s image%s%s", partition,
+               *slot_suffix ? " to slot suffix " : "",
+               *slot_suffix ? slot_suffix : "");
+        return -1;
+    }
+
+    log_info("Flashed %s.img from %s", partition, source);
+    return 0;
+}
+
+static bool has_missing_system_images(void) {
+    struct stat buffer;
+    return stat("/system_mnt/boot.img", &buffer) != 0 || stat("/system_mnt/dtbo.img", &buffer) != 0;
+}
+
+static bool find_rootfs_image(DIR *dir, const char *prefix, char *path, size_t size) {
+    rewinddir(dir);
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, prefix, strlen(prefix)) == 0) {
+            snprintf(path, size, "/rootfs_mnt/boot/%s", entry->d_name);
+            return true;
+        }
+    }
+    return false;
+}
+
+static int map_system(job *j, int stage, void *ctx) {
+    (void)j;
+    (void)stage;
+    reset_context *reset = ctx;
+
+    for (size_t i = 0; i < sizeof(system_partitions) / sizeof(system_partitions[0]); ++i) {
+        if (dynparts_map(system_partitions[i], reset->system_device, sizeof(reset->system_device)) == 0) {
+            return 0;
+        }
+    }
+
+    log_error("Failed to mount dynpart-system, block device doesn't not exist");
+    return -1;
+}
+
+static int mount_system(job *j, int stage, void *ctx) {
+    (void)j;
+    (void)stage;
+    reset_context *reset = ctx;
+
+    mkdir("/system_mnt", 0755);
+    if (mount(reset->system_device, "/system_mnt", "ext4", 0, NULL) != 0) {
+        log_error("Failed to mount %s", reset->system_device);
+        return -1;
+    }
+    return 0;
+}
+
+static void unmount_system(void *ctx) {
+    (void)ctx;
+    umount("/system_mnt");
+}
+
+static int restore_userdata(job *j, int stage, void *ctx) {
+    (void)ctx;
+    struct stat buffer;
+
+    const userdata_archive *archive = NULL;
+    for (size_t i = 0; i < sizeof(userdata_archives) / sizeof(userdata_archives[0]); ++i) {
+        if (stat(userdata_archives[i].path, &buffer) == 0) {
+            archive = &userdata_archives[i];
+            break;
+        }
+    }
+
+    if (archive == NULL) {
+        log_error("Failed to find userdata archive");
+        return -1;
+    }
+
+    progress_context progress = { j, stage };
+    restore_opts opts = {
+        .sparse = archive->sparse,
+        .progress_cb = restore_progress_cb_forward,
+        .cancel_cb = restore_cancel_cb_forward,
+        .user_data = &progress
+    };
+
+    if (restore_archive_to_device(archive->path, "/dev/disk/by-partlabel/userdata", &opts, NULL) != 0) {
+        log_error("Failed to extract and write userdata");
+        return -1;
+    }
+    return 0;
+}
+
+static int flash_system_images(job *j, int stage, void *ctx) {
+    (void)j;
+    (void)stage;
+    const reset_context *reset = ctx;
+    struct stat buffer;
+    int result = 0;
+
+    /* Missing images are picked up from the rootfs later, a failed flash fails the reset */
+    if (stat("/system_mnt/boot.img", &buffer) == 0) {
+        if (flash_partition("/system_mnt/boot.img", "boot", reset->slot_suffix, "/system_mnt") != 0) {
+            result = -1;
+        }
+    } else {
+        log_error("No /system_mnt/boot.img found.");
+    }
+
+    if (stat("/system_mnt/dtbo.img", &buffer) == 0) {
+        if (flash_partition("/system_mnt/dtbo.img", "dtbo", reset->slot_suffix, "/system_mnt") != 0) {
+            result = -1;
+        }
+    } else {
+        log_error("No /system_mnt/dtbo.img found.");
+    }
+
+    return result;
+}
+
+static int mount_rootfs(job *j, int stage, void *ctx) {
+    (void)j;
+    (void)stage;
+    (void)ctx;
+
+    if (!has_missing_system_images()) {
+        return JOB_STAGE_SKIPPED;
+    }
+
+    if (!device_state_has_rootfs_lv()) {
+        log_warning("No /system_mnt images found and /dev/mapper/droidian-droidian--rootfs not available.");
+        return JOB_STAGE_SKIPPED;
+    }
+
+    mkdir("/rootfs_mnt", 0755);
+    if (mount("/dev/mapper/droidian-droidian--rootfs", "/rootfs_mnt", "ext4", MS_RDONLY, NULL) != 0) {
+        log_error("Failed to mount droidian-droidian--rootfs");
+        return -1;
+    }
+    return 0;
+}
+
+static void unmount_rootfs(void *ctx) {
+    (void)ctx;
+    umount("/rootfs_mnt");
+}
+
+static int flash_rootfs_images(job *j, int stage, void *ctx) {
+    (void)j;
+    (void)stage;
+    const reset_context *reset = ctx;
+
+    DIR *dir = opendir("/rootfs_mnt/boot");
+    if (dir == NULL) {
+        log_error("Failed to opendir /rootfs_mnt/boot");
+        return -1;
+    }
+
+    char boot_path[512];
+    char dtbo_path[512];
+    const bool has_boot = find_rootfs_image(dir, "boot.img", boot_path, sizeof(boot_path));
+    const bool has_dtbo = find_rootfs_image(dir, "dtbo.img", dtbo_path, sizeof(dtbo_path));
+    closedir(dir);
+    int result = 0;
+
+    if (has_boot) {
+        if (flash_partition(boot_path, "boot", reset->slot_suffix, "/rootfs_mnt") != 0) {
+            result = -1;
+        }
+    } else {
+        log_error("Failed to find boot image in the rootfs");
+    }
+
+    if (has_dtbo) {
+        if (flash_partition(dtbo_path, "dtbo", reset->slot_suffix, "/rootfs_mnt") != 0) {
+            result = -1;
+        }
+    } else {
+        log_error("Failed to find dtbo image in the rootfs");
+    }
+
+    return result;
+}
+
+
+/**
+ * Public functions
+ */
+
+int factory_reset(factory_reset_progress_cb progress_cb, void *user_data) {
+    reset_context reset = { .slot_suffix = device_state_get_slot_suffix() };
+
+    job *j = job_create(&reset_job, &reset, progress_cb, user_data);
+    if (j == NULL) {
+        return -1;
+    }
+
+    const int result = job_run(j);
+    job_free(j);
+    return result;
+}
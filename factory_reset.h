@@ -0,0 +1,46 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef FACTORY_RESET_H
+#define FACTORY_RESET_H
+
+#include <stdint.h>
+
+/**
+ * Progress callback of a factory reset.
+ *
+ * @param phase description of the current phase, a string literal that stays the same for the whole phase
+ * @param bytes_done number of bytes processed in the current phase
+ * @param bytes_total total number of bytes of the current phase, 0 if the phase isn't measured in bytes
+ * @param user_data user data passed to factory_reset
+ */
+typedef void (*factory_reset_progress_cb)(const char *phase, uint64_t bytes_done, uint64_t bytes_total, void *user_data);
+
+/**
+ * Factory reset the device: restore userdata from the system partition and reflash boot and dtbo.
+ * This blocks for minutes and doesn't touch LVGL, so it is meant to be run on a worker thread.
+ *
+ * @param progress_cb progress callback, may be NULL
+ * @param user_data user data to pass to the progress callback
+ * @return 0 on success, -1 on failure
+ */
+int factory_reset(factory_reset_progress_cb progress_cb, void *user_data);
+
+#endif /* FACTORY_RESET_H */
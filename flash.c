@@ -0,0 +1,360 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#define _GNU_SOURCE
+
+#include "flash.h"
+
+#include "log.h"
+#include "tick.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <linux/fs.h>
+
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+
+/**
+ * Defines
+ */
+
+/* Size of the chunks that are compared and written */
+#define FLASH_CHUNK_SIZE (1024 * 1024)
+/* Alignment of the buffers, satisfies O_DIRECT on all common devices */
+#define FLASH_BUFFER_ALIGN 4096
+
+
+/**
+ * Static types
+ */
+
+/**
+ * Target of a flash
+ */
+typedef struct {
+    /* File descriptor of the device */
+    int fd;
+    /* Lengths of direct I/O must be a multiple of this, 1 without direct I/O */
+    size_t block_size;
+} flash_target;
+
+
+/**
+ * Static prototypes
+ */
+
+/**
+ * Open the target device for direct I/O, falling back to buffered I/O if it doesn't support it.
+ *
+ * @param device_path path of the device
+ * @param image_size size of the image, the device must be at least this large
+ * @param target pointer for writing the opened target into
+ * @return true on success, false otherwise
+ */
+static bool open_target(const char *device_path, uint64_t image_size, flash_target *target);
+
+/**
+ * Read a buffer from a file descriptor at a given offset, retrying on short reads and EINTR.
+ *
+ * @param fd file descriptor
+ * @param buf buffer to read into
+ * @param len number of bytes to read
+ * @param offset offset to read from
+ * @return true on success, false otherwise
+ */
+static bool pread_full(int fd, void *buf, size_t len, uint64_t offset);
+
+/**
+ * Write a buffer to a file descriptor at a given offset, retrying on short writes and EINTR.
+ *
+ * @param fd file descriptor
+ * @param buf buffer to write
+ * @param len number of bytes to write
+ * @param offset offset to write at
+ * @return true on success, false otherwise
+ */
+static bool pwrite_full(int fd, const void *buf, size_t len, uint64_t offset);
+
+/**
+ * Round a length up to the block size of a target.
+ *
+ * @param target the target
+ * @param len length in bytes
+ * @return rounded length
+ */
+static size_t round_to_block(const flash_target *target, size_t len);
+
+/**
+ * Write the chunks of an image that differ from the target.
+ *
+ * @param image_fd file descriptor of the image
+ * @param target the target
+ * @param image_buf buffer of FLASH_CHUNK_SIZE bytes for the image
+ * @param device_buf buffer of FLASH_CHUNK_SIZE bytes for the target
+ * @param size size of the image
+ * @param crc pointer for writing the checksum of the image into
+ * @param bytes_written pointer for writing the number of written bytes into
+ * @return true on success, false on read or write errors
+ */
+static bool write_changed_chunks(int image_fd, const flash_target *target, unsigned char *image_buf,
+    unsigned char *device_buf, uint64_t size, uLong *crc, uint64_t *bytes_written);
+
+/**
+ * Read back the start of the target and compare its checksum against the image's.
+ *
+ * @param target the target
+ * @param buf buffer of FLASH_CHUNK_SIZE bytes to read into
+ * @param size size of the image
+ * @param image_crc checksum of the image
+ * @param device_path path of the target for error messages
+ * @return true if the checksums match, false otherwise
+ */
+static bool verify_target(const flash_target *target, unsigned char *buf, uint64_t size, uLong image_crc, const char *device_path);
+
+
+/**
+ * Static functions
+ */
+
+static bool open_target(const char *device_path, uint64_t image_size, flash_target *target) {
+    target->fd = open(device_path, O_RDWR | O_DIRECT | O_CLOEXEC);
+    target->block_size = 1;
+    if (target->fd < 0 && errno == EINVAL) {
+        target->fd = open(device_path, O_RDWR | O_CLOEXEC);
+    } else if (target->fd >= 0) {
+        int sector_size = 0;
+        if (ioctl(target->fd, BLKSSZGET, &sector_size) != 0 || sector_size <= 0 || sector_size > FLASH_BUFFER_ALIGN) {
+            /* Not a block device, direct I/O alignment rules are unknown */
+            close(target->fd);
+            target->fd = open(device_path, O_RDWR | O_CLOEXEC);
+        } else {
+            target->block_size = (size_t)sector_size;
+        }
+    }
+
+    if (target->fd < 0) {
+        log_error("Failed to open target device %s (Error: %s)", device_path, strerror(errno));
+        return false;
+    }
+
+    struct stat st;
+    uint64_t device_size = 0;
+    if (fstat(target->fd, &st) == 0 && S_ISBLK(st.st_mode)) {
+        if (ioctl(target->fd, BLKGETSIZE64, &device_size) != 0) {
+            log_error("Failed to get size of target device: %s", strerror(errno));
+            close(target->fd);
+            return false;
+        }
+    } else {
+        /* Image files grow as needed */
+        device_size = UINT64_MAX;
+    }
+
+    if (device_size < image_size) {
+        log_error("Image of %llu bytes doesn't fit %s (%llu bytes)", (unsigned long long)image_size,
+            device_path, (unsigned long long)device_size);
+        close(target->fd);
+        return false;
+    }
+
+    return true;
+}
+
+static bool pread_full(int fd, void *buf, size_t len, uint64_t offset) {
+    unsigned char *p = buf;
+
+    while (len > 0) {
+        ssize_t n = pread(fd, p, len, (off_t)offset);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        len -= n;
+        offset += n;
+    }
+
+    return true;
+}
+
+static bool pwrite_full(int fd, const void *buf, size_t len, uint64_t offset) {
+    const unsigned char *p = buf;
+
+    while (len > 0) {
+        ssize_t n = pwrite(fd, p, len, (off_t)offset);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            log_error("Failed to write to target device: %s", strerror(errno));
+            return false;
+        }
+        p += n;
+        len -= n;
+        offset += n;
+    }
+
+    return true;
+}
+
+static size_t round_to_block(const flash_target *target, size_t len) {
+    return (len + target->block_size - 1) / target->block_size * target->block_size;
+}
+
+static bool write_changed_chunks(int image_fd, const flash_target *target, unsigned char *image_buf,
+    unsigned char *device_buf, uint64_t size, uLong *crc, uint64_t *bytes_written) {
+    *crc = crc32(0L, Z_NULL, 0);
+
+    for (uint64_t offset = 0; offset < size; offset += FLASH_CHUNK_SIZE) {
+        const size_t len = size - offset < FLASH_CHUNK_SIZE ? (size_t)(size - offset) : FLASH_CHUNK_SIZE;
+        const size_t device_len = round_to_block(target, len);
+
+        if (!pread_full(image_fd, image_buf, len, offset)) {
+            log_error("Failed to read image");
+            return false;
+        }
+        *crc = crc32(*crc, image_buf, (uInt)len);
+
+        /* Past the end of an image file target there is nothing to compare against */
+        if (!pread_full(target->fd, device_buf, device_len, offset)) {
+            memset(device_buf, 0, device_len);
+        } else if (memcmp(image_buf, device_buf, len) == 0) {
+            continue;
+        }
+
+        /* A partial last block keeps the bytes the device holds after the image */
+        memcpy(device_buf, image_buf, len);
+        if (!pwrite_full(target->fd, device_buf, device_len, offset)) {
+            return false;
+        }
+        *bytes_written += len;
+    }
+
+    return true;
+}
+
+static bool verify_target(const flash_target *target, unsigned char *buf, uint64_t size, uLong image_crc, const char *device_path) {
+    /* Buffered reads would be served from the page cache instead of the device */
+    if (target->block_size == 1) {
+        posix_fadvise(target->fd, 0, (off_t)size, POSIX_FADV_DONTNEED);
+    }
+
+    uLong crc = crc32(0L, Z_NULL, 0);
+    for (uint64_t offset = 0; offset < size; offset += FLASH_CHUNK_SIZE) {
+        const size_t len = size - offset < FLASH_CHUNK_SIZE ? (size_t)(size - offset) : FLASH_CHUNK_SIZE;
+        if (!pread_full(target->fd, buf, round_to_block(target, len), offset)) {
+            log_error("Failed to read back target device: %s", strerror(errno));
+            return false;
+        }
+        crc = crc32(crc, buf, (uInt)len);
+    }
+
+    if (crc != image_crc) {
+        log_error("Verification of %s failed, checksum %08lx doesn't match image checksum %08lx",
+            device_path, crc, image_crc);
+        return false;
+    }
+
+    return true;
+}
+
+
+/**
+ * Public functions
+ */
+
+int flash_image_to_device(const char *image_path, const char *device_path, flash_stats *stats) {
+    uint64_t start_us = tick_now_us();
+    uint64_t bytes_written = 0;
+    bool flashed = false;
+
+    int image_fd = open(image_path, O_RDONLY | O_CLOEXEC);
+    if (image_fd < 0) {
+        log_error("Failed to open image %s (Error: %s)", image_path, strerror(errno));
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(image_fd, &st) != 0) {
+        log_error("Failed to stat image %s (Error: %s)", image_path, strerror(errno));
+        close(image_fd);
+        return -1;
+    }
+    const uint64_t size = (uint64_t)st.st_size;
+    posix_fadvise(image_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    flash_target target;
+    if (!open_target(device_path, size, &target)) {
+        close(image_fd);
+        return -1;
+    }
+
+    unsigned char *image_buf = NULL;
+    unsigned char *device_buf = NULL;
+    uLong image_crc = 0;
+    if (posix_memalign((void **)&image_buf, FLASH_BUFFER_ALIGN, FLASH_CHUNK_SIZE) != 0
+        || posix_memalign((void **)&device_buf, FLASH_BUFFER_ALIGN, FLASH_CHUNK_SIZE) != 0) {
+        log_error("Failed to allocate flash buffers");
+    } else {
+        flashed = write_changed_chunks(image_fd, &target, image_buf, device_buf, size, &image_crc, &bytes_written);
+    }
+
+    /* One sync for the whole image, and none if nothing changed */
+    if (flashed && bytes_written > 0 && fsync(target.fd) != 0) {
+        log_error("Failed to sync target device: %s", strerror(errno));
+        flashed = false;
+    }
+
+    /* Without writes the compare pass already read every byte of the device and found it matching */
+    if (flashed && bytes_written > 0) {
+        flashed = verify_target(&target, device_buf, size, image_crc, device_path);
+    }
+
+    /* The image is read once, don't let it push anything else out of the page cache */
+    posix_fadvise(image_fd, 0, 0, POSIX_FADV_DONTNEED);
+
+    free(image_buf);
+    free(device_buf);
+    close(target.fd);
+    close(image_fd);
+
+    uint64_t elapsed_us = tick_now_us() - start_us;
+
+    if (stats != NULL) {
+        stats->bytes_total = size;
+        stats->bytes_written = bytes_written;
+        stats->bytes_skipped = flashed ? size - bytes_written : 0;
+        stats->elapsed_us = elapsed_us;
+    }
+
+    log_info("Flashed %llu bytes to %s (%llu written) in %.1f s%s", (unsigned long long)size, device_path,
+        (unsigned long long)bytes_written, elapsed_us / 1000000.0, flashed ? ", verified" : ", failed");
+
+    return flashed ? 0 : -1;
+}
@@ -0,0 +1,57 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef FLASH_H
+#define FLASH_H
+
+#include <stdint.h>
+
+/**
+ * Statistics collected while flashing an image
+ */
+typedef struct {
+    /* Size of the image */
+    uint64_t bytes_total;
+    /* Number of bytes that differed and were written to the target device */
+    uint64_t bytes_written;
+    /* Number of bytes the target device already held */
+    uint64_t bytes_skipped;
+    /* Wall time spent on the flash, including the verification, in microseconds */
+    uint64_t elapsed_us;
+} flash_stats;
+
+/**
+ * Write an image file to the start of a block device. This is the in-process equivalent of
+ * "dd if=IMAGE of=DEVICE bs=4M".
+ *
+ * The image is compared against the device chunk by chunk and only chunks that differ are
+ * written, bypassing the page cache. If anything was written, the device is synced once and then
+ * read back to verify its checksum against the image. Flashing an image the device already holds
+ * reads it once and writes nothing, and an interrupted flash resumes where it stopped when run
+ * again.
+ *
+ * @param image_path path of the image file
+ * @param device_path path of the target block device
+ * @param stats pointer for writing statistics into, may be NULL
+ * @return 0 on success, -1 on failure
+ */
+int flash_image_to_device(const char *image_path, const char *device_path, flash_stats *stats);
+
+#endif /* FLASH_H */
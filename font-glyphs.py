@@ -0,0 +1,91 @@
+#!/usr/bin/env python3
+# Copyright 2026 FuriLabs
+# SPDX-License-Identifier: GPL-3.0-or-later
+#
+# Print the code points of all glyphs referenced by string literals in C
+# sources, as a comma separated list for lv_font_conv's --range option.
+# LV_SYMBOL_* macros are resolved through LVGL's symbol definitions.
+#
+# Usage: ./font-glyphs.py [--symbols | --text] SOURCE...
+#
+# --symbols prints only pictograms (FontAwesome's private use area), --text
+# prints everything else. Plain ASCII is skipped since it is always included.
+
+import re
+import sys
+
+SYMBOL_DEFINITIONS = 'lvgl/src/font/lv_symbol_def.h'
+
+# Start of the private use area FontAwesome lives in
+PRIVATE_USE_AREA = 0xE000
+
+STRING_LITERAL = re.compile(r'"((?:[^"\\\n]|\\.)*)"')
+SYMBOL_DEFINE = re.compile(r'#define\s+(LV_SYMBOL_\w+)\s+"((?:[^"\\]|\\.)*)"')
+SYMBOL_USE = re.compile(r'\bLV_SYMBOL_\w+\b')
+
+
+def unescape(literal):
+    """Turn the body of a C string literal into the UTF-8 bytes it denotes."""
+    out = bytearray()
+    i = 0
+    raw = literal.encode('utf-8')
+    while i < len(raw):
+        c = raw[i]
+        if c != ord('\\'):
+            out.append(c)
+            i += 1
+            continue
+
+        n = raw[i + 1:i + 2]
+        if n == b'x':
+            digits = re.match(rb'[0-9a-fA-F]+', raw[i + 2:]).group(0)
+            out.append(int(digits, 16) & 0xff)
+            i += 2 + len(digits)
+        elif n in b'01234567':
+            digits = re.match(rb'[0-7]{1,3}', raw[i + 1:]).group(0)
+            out.append(int(digits, 8) & 0xff)
+            i += 1 + len(digits)
+        else:
+            out += {b'n': b'\n', b't': b'\t', b'r': b'\r', b'0': b'\0'}.get(n, n)
+            i += 2
+    return bytes(out)
+
+
+def code_points(literal):
+    return {ord(c) for c in unescape(literal).decode('utf-8', errors='ignore')}
+
+
+def main():
+    args = sys.argv[1:]
+    mode = None
+    if args and args[0] in ('--symbols', '--text'):
+        mode = args.pop(0)
+    if not args:
+        sys.exit(f'Usage: {sys.argv[0]} [--symbols | --text] SOURCE...')
+
+    symbols = {}
+    with open(SYMBOL_DEFINITIONS) as f:
+        for name, literal in SYMBOL_DEFINE.findall(f.read()):
+            symbols[name] = literal
+
+    found = set()
+    for path in args:
+        with open(path, encoding='utf-8') as f:
+            source = f.read()
+        for literal in STRING_LITERAL.findall(source):
+            found |= code_points(literal)
+        for name in SYMBOL_USE.findall(source):
+            if name in symbols:
+                found |= code_points(symbols[name])
+
+    found = {c for c in found if c > 0x7e}
+    if mode == '--symbols':
+        found = {c for c in found if c >= PRIVATE_USE_AREA}
+    elif mode == '--text':
+        found = {c for c in found if c < PRIVATE_USE_AREA}
+
+    print(','.join(f'0x{c:04X}' for c in sorted(found)))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,43 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "fonts.h"
+
+#include "glyph_cache.h"
+
+/**
+ * Static variables
+ */
+
+/* font_32 is declared through LV_FONT_CUSTOM_DECLARE since it is LV_FONT_DEFAULT */
+static const lv_font_t *selected = &font_32;
+
+
+/**
+ * Public functions
+ */
+
+void fonts_init(uint16_t glyph_cache_size) {
+    selected = glyph_cache_wrap(&font_32, glyph_cache_size);
+}
+
+const lv_font_t *fonts_get(void) {
+    return selected;
+}
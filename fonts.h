@@ -0,0 +1,42 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef FONTS_H
+#define FONTS_H
+
+#include "lvgl/lvgl.h"
+
+#include <stdint.h>
+
+/**
+ * Set up the UI font, optionally behind a glyph cache.
+ *
+ * @param glyph_cache_size number of glyphs to cache, 0 to disable caching
+ */
+void fonts_init(uint16_t glyph_cache_size);
+
+/**
+ * Get the UI font. Returns the plain 32 px font until fonts_init() is called.
+ *
+ * @return the font
+ */
+const lv_font_t *fonts_get(void);
+
+#endif /* FONTS_H */
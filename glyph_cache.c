@@ -0,0 +1,356 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "glyph_cache.h"
+
+#include "log.h"
+#include "profile.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Defines
+ */
+
+/* Marks the end of a list of entries */
+#define GLYPH_CACHE_NONE UINT16_MAX
+/* Stands in for the next letter in the key of a bitmap entry, which doesn't depend on kerning */
+#define GLYPH_CACHE_BITMAP UINT32_MAX
+
+
+/**
+ * Static types
+ */
+
+/* A cached glyph descriptor or bitmap */
+typedef struct {
+    /* Code point */
+    uint32_t letter;
+    /* Following code point, affects kerning, or GLYPH_CACHE_BITMAP for bitmap entries */
+    uint32_t letter_next;
+    /* Result of the font's get_glyph_dsc */
+    bool found;
+    /* Descriptor returned by the font */
+    lv_font_glyph_dsc_t dsc;
+    /* Decompressed bitmap, owned by the entry */
+    uint8_t *bitmap;
+    /* True if the entry holds data */
+    bool used;
+    /* Next entry in the same hash bucket */
+    uint16_t bucket_next;
+    /* Neighbours in the recently used list */
+    uint16_t lru_prev;
+    uint16_t lru_next;
+} entry;
+
+/* Wrapped font. The font must stay first so LVGL's font pointer can be cast back. */
+typedef struct {
+    lv_font_t font;
+    /* The font being wrapped */
+    const lv_font_t *orig;
+    /* True if the font decompresses bitmaps on every lookup */
+    bool compressed;
+} cached_font;
+
+
+/**
+ * Static variables
+ */
+
+static cached_font wrapper;
+static entry *entries = NULL;
+static uint16_t num_entries = 0;
+static uint16_t *buckets = NULL;
+static uint16_t num_buckets = 0;
+/* Most and least recently used entries */
+static uint16_t lru_head = GLYPH_CACHE_NONE;
+static uint16_t lru_tail = GLYPH_CACHE_NONE;
+
+
+/**
+ * Static prototypes
+ */
+
+/**
+ * Get the hash bucket for a key.
+ *
+ * @param letter code point
+ * @param letter_next following code point
+ * @return bucket index
+ */
+static uint16_t bucket_of(uint32_t letter, uint32_t letter_next);
+
+/**
+ * Look up an entry and mark it as most recently used.
+ *
+ * @param letter code point
+ * @param letter_next following code point
+ * @return the entry or NULL if it isn't cached
+ */
+static entry *lookup(uint32_t letter, uint32_t letter_next);
+
+/**
+ * Unlink an entry from the recently used list.
+ *
+ * @param index entry index
+ */
+static void lru_unlink(uint16_t index);
+
+/**
+ * Insert an entry at the front of the recently used list.
+ *
+ * @param index entry index
+ */
+static void lru_push_front(uint16_t index);
+
+/**
+ * Evict the least recently used entry and reuse it for a new key.
+ *
+ * @param letter code point
+ * @param letter_next following code point
+ * @return the entry, marked as most recently used
+ */
+static entry *insert(uint32_t letter, uint32_t letter_next);
+
+/**
+ * Cached replacement for the font's get_glyph_dsc.
+ *
+ * @param font the wrapper
+ * @param dsc_out pointer for writing the descriptor into
+ * @param letter code point
+ * @param letter_next following code point
+ * @return true if the font has the glyph, false otherwise
+ */
+static bool cached_get_glyph_dsc(const lv_font_t *font, lv_font_glyph_dsc_t *dsc_out, uint32_t letter, uint32_t letter_next);
+
+/**
+ * Cached replacement for the font's get_glyph_bitmap.
+ *
+ * @param font the wrapper
+ * @param letter code point
+ * @return the bitmap or NULL if the font doesn't have the glyph
+ */
+static const uint8_t *cached_get_glyph_bitmap(const lv_font_t *font, uint32_t letter);
+
+/**
+ * Free all entries.
+ */
+static void clear(void);
+
+
+/**
+ * Static functions
+ */
+
+static uint16_t bucket_of(uint32_t letter, uint32_t letter_next) {
+    uint32_t hash = letter * 2654435761u ^ letter_next * 40503u;
+    return (hash >> 16) & (num_buckets - 1);
+}
+
+static entry *lookup(uint32_t letter, uint32_t letter_next) {
+    for (uint16_t i = buckets[bucket_of(letter, letter_next)]; i != GLYPH_CACHE_NONE; i = entries[i].bucket_next) {
+        if (entries[i].letter == letter && entries[i].letter_next == letter_next) {
+            if (i != lru_head) {
+                lru_unlink(i);
+                lru_push_front(i);
+            }
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+static void lru_unlink(uint16_t index) {
+    entry *e = &entries[index];
+
+    if (e->lru_prev != GLYPH_CACHE_NONE) {
+        entries[e->lru_prev].lru_next = e->lru_next;
+    } else {
+        lru_head = e->lru_next;
+    }
+
+    if (e->lru_next != GLYPH_CACHE_NONE) {
+        entries[e->lru_next].lru_prev = e->lru_prev;
+    } else {
+        lru_tail = e->lru_prev;
+    }
+}
+
+static void lru_push_front(uint16_t index) {
+    entry *e = &entries[index];
+
+    e->lru_prev = GLYPH_CACHE_NONE;
+    e->lru_next = lru_head;
+    if (lru_head != GLYPH_CACHE_NONE) {
+        entries[lru_head].lru_prev = index;
+    }
+    lru_head = index;
+    if (lru_tail == GLYPH_CACHE_NONE) {
+        lru_tail = index;
+    }
+}
+
+static entry *insert(uint32_t letter, uint32_t letter_next) {
+    /* All entries start out linked into the list, so the tail is either unused or the oldest */
+    const uint16_t index = lru_tail;
+    entry *e = &entries[index];
+
+    if (e->used) {
+        uint16_t *link = &buckets[bucket_of(e->letter, e->letter_next)];
+        while (*link != index) {
+            link = &entries[*link].bucket_next;
+        }
+        *link = e->bucket_next;
+        free(e->bitmap);
+    }
+
+    lru_unlink(index);
+    memset(e, 0, sizeof(entry));
+    e->letter = letter;
+    e->letter_next = letter_next;
+    e->used = true;
+
+    const uint16_t bucket = bucket_of(letter, letter_next);
+    e->bucket_next = buckets[bucket];
+    buckets[bucket] = index;
+    lru_push_front(index);
+
+    return e;
+}
+
+static bool cached_get_glyph_dsc(const lv_font_t *font, lv_font_glyph_dsc_t *dsc_out, uint32_t letter, uint32_t letter_next) {
+    const lv_font_t *orig = ((const cached_font *)font)->orig;
+
+    entry *e = lookup(letter, letter_next);
+    if (e != NULL) {
+        profile_count(PROFILE_COUNTER_GLYPH_CACHE_HIT);
+        *dsc_out = e->dsc;
+        return e->found;
+    }
+
+    profile_count(PROFILE_COUNTER_GLYPH_CACHE_MISS);
+    const bool found = orig->get_glyph_dsc(orig, dsc_out, letter, letter_next);
+
+    e = insert(letter, letter_next);
+    e->found = found;
+    e->dsc = *dsc_out;
+    return found;
+}
+
+static const uint8_t *cached_get_glyph_bitmap(const lv_font_t *font, uint32_t letter) {
+    const cached_font *cf = (const cached_font *)font;
+
+    /* Plain bitmaps are returned straight from the font data, there is nothing to save */
+    if (!cf->compressed) {
+        return cf->orig->get_glyph_bitmap(cf->orig, letter);
+    }
+
+    entry *e = lookup(letter, GLYPH_CACHE_BITMAP);
+    if (e != NULL) {
+        profile_count(PROFILE_COUNTER_GLYPH_CACHE_HIT);
+        return e->bitmap;
+    }
+
+    profile_count(PROFILE_COUNTER_GLYPH_CACHE_MISS);
+    const uint8_t *bitmap = cf->orig->get_glyph_bitmap(cf->orig, letter);
+    lv_font_glyph_dsc_t dsc;
+    if (bitmap == NULL || !cf->orig->get_glyph_dsc(cf->orig, &dsc, letter, 0)) {
+        return bitmap;
+    }
+
+    /* Same size as LVGL's decompression buffer, 3 bpp glyphs are decompressed to 4 bpp */
+    const size_t bpp = dsc.bpp == 3 ? 4 : dsc.bpp;
+    const size_t size = ((size_t)dsc.box_w * dsc.box_h * bpp + 7) / 8;
+    uint8_t *copy = malloc(size);
+    if (copy == NULL) {
+        /* The font's buffer stays valid until the next lookup, which is all LVGL needs */
+        return bitmap;
+    }
+    memcpy(copy, bitmap, size);
+
+    e = insert(letter, GLYPH_CACHE_BITMAP);
+    e->found = true;
+    e->bitmap = copy;
+    return copy;
+}
+
+static void clear(void) {
+    for (uint16_t i = 0; i < num_entries; ++i) {
+        free(entries[i].bitmap);
+    }
+    free(entries);
+    free(buckets);
+    entries = NULL;
+    buckets = NULL;
+    num_entries = 0;
+    num_buckets = 0;
+    lru_head = lru_tail = GLYPH_CACHE_NONE;
+}
+
+
+/**
+ * Public functions
+ */
+
+const lv_font_t *glyph_cache_wrap(const lv_font_t *font, uint16_t size) {
+    clear();
+
+    if (size == 0) {
+        return font;
+    }
+    /* The largest index marks the end of lists */
+    if (size == GLYPH_CACHE_NONE) {
+        --size;
+    }
+
+    num_buckets = 1;
+    while (num_buckets < size && num_buckets < 0x8000) {
+        num_buckets <<= 1;
+    }
+
+    entries = calloc(size, sizeof(entry));
+    buckets = malloc(num_buckets * sizeof(uint16_t));
+    if (entries == NULL || buckets == NULL) {
+        log_error("Could not allocate glyph cache");
+        clear();
+        return font;
+    }
+
+    num_entries = size;
+    for (uint16_t i = 0; i < num_buckets; ++i) {
+        buckets[i] = GLYPH_CACHE_NONE;
+    }
+    for (uint16_t i = 0; i < num_entries; ++i) {
+        lru_push_front(i);
+    }
+
+    wrapper.font = *font;
+    wrapper.font.get_glyph_dsc = cached_get_glyph_dsc;
+    wrapper.font.get_glyph_bitmap = cached_get_glyph_bitmap;
+    wrapper.orig = font;
+    wrapper.compressed = font->get_glyph_bitmap == lv_font_get_bitmap_fmt_txt
+        && ((const lv_font_fmt_txt_dsc_t *)font->dsc)->bitmap_format != LV_FONT_FMT_TXT_PLAIN;
+
+    log_info("Caching %u glyphs", (unsigned int)num_entries);
+    return &wrapper.font;
+}
@@ -0,0 +1,39 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef GLYPH_CACHE_H
+#define GLYPH_CACHE_H
+
+#include "lvgl/lvgl.h"
+
+#include <stdint.h>
+
+/**
+ * Wrap a font with a least recently used cache of glyph descriptors and, for compressed fonts,
+ * decompressed glyph bitmaps. Only one font can be wrapped at a time, wrapping another one
+ * discards the cache. Must be called from the LVGL thread before the font is used.
+ *
+ * @param font font to wrap
+ * @param size number of glyphs to cache
+ * @return the wrapped font, or font itself if size is 0 or the cache could not be allocated
+ */
+const lv_font_t *glyph_cache_wrap(const lv_font_t *font, uint16_t size);
+
+#endif /* GLYPH_CACHE_H */
@@ -0,0 +1,343 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "heap.h"
+
+#include "log.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+/**
+ * Defines
+ */
+
+/* Maximum total size of LVGL's heap allocations in bytes, 0 for no limit */
+#ifndef HEAP_LIMIT
+#define HEAP_LIMIT 0
+#endif
+
+/* Alignment of all allocations, matches malloc on 64 bit */
+#define HEAP_ALIGN 16
+/* Maximum number of arenas that can be initialised */
+#define HEAP_MAX_ARENAS 4
+
+
+/**
+ * Static types
+ */
+
+/* Prefix of every allocation, padded to keep the payload aligned */
+typedef union {
+    /* Requested size of the allocation */
+    size_t size;
+    unsigned char pad[HEAP_ALIGN];
+} header;
+
+
+/**
+ * Static variables
+ */
+
+static size_t heap_current = 0;
+static size_t heap_peak = 0;
+static size_t heap_allocs = 0;
+static size_t heap_failed = 0;
+
+static heap_arena *arenas[HEAP_MAX_ARENAS];
+static int num_arenas = 0;
+static heap_arena *active_arena = NULL;
+
+
+/**
+ * Static prototypes
+ */
+
+/**
+ * Round a size up to the allocation alignment.
+ *
+ * @param size size in bytes
+ * @return rounded size
+ */
+static size_t align_up(size_t size);
+
+/**
+ * Find the arena an allocation belongs to.
+ *
+ * @param h header of the allocation
+ * @return the arena or NULL if the allocation is on the main heap
+ */
+static heap_arena *find_arena(const header *h);
+
+/**
+ * Allocate from the main heap.
+ *
+ * @param size number of bytes
+ * @return header of the allocation or NULL on failure
+ */
+static header *main_alloc(size_t size);
+
+/**
+ * Allocate from an arena.
+ *
+ * @param arena the arena
+ * @param size number of bytes
+ * @return header of the allocation or NULL if the arena is full
+ */
+static header *arena_alloc(heap_arena *arena, size_t size);
+
+/**
+ * Free an allocation of an arena.
+ *
+ * @param arena the arena
+ * @param h header of the allocation
+ */
+static void arena_free(heap_arena *arena, header *h);
+
+/**
+ * Check whether an allocation is the last one of its arena.
+ *
+ * @param arena the arena
+ * @param h header of the allocation
+ * @return true if nothing was allocated after it
+ */
+static bool is_arena_top(const heap_arena *arena, const header *h);
+
+
+/**
+ * Static functions
+ */
+
+static size_t align_up(size_t size) {
+    return (size + HEAP_ALIGN - 1) & ~(size_t)(HEAP_ALIGN - 1);
+}
+
+static heap_arena *find_arena(const header *h) {
+    const unsigned char *p = (const unsigned char *)h;
+    for (int i = 0; i < num_arenas; ++i) {
+        if (p >= arenas[i]->base && p < arenas[i]->base + arenas[i]->size) {
+            return arenas[i];
+        }
+    }
+    return NULL;
+}
+
+static header *main_alloc(size_t size) {
+    if (HEAP_LIMIT > 0 && heap_current + size > (size_t)HEAP_LIMIT) {
+        ++heap_failed;
+        return NULL;
+    }
+
+    header *h = malloc(sizeof(header) + size);
+    if (h == NULL) {
+        ++heap_failed;
+        return NULL;
+    }
+
+    h->size = size;
+    heap_current += size;
+    ++heap_allocs;
+    if (heap_current > heap_peak) {
+        heap_peak = heap_current;
+    }
+    return h;
+}
+
+static header *arena_alloc(heap_arena *arena, size_t size) {
+    const size_t total = sizeof(header) + align_up(size);
+    if (arena->top + total > arena->size) {
+        return NULL;
+    }
+
+    header *h = (header *)(arena->base + arena->top);
+    h->size = size;
+    arena->top += total;
+    ++arena->live;
+    arena->live_bytes += size;
+    if (arena->top > arena->peak) {
+        arena->peak = arena->top;
+    }
+    return h;
+}
+
+static bool is_arena_top(const heap_arena *arena, const header *h) {
+    return (const unsigned char *)h + sizeof(header) + align_up(h->size) == arena->base + arena->top;
+}
+
+static void arena_free(heap_arena *arena, header *h) {
+    --arena->live;
+    arena->live_bytes -= h->size;
+
+    /* Give the space back right away if possible, this keeps reallocated buffers compact */
+    if (is_arena_top(arena, h)) {
+        arena->top = (unsigned char *)h - arena->base;
+    }
+    if (arena->live == 0) {
+        arena->top = 0;
+    }
+}
+
+
+/**
+ * Public functions
+ */
+
+void *heap_alloc(size_t size) {
+    header *h = active_arena != NULL ? arena_alloc(active_arena, size) : NULL;
+    if (h == NULL) {
+        h = main_alloc(size);
+    }
+    return h != NULL ? h + 1 : NULL;
+}
+
+void heap_free(void *p) {
+    if (p == NULL) {
+        return;
+    }
+
+    header *h = (header *)p - 1;
+    heap_arena *arena = find_arena(h);
+    if (arena != NULL) {
+        arena_free(arena, h);
+        return;
+    }
+
+    heap_current -= h->size;
+    free(h);
+}
+
+void *heap_realloc(void *p, size_t size) {
+    if (p == NULL) {
+        return heap_alloc(size);
+    }
+    if (size == 0) {
+        heap_free(p);
+        return NULL;
+    }
+
+    header *h = (header *)p - 1;
+    heap_arena *arena = find_arena(h);
+
+    if (arena == NULL) {
+        if (size > h->size && HEAP_LIMIT > 0 && heap_current + (size - h->size) > (size_t)HEAP_LIMIT) {
+            ++heap_failed;
+            return NULL;
+        }
+
+        const size_t old_size = h->size;
+        header *resized = realloc(h, sizeof(header) + size);
+        if (resized == NULL) {
+            ++heap_failed;
+            return NULL;
+        }
+
+        resized->size = size;
+        heap_current = heap_current - old_size + size;
+        if (heap_current > heap_peak) {
+            heap_peak = heap_current;
+        }
+        return resized + 1;
+    }
+
+    /* Resize in place if the allocation still fits its slot or is the last one of the arena */
+    const size_t old_size = h->size;
+    const bool is_top = is_arena_top(arena, h);
+    const size_t end = (unsigned char *)(h + 1) - arena->base + align_up(size);
+    if (align_up(size) <= align_up(old_size) || (is_top && end <= arena->size)) {
+        h->size = size;
+        arena->live_bytes = arena->live_bytes - old_size + size;
+        if (is_top) {
+            arena->top = end;
+            if (arena->top > arena->peak) {
+                arena->peak = arena->top;
+            }
+        }
+        return p;
+    }
+
+    void *moved = heap_alloc(size);
+    if (moved == NULL) {
+        return NULL;
+    }
+    memcpy(moved, p, old_size);
+    arena_free(arena, h);
+    return moved;
+}
+
+bool heap_arena_init(heap_arena *arena, size_t size) {
+    if (num_arenas == HEAP_MAX_ARENAS) {
+        log_error("Too many heap arenas");
+        return false;
+    }
+
+    memset(arena, 0, sizeof(heap_arena));
+    arena->base = aligned_alloc(HEAP_ALIGN, align_up(size));
+    if (arena->base == NULL) {
+        log_error("Could not allocate heap arena of %zu bytes", size);
+        return false;
+    }
+
+    arena->size = align_up(size);
+    arenas[num_arenas++] = arena;
+    return true;
+}
+
+void heap_arena_enter(heap_arena *arena) {
+    active_arena = arena->base != NULL ? arena : NULL;
+}
+
+void heap_arena_leave(void) {
+    active_arena = NULL;
+}
+
+bool heap_arena_reset(heap_arena *arena) {
+    if (arena->live > 0) {
+        return false;
+    }
+
+    arena->top = 0;
+    return true;
+}
+
+void heap_print_stats(FILE *out) {
+    fprintf(out, "heap current=%zu peak=%zu allocs=%zu failed=%zu limit=%zu\n",
+        heap_current, heap_peak, heap_allocs, heap_failed, (size_t)HEAP_LIMIT);
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    /* malloc is shared with the rest of the program, so this covers more than LVGL */
+    struct mallinfo2 info = mallinfo2();
+    const size_t total = info.arena + info.hblkhd;
+    fprintf(out, "heap process_total=%zu process_free=%zu fragmentation_pct=%zu\n",
+        total, info.fordblks, total > 0 ? info.fordblks * 100 / total : 0);
+#endif
+
+    for (int i = 0; i < num_arenas; ++i) {
+        const heap_arena *arena = arenas[i];
+        /* Space below the top that belongs to freed allocations can't be reused until a reset */
+        const size_t dead = arena->top > arena->live_bytes ? arena->top - arena->live_bytes : 0;
+        fprintf(out, "heap arena=%d size=%zu peak=%zu live=%zu live_bytes=%zu fragmentation_pct=%zu\n",
+            i, arena->size, arena->peak, arena->live, arena->live_bytes, arena->top > 0 ? dead * 100 / arena->top : 0);
+    }
+}
@@ -0,0 +1,112 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef HEAP_H
+#define HEAP_H
+
+/* NOTE: This header is included from lv_conf.h and must not include LVGL */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/**
+ * Arena for the allocations of a screen. Allocations are bumped off a single block and freeing
+ * them only counts them down, so nothing the screen allocates fragments the main heap.
+ */
+typedef struct {
+    /* Backing memory, NULL until heap_arena_init */
+    unsigned char *base;
+    /* Size of the backing memory */
+    size_t size;
+    /* Offset of the next allocation */
+    size_t top;
+    /* Number of allocations that weren't freed yet */
+    size_t live;
+    /* Bytes of the allocations that weren't freed yet */
+    size_t live_bytes;
+    /* Highest top since the arena was initialised */
+    size_t peak;
+} heap_arena;
+
+/**
+ * Allocate memory for LVGL. Used as LV_MEM_CUSTOM_ALLOC.
+ *
+ * @param size number of bytes
+ * @return the memory or NULL on failure or if the heap limit would be exceeded
+ */
+void *heap_alloc(size_t size);
+
+/**
+ * Free memory allocated with heap_alloc. Used as LV_MEM_CUSTOM_FREE.
+ *
+ * @param p the memory, may be NULL
+ */
+void heap_free(void *p);
+
+/**
+ * Resize memory allocated with heap_alloc. Used as LV_MEM_CUSTOM_REALLOC.
+ *
+ * @param p the memory, may be NULL
+ * @param size new number of bytes
+ * @return the resized memory or NULL on failure, in which case p stays valid
+ */
+void *heap_realloc(void *p, size_t size);
+
+/**
+ * Allocate the backing memory of an arena.
+ *
+ * @param arena the arena
+ * @param size number of bytes, allocations beyond it fall back to the main heap
+ * @return true on success, false otherwise
+ */
+bool heap_arena_init(heap_arena *arena, size_t size);
+
+/**
+ * Route all following allocations into an arena until heap_arena_leave is called. Arenas don't
+ * nest.
+ *
+ * @param arena the arena
+ */
+void heap_arena_enter(heap_arena *arena);
+
+/**
+ * Route allocations to the main heap again.
+ */
+void heap_arena_leave(void);
+
+/**
+ * Rewind an arena after everything allocated in it was freed. If allocations are still alive,
+ * something long-lived was allocated while the arena was active. The arena is then left as is so
+ * they stay valid, and later allocations bump it further until they fall back to the main heap.
+ *
+ * @param arena the arena
+ * @return true if the arena was rewound, false if it still holds live allocations
+ */
+bool heap_arena_reset(heap_arena *arena);
+
+/**
+ * Write current and peak usage plus fragmentation figures of the main heap and all arenas.
+ *
+ * @param out stream to write to
+ */
+void heap_print_stats(FILE *out);
+
+#endif /* HEAP_H */
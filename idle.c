@@ -0,0 +1,212 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "idle.h"
+
+#include "backlight.h"
+
+#include "lvgl/lvgl.h"
+
+#include <stdio.h>
+
+/**
+ * Defines
+ */
+
+/* Brightness while dimmed, in percent of the brightness before */
+#define IDLE_DIM_PERCENT 20
+
+
+/**
+ * Static types
+ */
+
+typedef enum {
+    STATE_ACTIVE,
+    STATE_DIMMED,
+    STATE_BLANK
+} idle_state;
+
+
+/**
+ * Static variables
+ */
+
+static uint32_t dim_ms = 0;
+static uint32_t blank_ms = 0;
+static uint32_t timeout_ms = 0;
+static void (*on_timeout)(void) = NULL;
+
+static lv_timer_t *timer = NULL;
+static idle_state state = STATE_ACTIVE;
+/* Tick of the last input */
+static uint32_t last_input = 0;
+/* True once the timeout callback ran in the current idle period */
+static bool timed_out = false;
+/* Brightness to go back to after dimming */
+static int saved_brightness = 0;
+
+
+/**
+ * Static prototypes
+ */
+
+/**
+ * Get the next deadline after some idle time.
+ *
+ * @param idle_ms time since the last input
+ * @return time until the next deadline, 0 if none is left
+ */
+static uint32_t next_deadline(uint32_t idle_ms);
+
+/**
+ * Dim or turn off the backlight and stop drawing while blank.
+ *
+ * @param new_state STATE_DIMMED or STATE_BLANK
+ */
+static void enter(idle_state new_state);
+
+/**
+ * Restore the brightness and resume drawing.
+ */
+static void leave(void);
+
+/**
+ * Apply every deadline that passed and wait for the next one.
+ *
+ * @param t the timer
+ */
+static void timer_cb(lv_timer_t *t);
+
+
+/**
+ * Static functions
+ */
+
+static uint32_t next_deadline(uint32_t idle_ms) {
+    const uint32_t deadlines[] = {
+        state < STATE_DIMMED ? dim_ms : 0,
+        state < STATE_BLANK ? blank_ms : 0,
+        timed_out ? 0 : timeout_ms
+    };
+
+    uint32_t next = 0;
+    for (size_t i = 0; i < sizeof(deadlines) / sizeof(deadlines[0]); ++i) {
+        if (deadlines[i] > idle_ms && (next == 0 || deadlines[i] - idle_ms < next)) {
+            next = deadlines[i] - idle_ms;
+        }
+    }
+    return next;
+}
+
+static void enter(idle_state new_state) {
+    if (state == STATE_ACTIVE) {
+        saved_brightness = backlight_get();
+    }
+
+    lv_disp_t *disp = lv_disp_get_default();
+    if (new_state == STATE_BLANK) {
+        backlight_set(0);
+        /* Nothing is visible, so nothing needs to be drawn until the screen comes back */
+        lv_timer_pause(disp->refr_timer);
+    } else {
+        const int dimmed = saved_brightness * IDLE_DIM_PERCENT / 100;
+        backlight_set(dimmed > 0 ? dimmed : 1);
+    }
+
+    state = new_state;
+}
+
+static void leave(void) {
+    if (state == STATE_BLANK) {
+        lv_disp_t *disp = lv_disp_get_default();
+        lv_timer_resume(disp->refr_timer);
+        lv_timer_ready(disp->refr_timer);
+    }
+
+    backlight_set(saved_brightness);
+    state = STATE_ACTIVE;
+}
+
+static void timer_cb(lv_timer_t *t) {
+    const uint32_t idle_ms = lv_tick_elaps(last_input);
+
+    if (!timed_out && timeout_ms > 0 && idle_ms >= timeout_ms) {
+        timed_out = true;
+        /* Whatever the callback shows has to be visible */
+        if (state != STATE_ACTIVE) {
+            leave();
+        }
+        if (on_timeout != NULL) {
+            on_timeout();
+        }
+    } else if (state < STATE_BLANK && blank_ms > 0 && idle_ms >= blank_ms) {
+        enter(STATE_BLANK);
+    } else if (state < STATE_DIMMED && dim_ms > 0 && idle_ms >= dim_ms) {
+        enter(STATE_DIMMED);
+    }
+
+    const uint32_t next = next_deadline(idle_ms);
+    if (next == 0) {
+        /* Nothing left to do until the next input */
+        lv_timer_pause(t);
+        return;
+    }
+    lv_timer_set_period(t, next);
+    lv_timer_reset(t);
+    lv_timer_resume(t);
+}
+
+
+/**
+ * Public functions
+ */
+
+void idle_init(uint16_t dim_s, uint16_t blank_s, uint16_t timeout_s, void (*timeout_cb)(void)) {
+    dim_ms = (uint32_t)dim_s * 1000;
+    blank_ms = (uint32_t)blank_s * 1000;
+    timeout_ms = (uint32_t)timeout_s * 1000;
+    on_timeout = timeout_cb;
+    last_input = lv_tick_get();
+
+    if (timer == NULL && (dim_ms > 0 || blank_ms > 0 || timeout_ms > 0)) {
+        timer = lv_timer_create(timer_cb, 0, NULL);
+        timer_cb(timer);
+    }
+}
+
+bool idle_notify_input(void) {
+    const bool was_blank = state == STATE_BLANK;
+
+    last_input = lv_tick_get();
+    timed_out = false;
+    if (state != STATE_ACTIVE) {
+        leave();
+    }
+
+    /* The timer only wakes for deadlines, it picks up the new idle period from last_input */
+    if (timer != NULL && timer->paused) {
+        lv_timer_set_period(timer, next_deadline(0));
+        lv_timer_reset(timer);
+        lv_timer_resume(timer);
+    }
+
+    return was_blank;
+}
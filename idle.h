@@ -0,0 +1,46 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef IDLE_H
+#define IDLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Start tracking input. Without input, the backlight is dimmed after dim_s seconds and turned
+ * off after blank_s seconds, at which point drawing stops until the next input. After timeout_s
+ * seconds, timeout_cb is called. Must be called after backlight_init.
+ *
+ * @param dim_s seconds until the backlight is dimmed, 0 to never dim
+ * @param blank_s seconds until the backlight is turned off, 0 to never turn it off
+ * @param timeout_s seconds until timeout_cb is called, 0 to never call it
+ * @param timeout_cb called once per idle period with the screen turned back on, may be NULL
+ */
+void idle_init(uint16_t dim_s, uint16_t blank_s, uint16_t timeout_s, void (*timeout_cb)(void));
+
+/**
+ * Report input. Turns the screen back on if it was dimmed or blank.
+ *
+ * @return true if the screen was blank, in which case the input should only wake it
+ */
+bool idle_notify_input(void);
+
+#endif /* IDLE_H */
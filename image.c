@@ -0,0 +1,288 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "image.h"
+
+#include "log.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Defines
+ */
+
+/* Number of images that can be decoded at the same time */
+#define IMAGE_CACHE_SIZE 4
+
+
+/**
+ * Static types
+ */
+
+/* A decoded image */
+typedef struct {
+    /* Encoded source, NULL if the slot is free */
+    const image_rle_t *image;
+    /* Descriptor handed to LVGL */
+    lv_img_dsc_t dsc;
+    /* Decoded pixels */
+    uint8_t *data;
+} cache_slot;
+
+
+/**
+ * Static variables
+ */
+
+static cache_slot cache[IMAGE_CACHE_SIZE];
+
+
+/**
+ * Static prototypes
+ */
+
+/**
+ * Expand the runs of an image into one 0xAARRGGBB value per pixel.
+ *
+ * @param image encoded image
+ * @param argb pointer for writing width * height pixels into
+ * @return true on success, false if the runs are corrupt
+ */
+static bool decode_runs(const image_rle_t *image, uint32_t *argb);
+
+/**
+ * Downscale an image with a box filter.
+ *
+ * @param src source pixels as 0xAARRGGBB
+ * @param src_w source width
+ * @param src_h source height
+ * @param dst pointer for writing dst_w * dst_h pixels into
+ * @param dst_w destination width
+ * @param dst_h destination height
+ */
+static void downscale(const uint32_t *src, uint32_t src_w, uint32_t src_h, uint32_t *dst, uint32_t dst_w, uint32_t dst_h);
+
+/**
+ * Store a pixel in LVGL's native format.
+ *
+ * @param dst pointer to the pixel
+ * @param argb color as 0xAARRGGBB
+ * @param has_alpha true if the image format carries an alpha byte
+ */
+static void store_pixel(uint8_t *dst, uint32_t argb, bool has_alpha);
+
+/**
+ * Decode an image into a cache slot.
+ *
+ * @param slot free cache slot
+ * @param image encoded image
+ * @param max_width maximum width of the decoded image
+ * @param max_height maximum height of the decoded image
+ * @return true on success, false otherwise
+ */
+static bool decode(cache_slot *slot, const image_rle_t *image, lv_coord_t max_width, lv_coord_t max_height);
+
+/**
+ * Free a cache slot and tell LVGL to forget about its image.
+ *
+ * @param slot the slot
+ */
+static void free_slot(cache_slot *slot);
+
+
+/**
+ * Static functions
+ */
+
+static bool decode_runs(const image_rle_t *image, uint32_t *argb) {
+    const size_t num_pixels = (size_t)image->width * image->height;
+    size_t pos = 0;
+
+    for (uint32_t i = 0; i + 1 < image->runs_size; i += 2) {
+        const uint8_t index = image->runs[i];
+        const size_t length = (size_t)image->runs[i + 1] + 1;
+
+        if (index >= image->palette_size || pos + length > num_pixels) {
+            return false;
+        }
+
+        const uint32_t color = image->palette[index];
+        for (size_t j = 0; j < length; ++j) {
+            argb[pos++] = color;
+        }
+    }
+
+    return pos == num_pixels;
+}
+
+static void downscale(const uint32_t *src, uint32_t src_w, uint32_t src_h, uint32_t *dst, uint32_t dst_w, uint32_t dst_h) {
+    for (uint32_t y = 0; y < dst_h; ++y) {
+        const uint32_t y0 = y * src_h / dst_h;
+        const uint32_t y1 = LV_MAX((y + 1) * src_h / dst_h, y0 + 1);
+
+        for (uint32_t x = 0; x < dst_w; ++x) {
+            const uint32_t x0 = x * src_w / dst_w;
+            const uint32_t x1 = LV_MAX((x + 1) * src_w / dst_w, x0 + 1);
+
+            /* Weigh colors by alpha so transparent pixels don't darken the edges */
+            uint64_t a = 0, r = 0, g = 0, b = 0;
+            for (uint32_t sy = y0; sy < y1; ++sy) {
+                for (uint32_t sx = x0; sx < x1; ++sx) {
+                    const uint32_t p = src[sy * src_w + sx];
+                    const uint32_t pa = p >> 24;
+                    a += pa;
+                    r += pa * ((p >> 16) & 0xff);
+                    g += pa * ((p >> 8) & 0xff);
+                    b += pa * (p & 0xff);
+                }
+            }
+
+            const uint32_t count = (y1 - y0) * (x1 - x0);
+            uint32_t out = (uint32_t)(a / count) << 24;
+            if (a > 0) {
+                out |= (uint32_t)(r / a) << 16 | (uint32_t)(g / a) << 8 | (uint32_t)(b / a);
+            }
+            dst[y * dst_w + x] = out;
+        }
+    }
+}
+
+static void store_pixel(uint8_t *dst, uint32_t argb, bool has_alpha) {
+    lv_color_t color = lv_color_make((argb >> 16) & 0xff, (argb >> 8) & 0xff, argb & 0xff);
+    memcpy(dst, &color, sizeof(lv_color_t));
+    if (has_alpha) {
+        dst[LV_IMG_PX_SIZE_ALPHA_BYTE - 1] = argb >> 24;
+    }
+}
+
+static bool decode(cache_slot *slot, const image_rle_t *image, lv_coord_t max_width, lv_coord_t max_height) {
+    const uint32_t src_w = image->width;
+    const uint32_t src_h = image->height;
+    uint32_t dst_w = src_w;
+    uint32_t dst_h = src_h;
+
+    /* Fit into the bounds once here rather than having LVGL zoom on every frame */
+    if (max_width > 0 && max_height > 0 && (src_w > (uint32_t)max_width || src_h > (uint32_t)max_height)) {
+        if (src_w * (uint32_t)max_height > src_h * (uint32_t)max_width) {
+            dst_w = max_width;
+            dst_h = LV_MAX(src_h * dst_w / src_w, 1);
+        } else {
+            dst_h = max_height;
+            dst_w = LV_MAX(src_w * dst_h / src_h, 1);
+        }
+    }
+
+    bool has_alpha = false;
+    for (uint16_t i = 0; i < image->palette_size; ++i) {
+        if ((image->palette[i] >> 24) != 0xff) {
+            has_alpha = true;
+            break;
+        }
+    }
+
+    uint32_t *argb = malloc((size_t)src_w * src_h * sizeof(uint32_t));
+    if (argb == NULL) {
+        log_error("Could not allocate memory for decoding image");
+        return false;
+    }
+
+    if (!decode_runs(image, argb)) {
+        log_error("Could not decode image, the encoded data is corrupt");
+        free(argb);
+        return false;
+    }
+
+    if (dst_w != src_w || dst_h != src_h) {
+        uint32_t *scaled = malloc((size_t)dst_w * dst_h * sizeof(uint32_t));
+        if (scaled == NULL) {
+            log_error("Could not allocate memory for scaling image");
+            free(argb);
+            return false;
+        }
+        downscale(argb, src_w, src_h, scaled, dst_w, dst_h);
+        free(argb);
+        argb = scaled;
+    }
+
+    const size_t px_size = has_alpha ? LV_IMG_PX_SIZE_ALPHA_BYTE : sizeof(lv_color_t);
+    const size_t data_size = (size_t)dst_w * dst_h * px_size;
+    uint8_t *data = malloc(data_size);
+    if (data == NULL) {
+        log_error("Could not allocate memory for image");
+        free(argb);
+        return false;
+    }
+
+    for (size_t i = 0; i < (size_t)dst_w * dst_h; ++i) {
+        store_pixel(data + i * px_size, argb[i], has_alpha);
+    }
+    free(argb);
+
+    memset(slot, 0, sizeof(cache_slot));
+    slot->image = image;
+    slot->data = data;
+    slot->dsc.header.cf = has_alpha ? LV_IMG_CF_TRUE_COLOR_ALPHA : LV_IMG_CF_TRUE_COLOR;
+    slot->dsc.header.w = dst_w;
+    slot->dsc.header.h = dst_h;
+    slot->dsc.data_size = data_size;
+    slot->dsc.data = data;
+    return true;
+}
+
+static void free_slot(cache_slot *slot) {
+    lv_img_cache_invalidate_src(&slot->dsc);
+    free(slot->data);
+    memset(slot, 0, sizeof(cache_slot));
+}
+
+
+/**
+ * Public functions
+ */
+
+const lv_img_dsc_t *image_get(const image_rle_t *image, lv_coord_t max_width, lv_coord_t max_height) {
+    cache_slot *free_slot_p = NULL;
+
+    for (int i = 0; i < IMAGE_CACHE_SIZE; ++i) {
+        if (cache[i].image == image) {
+            return &cache[i].dsc;
+        }
+        if (cache[i].image == NULL && free_slot_p == NULL) {
+            free_slot_p = &cache[i];
+        }
+    }
+
+    if (free_slot_p == NULL) {
+        log_error("Too many decoded images, not decoding another one");
+        return NULL;
+    }
+
+    return decode(free_slot_p, image, max_width, max_height) ? &free_slot_p->dsc : NULL;
+}
+
+void image_release(const image_rle_t *image) {
+    for (int i = 0; i < IMAGE_CACHE_SIZE; ++i) {
+        if (cache[i].image == image) {
+            free_slot(&cache[i]);
+        }
+    }
+}
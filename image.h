@@ -0,0 +1,65 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include "lvgl/lvgl.h"
+
+#include <stdint.h>
+
+/**
+ * Palette based, run-length encoded image as generated by images/encode-image.py
+ */
+typedef struct {
+    /* Width in pixels */
+    uint16_t width;
+    /* Height in pixels */
+    uint16_t height;
+    /* Number of palette entries */
+    uint16_t palette_size;
+    /* Colors as 0xAARRGGBB */
+    const uint32_t *palette;
+    /* Size of runs in bytes */
+    uint32_t runs_size;
+    /* Pairs of (palette index, run length - 1) in row-major order */
+    const uint8_t *runs;
+} image_rle_t;
+
+/**
+ * Get an image decoded for use with lv_img_set_src(). The image is decoded on the first call and
+ * downscaled, keeping its aspect ratio, if it exceeds the given bounds. Later calls return the
+ * cached result until the image is released.
+ *
+ * @param image encoded image
+ * @param max_width maximum width of the decoded image
+ * @param max_height maximum height of the decoded image
+ * @return image descriptor or NULL on error
+ */
+const lv_img_dsc_t *image_get(const image_rle_t *image, lv_coord_t max_width, lv_coord_t max_height);
+
+/**
+ * Free the decoded pixels of an image. The image must not be in use by any object anymore.
+ *
+ * @param image encoded image
+ */
+void image_release(const image_rle_t *image);
+
+#endif /* IMAGE_H */
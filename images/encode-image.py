@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+# Copyright 2026 FuriLabs
+# SPDX-License-Identifier: GPL-3.0-or-later
+#
+# Convert an image into the palette + run-length encoded C source decoded by
+# image.c. The input is either a PNG (requires Pillow) or a C array produced
+# by LVGL's image converter in true color format, of which the 32 bit section
+# is used.
+#
+# Usage: ./encode-image.py INPUT NAME > NAME.c
+
+import re
+import sys
+
+# Longest run a single record can hold
+MAX_RUN = 256
+# Largest palette a run record can index
+MAX_PALETTE = 256
+
+
+def read_lvgl_c_array(path):
+    """Return (width, height, [argb, ...]) from an LVGL true color C array."""
+    source = open(path).read()
+
+    width = int(re.search(r'\.header\.w\s*=\s*(\d+)', source).group(1))
+    height = int(re.search(r'\.header\.h\s*=\s*(\d+)', source).group(1))
+
+    section = re.search(r'#if LV_COLOR_DEPTH == 32\n(.*?)#endif', source, re.S)
+    if section is None:
+        sys.exit(f'{path}: no 32 bit color section found')
+    body = re.sub(r'/\*.*?\*/', '', section.group(1), flags=re.S)
+    data = bytes(int(x, 16) for x in re.findall(r'0x([0-9a-fA-F]{2})', body))
+
+    if len(data) != width * height * 4:
+        sys.exit(f'{path}: expected {width * height * 4} bytes, found {len(data)}')
+
+    # Pixels are stored as little endian lv_color32_t: blue, green, red, alpha
+    pixels = [data[i + 3] << 24 | data[i + 2] << 16 | data[i + 1] << 8 | data[i] for i in range(0, len(data), 4)]
+    return width, height, pixels
+
+
+def read_png(path):
+    """Return (width, height, [argb, ...]) from a PNG."""
+    from PIL import Image
+
+    image = Image.open(path).convert('RGBA')
+    pixels = [a << 24 | r << 16 | g << 8 | b for r, g, b, a in image.getdata()]
+    return image.width, image.height, pixels
+
+
+def encode(pixels):
+    """Return (palette, runs) where runs is a flat list of (index, length - 1) pairs."""
+    palette = []
+    lookup = {}
+    runs = []
+
+    i = 0
+    while i < len(pixels):
+        color = pixels[i]
+        length = 1
+        while i + length < len(pixels) and pixels[i + length] == color and length < MAX_RUN:
+            length += 1
+
+        if color not in lookup:
+            if len(palette) == MAX_PALETTE:
+                sys.exit(f'More than {MAX_PALETTE} colors, quantize the image first')
+            lookup[color] = len(palette)
+            palette.append(color)
+
+        runs += [lookup[color], length - 1]
+        i += length
+
+    return palette, runs
+
+
+def emit(name, width, height, palette, runs):
+    print('/* Generated by images/encode-image.py, do not edit */')
+    print()
+    print('#include "../image.h"')
+    print()
+    print(f'static const uint32_t {name}_palette[] = {{')
+    for i in range(0, len(palette), 8):
+        print('  ' + ', '.join(f'0x{c:08x}' for c in palette[i:i + 8]) + ',')
+    print('};')
+    print()
+    print(f'static const uint8_t {name}_runs[] = {{')
+    for i in range(0, len(runs), 24):
+        print('  ' + ', '.join(f'0x{b:02x}' for b in runs[i:i + 24]) + ',')
+    print('};')
+    print()
+    print(f'const image_rle_t {name} = {{')
+    print(f'  .width = {width},')
+    print(f'  .height = {height},')
+    print(f'  .palette_size = {len(palette)},')
+    print(f'  .palette = {name}_palette,')
+    print(f'  .runs_size = sizeof({name}_runs),')
+    print(f'  .runs = {name}_runs,')
+    print('};')
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit(f'Usage: {sys.argv[0]} INPUT NAME > NAME.c')
+
+    path, name = sys.argv[1:]
+    if path.endswith('.png'):
+        width, height, pixels = read_png(path)
+    else:
+        width, height, pixels = read_lvgl_c_array(path)
+
+    palette, runs = encode(pixels)
+    emit(name, width, height, palette, runs)
+
+
+if __name__ == '__main__':
+    main()
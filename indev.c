@@ -21,42 +21,112 @@
 #include "indev.h"
 
 #include "cursor.h"
-
-#include "lv_drivers/indev/libinput_drv.h"
-
+#include "event_loop.h"
+#include "idle.h"
+#include "log.h"
+#include "profile.h"
+
+#include "lv_drivers/indev/xkb.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <libinput.h>
+#include <libudev.h>
 #include <limits.h>
+#include <linux/input-event-codes.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 /**
  * Defines
  */
 
-#define MAX_KEYBOARD_DEVS 4
-#define MAX_POINTER_DEVS 4
-#define MAX_TOUCHSCREEN_DEVS 2
+#define INPUT_DEV_PATH "/dev/input"
+#define SEAT "seat0"
+/* Number of input samples a device can queue between reads */
+#define INDEV_QUEUE_SIZE 16
+
+
+/**
+ * Static types
+ */
+
+/* Kinds of LVGL input devices a libinput device can provide */
+typedef enum {
+    KIND_KEYBOARD,
+    KIND_POINTER,
+    KIND_TOUCHSCREEN,
+    NUM_KINDS
+} kind;
+
+/* State of an input device at the time of a libinput event */
+typedef struct {
+    lv_indev_state_t state;
+    lv_point_t point;
+    uint32_t key;
+    /* Event time in microseconds on the monotonic clock */
+    uint64_t time_us;
+    /* True if the sample only moved the point of the previous one */
+    bool is_motion;
+} sample;
+
+/* LVGL input device for one capability of a libinput device */
+typedef struct {
+    lv_indev_drv_t drv;
+    /* NULL if the device doesn't provide this kind */
+    lv_indev_t *indev;
+    /* Last state reported to LVGL */
+    sample current;
+    /* States that arrived since the last read, oldest first */
+    sample queue[INDEV_QUEUE_SIZE];
+    int queue_head;
+    int queue_count;
+    /* True while the press that turned the screen back on is held, it isn't passed on */
+    bool is_waking;
+} handle;
+
+/* A connected libinput device */
+typedef struct device {
+    struct libinput_device *libinput_device;
+    handle handles[NUM_KINDS];
+    xkb_drv_state_t xkb_state;
+    struct device *next;
+} device;
 
 
 /**
  * Static variables
  */
 
-static int num_keyboard_devs = 0;
-static char *keyboard_devs[MAX_KEYBOARD_DEVS];
-static lv_indev_t *keyboard_indevs[MAX_KEYBOARD_DEVS];
-static lv_indev_drv_t keyboard_indev_drvs[MAX_KEYBOARD_DEVS];
-static libinput_drv_state_t keyboard_drv_states[MAX_KEYBOARD_DEVS];
+static const char *kind_names[NUM_KINDS] = { "keyboard", "pointer", "touchscreen" };
+static const enum libinput_device_capability kind_capabilities[NUM_KINDS] = {
+    LIBINPUT_DEVICE_CAP_KEYBOARD,
+    LIBINPUT_DEVICE_CAP_POINTER,
+    LIBINPUT_DEVICE_CAP_TOUCH
+};
 
-static int num_pointer_devs = 0;
-static char *pointer_devs[MAX_POINTER_DEVS];
-static lv_indev_t *pointer_indevs[MAX_POINTER_DEVS];
-static lv_indev_drv_t pointer_indev_drvs[MAX_POINTER_DEVS];
-static libinput_drv_state_t pointer_drv_states[MAX_POINTER_DEVS];
+/* Kinds to connect, from the configuration */
+static bool connect_kinds[NUM_KINDS];
 
-static int num_touchscreen_devs = 0;
-static char *touchscreen_devs[MAX_TOUCHSCREEN_DEVS];
-static lv_indev_t *touchscreen_indevs[MAX_TOUCHSCREEN_DEVS];
-static lv_indev_drv_t touchscreen_indev_drvs[MAX_TOUCHSCREEN_DEVS];
-static libinput_drv_state_t touchscreen_drv_states[MAX_TOUCHSCREEN_DEVS];
+/* Shared context of all devices. Uses udev for hotplug, or a fixed set of paths without udev. */
+static struct libinput *context = NULL;
+static struct udev *udev = NULL;
+static device *devices = NULL;
+
+/* True once the context's file descriptor wakes the event loop */
+static bool is_watching = false;
+
+/* Group that connected keyboards, including hotplugged ones, type into */
+static lv_group_t *keyboard_group = NULL;
+/* Cursor for connected pointers, created once the first pointer shows up */
+static bool wants_cursor = false;
+static lv_obj_t *cursor_obj = NULL;
+
+/* If true, a press or release is drawn right away instead of on the next refresh period */
+static bool is_low_latency = false;
 
 
 /**
@@ -64,88 +134,506 @@ static libinput_drv_state_t touchscreen_drv_states[MAX_TOUCHSCREEN_DEVS];
  */
 
 /**
- * Auto-connect available input devices having a specific capability.
- * 
- * @param capability capability to filter devices by
- * @param max_num_devs maximum number of devices to connect
- * @param num_devs pointer for writing the actual number of connected devices into
- * @param devs array for storing device paths
- * @param indevs array for storing LVGL indevs
- * @param indev_drvs array for storing LVGL indev drivers
- * @param drv_states array for storing LVGL libinput driver states
+ * Open an input device file on behalf of libinput.
+ *
+ * @param path device path
+ * @param flags open flags
+ * @param user_data unused
+ * @return the file descriptor or a negative errno on failure
+ */
+static int open_restricted(const char *path, int flags, void *user_data);
+
+/**
+ * Close an input device file on behalf of libinput.
+ *
+ * @param fd the file descriptor
+ * @param user_data unused
+ */
+static void close_restricted(int fd, void *user_data);
+
+/**
+ * Create a context that adds every event device currently present, for systems without udev.
+ *
+ * @return the context or NULL on failure
+ */
+static struct libinput *create_path_context(void);
+
+/**
+ * Register LVGL input devices for the configured capabilities of a new libinput device.
+ *
+ * @param libinput_device the libinput device
+ */
+static void add_device(struct libinput_device *libinput_device);
+
+/**
+ * Unregister the LVGL input devices of a removed libinput device.
+ *
+ * @param libinput_device the libinput device
+ */
+static void remove_device(struct libinput_device *libinput_device);
+
+/**
+ * Delete the LVGL input devices of a removed device and free it. Deferred so that it never runs
+ * from within the device's own read.
+ *
+ * @param user_data the device
+ */
+static void free_device_cb(void *user_data);
+
+/**
+ * Connect a keyboard to the keyboard group and a pointer to the cursor.
+ *
+ * @param h the handle
+ * @param k the handle's kind
+ */
+static void set_up_handle(handle *h, kind k);
+
+/**
+ * Resume a handle's read timer and have it read right away.
+ *
+ * @param h the handle
+ */
+static void wake(handle *h);
+
+/**
+ * Get the most recent state of a handle, including samples that weren't read yet.
+ *
+ * @param h the handle
+ * @return the state
+ */
+static sample *latest(handle *h);
+
+/**
+ * Make room in a full queue by dropping its oldest motion sample. Later samples keep their order.
+ *
+ * @param h the handle
+ * @return true if a sample was dropped, false if the queue only holds presses and releases
+ */
+static bool drop_motion(handle *h);
+
+/**
+ * Queue a new state for a handle. Consecutive samples that only move the point are merged, and a
+ * full queue gives up motion before it gives up a press or release, so the queue holds every
+ * press and release even when a device reports faster than it is read.
+ *
+ * @param h the handle
+ * @param s the new state
  */
-static void auto_connect(libinput_capability capability, int max_num_devs, int *num_devs, char *devs[], lv_indev_t *indevs[],
-                  lv_indev_drv_t indev_drvs[], libinput_drv_state_t drv_states[]);
+static void push(handle *h, const sample *s);
 
 /**
- * Log a message announcing the connection of an input device.
- * 
- * @param capability the device's capability
- * @param dev the device path
+ * Update the handles of a device from a libinput event.
+ *
+ * @param event the event
  */
-static void log_connection(libinput_capability capability, char *dev);
+static void handle_event(struct libinput_event *event);
 
 /**
- * Perform an input read on a device using the libinput driver.
+ * Read and process all pending libinput events.
+ */
+static void dispatch(void);
+
+/**
+ * Report the oldest queued state of a handle to LVGL and ask to be called again while more are
+ * queued.
  *
  * @param indev_drv input device driver
  * @param data input device data to write into
  */
 static void libinput_read_cb(lv_indev_drv_t *indev_drv, lv_indev_data_t *data);
 
+/**
+ * Process libinput events when the context's file descriptor became readable.
+ *
+ * @param fd the file descriptor
+ * @param events ready events
+ * @param user_data unused
+ */
+static void fd_ready_cb(int fd, uint32_t events, void *user_data);
+
 
 /**
  * Static functions
  */
 
-static void auto_connect(libinput_capability capability, int max_num_devs, int *num_devs, char *devs[], lv_indev_t *indevs[],
-                  lv_indev_drv_t indev_drvs[], libinput_drv_state_t drv_states[]) {
+static int open_restricted(const char *path, int flags, void *user_data) {
+    LV_UNUSED(user_data);
+    int fd = open(path, flags | O_CLOEXEC);
+    return fd < 0 ? -errno : fd;
+}
+
+static void close_restricted(int fd, void *user_data) {
+    LV_UNUSED(user_data);
+    close(fd);
+}
 
-    memset(devs, 0, max_num_devs * sizeof(char *));
-    memset(indevs, 0, max_num_devs * sizeof(lv_indev_t *));
-    memset(indev_drvs, 0, max_num_devs * sizeof(lv_indev_drv_t));
-    memset(drv_states, 0, max_num_devs * sizeof(libinput_drv_state_t));
+static const struct libinput_interface interface = {
+    .open_restricted = open_restricted,
+    .close_restricted = close_restricted
+};
 
-    *num_devs = libinput_find_devs(capability, devs, max_num_devs, false);
+static struct libinput *create_path_context(void) {
+    struct libinput *path_context = libinput_path_create_context(&interface, NULL);
+    if (path_context == NULL) {
+        return NULL;
+    }
 
-    for (int i = 0; i < *num_devs; ++i) {
-        log_connection(capability, devs[i]);
+    DIR *dir = opendir(INPUT_DEV_PATH);
+    if (dir == NULL) {
+        log_error("Could not open " INPUT_DEV_PATH ": %s", strerror(errno));
+        return path_context;
+    }
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, "event", 5) != 0) {
+            continue;
+        }
+        char path[PATH_MAX];
+        snprintf(path, sizeof(path), "%s/%s", INPUT_DEV_PATH, entry->d_name);
+        libinput_path_add_device(path_context, path);
+    }
+
+    closedir(dir);
+    return path_context;
+}
+
+static void add_device(struct libinput_device *libinput_device) {
+    device *dev = calloc(1, sizeof(device));
+    if (dev == NULL) {
+        log_error("Could not allocate input device");
+        return;
+    }
+
+    bool has_any = false;
+    for (int k = 0; k < NUM_KINDS; ++k) {
+        if (!connect_kinds[k] || !libinput_device_has_capability(libinput_device, kind_capabilities[k])) {
+            continue;
+        }
+        if (k == KIND_KEYBOARD && !xkb_init_state(&(dev->xkb_state))) {
+            log_error("Could not set up keymap for %s", libinput_device_get_sysname(libinput_device));
+            continue;
+        }
 
-        libinput_init_state(&(drv_states[i]), devs[i]);
-        lv_indev_drv_init(&(indev_drvs[i]));
+        log_verbose("Connecting %s device %s", kind_names[k], libinput_device_get_sysname(libinput_device));
 
-        indev_drvs[i].read_cb = libinput_read_cb;
-        indev_drvs[i].user_data = &(drv_states[i]);
+        handle *h = &(dev->handles[k]);
+        lv_indev_drv_init(&(h->drv));
+        h->drv.read_cb = libinput_read_cb;
+        h->drv.user_data = h;
+        h->current.state = LV_INDEV_STATE_RELEASED;
 
-        if (capability == LIBINPUT_CAPABILITY_KEYBOARD) {
-            indev_drvs[i].type = LV_INDEV_TYPE_KEYPAD;
+        if (k == KIND_KEYBOARD) {
+            h->drv.type = LV_INDEV_TYPE_KEYPAD;
         } else {
-            indev_drvs[i].type = LV_INDEV_TYPE_POINTER;
-            indev_drvs[i].long_press_repeat_time = USHRT_MAX;
+            h->drv.type = LV_INDEV_TYPE_POINTER;
+            h->drv.long_press_repeat_time = USHRT_MAX;
         }
 
-        indevs[i] = lv_indev_drv_register(&(indev_drvs[i]));
+        h->indev = lv_indev_drv_register(&(h->drv));
+        set_up_handle(h, k);
+        has_any = true;
     }
+
+    if (!has_any) {
+        free(dev);
+        return;
+    }
+
+    dev->libinput_device = libinput_device;
+    libinput_device_set_user_data(libinput_device, dev);
+    dev->next = devices;
+    devices = dev;
 }
 
-static void log_connection(libinput_capability capability, char *dev) {
-    switch (capability) {
-        case LIBINPUT_CAPABILITY_KEYBOARD:
-            printf("Connecting keyboard device %s\n", dev);
+static void remove_device(struct libinput_device *libinput_device) {
+    device *dev = libinput_device_get_user_data(libinput_device);
+    if (dev == NULL) {
+        return;
+    }
+
+    for (device **link = &devices; *link != NULL; link = &((*link)->next)) {
+        if (*link == dev) {
+            *link = dev->next;
             break;
-        case LIBINPUT_CAPABILITY_POINTER:
-            printf("Connecting pointer device %s\n", dev);
+        }
+    }
+
+    log_verbose("Disconnecting input device %s", libinput_device_get_sysname(libinput_device));
+    libinput_device_set_user_data(libinput_device, NULL);
+    dev->libinput_device = NULL;
+    lv_async_call(free_device_cb, dev);
+}
+
+static void free_device_cb(void *user_data) {
+    device *dev = user_data;
+    for (int k = 0; k < NUM_KINDS; ++k) {
+        if (dev->handles[k].indev != NULL) {
+            lv_indev_delete(dev->handles[k].indev);
+        }
+    }
+    if (dev->handles[KIND_KEYBOARD].indev != NULL) {
+        xkb_deinit_state(&(dev->xkb_state));
+    }
+    free(dev);
+}
+
+static void set_up_handle(handle *h, kind k) {
+    if (k == KIND_KEYBOARD && keyboard_group != NULL) {
+        lv_indev_set_group(h->indev, keyboard_group);
+    }
+
+    if (k == KIND_POINTER && wants_cursor) {
+        if (cursor_obj == NULL) {
+            cursor_obj = lv_img_create(lv_scr_act());
+            lv_img_set_src(cursor_obj, &cursor_img_dsc);
+        }
+        lv_indev_set_cursor(h->indev, cursor_obj);
+    }
+}
+
+static void wake(handle *h) {
+    /* Without the event loop the read timers poll and call into dispatch themselves */
+    if (!is_watching) {
+        return;
+    }
+
+    /* Read right away, the timer keeps running until the interaction ends */
+    lv_timer_resume(h->indev->driver->read_timer);
+    lv_timer_ready(h->indev->driver->read_timer);
+}
+
+static sample *latest(handle *h) {
+    if (h->queue_count == 0) {
+        return &(h->current);
+    }
+    return &(h->queue[(h->queue_head + h->queue_count - 1) % INDEV_QUEUE_SIZE]);
+}
+
+static bool drop_motion(handle *h) {
+    for (int i = 0; i < h->queue_count; ++i) {
+        if (!h->queue[(h->queue_head + i) % INDEV_QUEUE_SIZE].is_motion) {
+            continue;
+        }
+        for (int j = i; j < h->queue_count - 1; ++j) {
+            h->queue[(h->queue_head + j) % INDEV_QUEUE_SIZE] = h->queue[(h->queue_head + j + 1) % INDEV_QUEUE_SIZE];
+        }
+        --h->queue_count;
+        return true;
+    }
+    return false;
+}
+
+static void push(handle *h, const sample *s) {
+    /* Input on a blank screen only turns it back on, up to the release of the press that did it */
+    if (idle_notify_input()) {
+        h->is_waking = true;
+    }
+    if (h->is_waking) {
+        h->is_waking = s->state == LV_INDEV_STATE_PRESSED;
+        return;
+    }
+
+    sample *last = latest(h);
+    const bool is_motion = s->state == last->state && s->key == last->key;
+
+    if (is_motion && h->queue_count > 0 && last->is_motion) {
+        /* Keep the time of the first event so latency covers the whole wait */
+        const uint64_t time_us = last->time_us;
+        *last = *s;
+        last->time_us = time_us;
+        last->is_motion = true;
+        wake(h);
+        return;
+    }
+
+    if (h->queue_count == INDEV_QUEUE_SIZE && !drop_motion(h)) {
+        if (is_motion) {
+            /* The next press or release carries its own point */
+            return;
+        }
+        /* Nothing but presses and releases are queued, dropping two keeps them alternating */
+        log_warning("Input queue full, dropping the oldest press and release");
+        h->queue_head = (h->queue_head + 2) % INDEV_QUEUE_SIZE;
+        h->queue_count -= 2;
+    }
+
+    sample *next = &(h->queue[(h->queue_head + h->queue_count) % INDEV_QUEUE_SIZE]);
+    *next = *s;
+    next->is_motion = is_motion;
+    ++h->queue_count;
+
+    wake(h);
+}
+
+static void handle_event(struct libinput_event *event) {
+    device *dev = libinput_device_get_user_data(libinput_event_get_device(event));
+    if (dev == NULL) {
+        return;
+    }
+
+    handle *keyboard = &(dev->handles[KIND_KEYBOARD]);
+    handle *pointer = &(dev->handles[KIND_POINTER]);
+    handle *touchscreen = &(dev->handles[KIND_TOUCHSCREEN]);
+    const lv_coord_t hor_res = lv_disp_get_hor_res(NULL);
+    const lv_coord_t ver_res = lv_disp_get_ver_res(NULL);
+    sample s;
+
+    switch (libinput_event_get_type(event)) {
+        case LIBINPUT_EVENT_KEYBOARD_KEY: {
+            if (keyboard->indev == NULL) {
+                return;
+            }
+            struct libinput_event_keyboard *key_event = libinput_event_get_keyboard_event(event);
+            const bool down = libinput_event_keyboard_get_key_state(key_event) == LIBINPUT_KEY_STATE_PRESSED;
+            const uint32_t key = xkb_process_key_state(&(dev->xkb_state), libinput_event_keyboard_get_key(key_event), down);
+            if (down && key == 0) {
+                /* Modifiers only change the keymap state */
+                return;
+            }
+            s = *latest(keyboard);
+            if (down) {
+                s.key = key;
+            }
+            s.state = down ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+            s.time_us = libinput_event_keyboard_get_time_usec(key_event);
+            push(keyboard, &s);
             break;
-        case LIBINPUT_CAPABILITY_TOUCH:
-            printf("Connecting touchscreen device %s\n", dev);
+        }
+        case LIBINPUT_EVENT_POINTER_MOTION: {
+            if (pointer->indev == NULL) {
+                return;
+            }
+            struct libinput_event_pointer *pointer_event = libinput_event_get_pointer_event(event);
+            s = *latest(pointer);
+            s.point.x = LV_CLAMP(0, s.point.x + (lv_coord_t)libinput_event_pointer_get_dx(pointer_event), hor_res - 1);
+            s.point.y = LV_CLAMP(0, s.point.y + (lv_coord_t)libinput_event_pointer_get_dy(pointer_event), ver_res - 1);
+            s.time_us = libinput_event_pointer_get_time_usec(pointer_event);
+            push(pointer, &s);
             break;
-        case LIBINPUT_CAPABILITY_NONE:
+        }
+        case LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE: {
+            if (pointer->indev == NULL) {
+                return;
+            }
+            struct libinput_event_pointer *pointer_event = libinput_event_get_pointer_event(event);
+            s = *latest(pointer);
+            s.point.x = libinput_event_pointer_get_absolute_x_transformed(pointer_event, hor_res);
+            s.point.y = libinput_event_pointer_get_absolute_y_transformed(pointer_event, ver_res);
+            s.time_us = libinput_event_pointer_get_time_usec(pointer_event);
+            push(pointer, &s);
+            break;
+        }
+        case LIBINPUT_EVENT_POINTER_BUTTON: {
+            if (pointer->indev == NULL) {
+                return;
+            }
+            struct libinput_event_pointer *pointer_event = libinput_event_get_pointer_event(event);
+            if (libinput_event_pointer_get_button(pointer_event) != BTN_LEFT) {
+                return;
+            }
+            const bool down = libinput_event_pointer_get_button_state(pointer_event) == LIBINPUT_BUTTON_STATE_PRESSED;
+            s = *latest(pointer);
+            s.state = down ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+            s.time_us = libinput_event_pointer_get_time_usec(pointer_event);
+            push(pointer, &s);
+            break;
+        }
+        case LIBINPUT_EVENT_TOUCH_DOWN:
+        case LIBINPUT_EVENT_TOUCH_MOTION: {
+            if (touchscreen->indev == NULL) {
+                return;
+            }
+            struct libinput_event_touch *touch_event = libinput_event_get_touch_event(event);
+            s = *latest(touchscreen);
+            s.point.x = libinput_event_touch_get_x_transformed(touch_event, hor_res);
+            s.point.y = libinput_event_touch_get_y_transformed(touch_event, ver_res);
+            s.state = LV_INDEV_STATE_PRESSED;
+            s.time_us = libinput_event_touch_get_time_usec(touch_event);
+            push(touchscreen, &s);
+            break;
+        }
+        case LIBINPUT_EVENT_TOUCH_UP:
+        case LIBINPUT_EVENT_TOUCH_CANCEL: {
+            if (touchscreen->indev == NULL) {
+                return;
+            }
+            struct libinput_event_touch *touch_event = libinput_event_get_touch_event(event);
+            s = *latest(touchscreen);
+            s.state = LV_INDEV_STATE_RELEASED;
+            s.time_us = libinput_event_touch_get_time_usec(touch_event);
+            push(touchscreen, &s);
+            break;
+        }
+        default:
             break;
     }
 }
 
+static void dispatch(void) {
+    uint64_t start = profile_begin();
+
+    if (libinput_dispatch(context) != 0) {
+        log_error("Failed to dispatch libinput events: %s", strerror(errno));
+    }
+
+    struct libinput_event *event;
+    while ((event = libinput_get_event(context)) != NULL) {
+        switch (libinput_event_get_type(event)) {
+            case LIBINPUT_EVENT_DEVICE_ADDED:
+                add_device(libinput_event_get_device(event));
+                break;
+            case LIBINPUT_EVENT_DEVICE_REMOVED:
+                remove_device(libinput_event_get_device(event));
+                break;
+            default:
+                handle_event(event);
+                break;
+        }
+        libinput_event_destroy(event);
+    }
+
+    profile_end(PROFILE_METRIC_INPUT, start);
+}
+
 static void libinput_read_cb(lv_indev_drv_t *indev_drv, lv_indev_data_t *data) {
-    libinput_read_state(indev_drv->user_data, indev_drv, data);
+    handle *h = indev_drv->user_data;
+
+    if (!is_watching) {
+        dispatch();
+    }
+
+    if (h->queue_count > 0) {
+        const sample *next = &(h->queue[h->queue_head]);
+        h->queue_head = (h->queue_head + 1) % INDEV_QUEUE_SIZE;
+        --h->queue_count;
+
+        if (next->state != h->current.state) {
+            if (next->state == LV_INDEV_STATE_PRESSED) {
+                profile_mark_input(next->time_us);
+            }
+            if (is_low_latency && indev_drv->disp != NULL && indev_drv->disp->refr_timer != NULL) {
+                /* The timer is resumed by whatever the press invalidates */
+                lv_timer_ready(indev_drv->disp->refr_timer);
+            }
+        }
+        h->current = *next;
+    }
+
+    data->state = h->current.state;
+    if (indev_drv->type == LV_INDEV_TYPE_KEYPAD) {
+        data->key = h->current.key;
+    } else {
+        data->point = h->current.point;
+    }
+    data->continue_reading = h->queue_count > 0;
+}
+
+static void fd_ready_cb(int fd, uint32_t events, void *user_data) {
+    LV_UNUSED(fd);
+    LV_UNUSED(events);
+    LV_UNUSED(user_data);
+    dispatch();
 }
 
 
@@ -154,44 +642,144 @@ static void libinput_read_cb(lv_indev_drv_t *indev_drv, lv_indev_data_t *data) {
  */
 
 void indev_auto_connect(bool keyboard, bool pointer, bool touchscreen) {
-    if (keyboard) {
-        auto_connect(LIBINPUT_CAPABILITY_KEYBOARD, MAX_KEYBOARD_DEVS, &num_keyboard_devs, keyboard_devs, keyboard_indevs,
-            keyboard_indev_drvs, keyboard_drv_states);
+    if (context != NULL) {
+        return;
     }
-    if (pointer) {
-        auto_connect(LIBINPUT_CAPABILITY_POINTER, MAX_POINTER_DEVS, &num_pointer_devs, pointer_devs, pointer_indevs,
-            pointer_indev_drvs, pointer_drv_states);
+
+    connect_kinds[KIND_KEYBOARD] = keyboard;
+    connect_kinds[KIND_POINTER] = pointer;
+    connect_kinds[KIND_TOUCHSCREEN] = touchscreen;
+
+    /* The group lives as long as the process, so it must not end up in a screen's heap arena. It is
+     * created even without a keyboard so that one plugged in later can type. */
+    if (keyboard_group == NULL) {
+        keyboard_group = lv_group_create();
+    }
+
+    if (!keyboard && !pointer && !touchscreen) {
+        return;
     }
-    if (touchscreen) {
-        auto_connect(LIBINPUT_CAPABILITY_TOUCH, MAX_TOUCHSCREEN_DEVS, &num_touchscreen_devs, touchscreen_devs, touchscreen_indevs,
-            touchscreen_indev_drvs, touchscreen_drv_states);
+
+    udev = udev_new();
+    if (udev != NULL) {
+        context = libinput_udev_create_context(&interface, NULL, udev);
+        if (context != NULL && libinput_udev_assign_seat(context, SEAT) != 0) {
+            log_error("Could not assign udev seat " SEAT);
+            libinput_unref(context);
+            context = NULL;
+        }
     }
+
+    if (context == NULL) {
+        log_warning("Input device hotplug unavailable, connecting present devices only");
+        if (udev != NULL) {
+            udev_unref(udev);
+            udev = NULL;
+        }
+        context = create_path_context();
+    }
+
+    if (context == NULL) {
+        log_error("Could not create libinput context");
+        return;
+    }
+
+    /* Connect the devices that are already present */
+    dispatch();
+}
+
+void indev_set_low_latency(bool enabled) {
+    is_low_latency = enabled;
 }
 
 bool indev_is_keyboard_connected() {
-    return num_keyboard_devs > 0;
+    for (device *dev = devices; dev != NULL; dev = dev->next) {
+        if (dev->handles[KIND_KEYBOARD].indev != NULL) {
+            return true;
+        }
+    }
+    return false;
 }
 
 void indev_set_up_textarea_for_keyboard_input(lv_obj_t *textarea) {
-    if (!indev_is_keyboard_connected()) {
+    if (keyboard_group == NULL) {
+        log_error("Keyboard group missing, call indev_auto_connect first");
         return;
     }
 
-    lv_group_t *group = lv_group_create();
-    lv_group_add_obj(group, textarea);
+    lv_group_remove_all_objs(keyboard_group);
+    lv_group_add_obj(keyboard_group, textarea);
 
-    for (int i = 0; i < num_keyboard_devs; ++i) {
-        lv_indev_set_group(keyboard_indevs[i], group);
+    for (device *dev = devices; dev != NULL; dev = dev->next) {
+        if (dev->handles[KIND_KEYBOARD].indev != NULL) {
+            set_up_handle(&(dev->handles[KIND_KEYBOARD]), KIND_KEYBOARD);
+        }
     }
 }
 
 void indev_set_up_mouse_cursor() {
-    if (num_pointer_devs == 0) {
+    wants_cursor = true;
+
+    for (device *dev = devices; dev != NULL; dev = dev->next) {
+        if (dev->handles[KIND_POINTER].indev != NULL) {
+            set_up_handle(&(dev->handles[KIND_POINTER]), KIND_POINTER);
+        }
+    }
+}
+
+void indev_watch_fds(void) {
+    if (context == NULL || is_watching) {
+        return;
+    }
+
+    is_watching = event_loop_add_fd(libinput_get_fd(context), fd_ready_cb, NULL);
+
+    /* Pick up anything that arrived while nobody was watching */
+    dispatch();
+}
+
+void indev_pause_idle_read_timers(void) {
+    if (!is_watching) {
+        return;
+    }
+
+    for (device *dev = devices; dev != NULL; dev = dev->next) {
+        for (int k = 0; k < NUM_KINDS; ++k) {
+            lv_indev_t *indev = dev->handles[k].indev;
+            if (indev == NULL) {
+                continue;
+            }
+
+            /* Long press, key repeat and scroll throw are driven by the read timer */
+            bool busy = indev->proc.state == LV_INDEV_STATE_PRESSED;
+            if (indev->driver->type == LV_INDEV_TYPE_POINTER && indev->proc.types.pointer.scroll_obj != NULL) {
+                busy = true;
+            }
+
+            if (!busy) {
+                lv_timer_pause(indev->driver->read_timer);
+            }
+        }
+    }
+}
+
+void indev_suspend(void) {
+    if (context == NULL) {
         return;
     }
-    lv_obj_t *cursor_obj = lv_img_create(lv_scr_act());
-    lv_img_set_src(cursor_obj, &cursor_img_dsc);
-    for (int i = 0; i < num_pointer_devs; ++i) {
-        lv_indev_set_cursor(pointer_indevs[i], cursor_obj);
+
+    /* Removes every device, processing the removals right away drops their LVGL input devices */
+    libinput_suspend(context);
+    dispatch();
+}
+
+void indev_resume(void) {
+    if (context == NULL) {
+        return;
+    }
+
+    if (libinput_resume(context) != 0) {
+        log_error("Could not resume libinput context");
     }
+    dispatch();
 }
@@ -26,7 +26,9 @@
 #include <stdbool.h>
 
 /**
- * Auto-connect currently available keyboard, pointer and touchscreen input devices.
+ * Auto-connect keyboard, pointer and touchscreen input devices. All devices share one libinput
+ * context on the udev seat, so devices plugged in later are connected as they appear. Without
+ * udev only the devices present at this point are connected.
  *
  * @param keyboard if true, auto-connect keyboard devices
  * @param pointer if true, auto-connect pointer devices
@@ -34,6 +36,13 @@
  */
 void indev_auto_connect(bool keyboard, bool pointer, bool touchscreen);
 
+/**
+ * Draw presses and releases right away instead of waiting for the next display refresh period.
+ *
+ * @param enabled if true, refresh the display as soon as a press or release was read
+ */
+void indev_set_low_latency(bool enabled);
+
 /**
  * Check if any keyboard devices are connected.
  *
@@ -42,8 +51,9 @@ void indev_auto_connect(bool keyboard, bool pointer, bool touchscreen);
 bool indev_is_keyboard_connected();
 
 /**
- * Set up an LVGL text area to receive input from currently connected keyboard devices.
- * 
+ * Set up an LVGL text area to receive input from currently connected keyboard devices. Only
+ * allocates the group entry of the text area, which goes away with it.
+ *
  * @param textarea textarea widget
  */
 void indev_set_up_textarea_for_keyboard_input(lv_obj_t *textarea);
@@ -53,4 +63,26 @@ void indev_set_up_textarea_for_keyboard_input(lv_obj_t *textarea);
  */
 void indev_set_up_mouse_cursor();
 
+/**
+ * Wake the event loop and process libinput events, including hotplug, as soon as they arrive.
+ */
+void indev_watch_fds(void);
+
+/**
+ * Pause the read timers of watched input devices without a press or scroll in progress, so that
+ * idle devices don't wake the event loop. They are resumed when input arrives.
+ */
+void indev_pause_idle_read_timers(void);
+
+/**
+ * Disconnect all input devices, e.g. while another program uses them. Nothing is read until
+ * indev_resume is called.
+ */
+void indev_suspend(void);
+
+/**
+ * Reconnect the input devices disconnected by indev_suspend.
+ */
+void indev_resume(void);
+
 #endif /* INDEV_H */
@@ -0,0 +1,320 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "job.h"
+
+#include "log.h"
+#include "tick.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/**
+ * Static types
+ */
+
+/* State of a stage */
+typedef enum {
+    STAGE_PENDING = 0,
+    STAGE_RUNNING = 1,
+    STAGE_DONE = 2,
+    STAGE_SKIPPED = 3,
+    STAGE_FAILED = 4,
+    STAGE_CANCELLED = 5
+} stage_state;
+
+/* Runtime data of a stage */
+typedef struct {
+    /* The job, for the stage thread */
+    job *j;
+    /* Index of the stage */
+    int index;
+    pthread_t thread;
+    bool has_thread;
+    stage_state state;
+    /* Monotonic times the stage started and ended */
+    uint64_t start_us;
+    uint64_t end_us;
+    /* Position among the started stages */
+    int start_order;
+} stage_run;
+
+struct job {
+    const job_desc *desc;
+    void *ctx;
+    job_progress_cb progress_cb;
+    void *user_data;
+    /* Guards everything below */
+    pthread_mutex_t lock;
+    /* Signalled when a stage ends */
+    pthread_cond_t stage_ended;
+    atomic_bool is_cancelled;
+    /* True if a required stage failed */
+    bool has_failed;
+    stage_run stages[JOB_MAX_STAGES];
+    int num_running;
+    int num_started;
+    /* Indexes of the ended stages, in the order they ended */
+    int ended[JOB_MAX_STAGES];
+    int num_ended;
+    /* Stage whose progress is reported, -1 if none */
+    int shown;
+};
+
+
+/**
+ * Static variables
+ */
+
+static const char *state_names[] = { "pending", "running", "done", "skipped", "failed", "cancelled" };
+
+
+/**
+ * Static prototypes
+ */
+
+/**
+ * Report the earliest started running stage with a phase, unless it is already reported. Must be
+ * called with the lock held.
+ *
+ * @param j the job
+ */
+static void update_shown(job *j);
+
+/**
+ * Start all pending stages whose dependencies succeeded and skip the ones that can't run anymore.
+ * Must be called with the lock held.
+ *
+ * @param j the job
+ */
+static void start_ready_stages(job *j);
+
+/**
+ * Record the result of a stage. Must be called with the lock held.
+ *
+ * @param j the job
+ * @param index index of the stage
+ * @param result return value of the stage function
+ */
+static void end_stage(job *j, int index, int result);
+
+/**
+ * Stage thread.
+ *
+ * @param arg the stage's runtime data
+ * @return NULL
+ */
+static void *stage_thread(void *arg);
+
+
+/**
+ * Static functions
+ */
+
+static void update_shown(job *j) {
+    if (j->shown >= 0 && j->stages[j->shown].state == STAGE_RUNNING) {
+        return;
+    }
+
+    j->shown = -1;
+    for (int i = 0; i < j->desc->num_stages; ++i) {
+        const stage_run *s = &j->stages[i];
+        if (s->state == STAGE_RUNNING && j->desc->stages[i].phase != NULL
+                && (j->shown < 0 || s->start_order < j->stages[j->shown].start_order)) {
+            j->shown = i;
+        }
+    }
+
+    if (j->shown >= 0 && j->progress_cb != NULL) {
+        j->progress_cb(j->desc->stages[j->shown].phase, 0, 0, j->user_data);
+    }
+}
+
+static void start_ready_stages(job *j) {
+    /* Dependencies only point to earlier stages, so one pass settles every stage it can */
+    for (int i = 0; i < j->desc->num_stages; ++i) {
+        stage_run *s = &j->stages[i];
+        const job_stage *stage = &j->desc->stages[i];
+        if (s->state != STAGE_PENDING) {
+            continue;
+        }
+
+        bool is_ready = true;
+        bool is_blocked = false;
+        for (int d = 0; d < i; ++d) {
+            if (!(stage->deps & JOB_DEP(d))) {
+                continue;
+            }
+            const stage_state dep_state = j->stages[d].state;
+            if (dep_state == STAGE_PENDING || dep_state == STAGE_RUNNING) {
+                is_ready = false;
+            } else if (dep_state != STAGE_DONE) {
+                is_blocked = true;
+            }
+        }
+
+        if (atomic_load(&j->is_cancelled)) {
+            s->state = STAGE_CANCELLED;
+        } else if (is_blocked) {
+            s->state = STAGE_SKIPPED;
+            log_verbose("%s: skipping stage %s, a dependency didn't succeed", j->desc->name, stage->name);
+        } else if (is_ready) {
+            s->state = STAGE_RUNNING;
+            s->start_us = tick_now_us();
+            s->start_order = j->num_started++;
+            ++j->num_running;
+            if (pthread_create(&s->thread, NULL, stage_thread, s) != 0) {
+                log_error("%s: could not start a thread for stage %s", j->desc->name, stage->name);
+                end_stage(j, i, -1);
+                continue;
+            }
+            s->has_thread = true;
+            log_verbose("%s: started stage %s", j->desc->name, stage->name);
+        }
+    }
+
+    update_shown(j);
+}
+
+static void end_stage(job *j, int index, int result) {
+    stage_run *s = &j->stages[index];
+    const job_stage *stage = &j->desc->stages[index];
+
+    s->end_us = tick_now_us();
+    s->state = result == 0 ? STAGE_DONE : result == JOB_STAGE_SKIPPED ? STAGE_SKIPPED : STAGE_FAILED;
+    --j->num_running;
+    j->ended[j->num_ended++] = index;
+
+    const double seconds = (double)(s->end_us - s->start_us) / 1000000.0;
+    if (s->state != STAGE_FAILED) {
+        log_info("%s: stage %s %s in %.1f s", j->desc->name, stage->name, state_names[s->state], seconds);
+    } else if (stage->required) {
+        /* A stage that stopped because of an earlier failure doesn't need to cancel again */
+        log_error("%s: stage %s failed after %.1f s%s", j->desc->name, stage->name, seconds,
+            atomic_load(&j->is_cancelled) ? "" : ", cancelling");
+        j->has_failed = true;
+        atomic_store(&j->is_cancelled, true);
+    } else {
+        log_warning("%s: optional stage %s failed after %.1f s", j->desc->name, stage->name, seconds);
+    }
+}
+
+static void *stage_thread(void *arg) {
+    stage_run *s = arg;
+    job *j = s->j;
+
+    const int result = j->desc->stages[s->index].run(j, s->index, j->ctx);
+
+    pthread_mutex_lock(&j->lock);
+    end_stage(j, s->index, result);
+    pthread_cond_signal(&j->stage_ended);
+    pthread_mutex_unlock(&j->lock);
+    return NULL;
+}
+
+
+/**
+ * Public functions
+ */
+
+job *job_create(const job_desc *desc, void *ctx, job_progress_cb progress_cb, void *user_data) {
+    if (desc->num_stages > JOB_MAX_STAGES) {
+        log_error("%s: too many stages", desc->name);
+        return NULL;
+    }
+
+    job *j = calloc(1, sizeof(job));
+    if (j == NULL) {
+        log_error("Could not allocate job %s", desc->name);
+        return NULL;
+    }
+
+    j->desc = desc;
+    j->ctx = ctx;
+    j->progress_cb = progress_cb;
+    j->user_data = user_data;
+    j->shown = -1;
+    pthread_mutex_init(&j->lock, NULL);
+    pthread_cond_init(&j->stage_ended, NULL);
+    atomic_init(&j->is_cancelled, false);
+    for (int i = 0; i < desc->num_stages; ++i) {
+        j->stages[i].j = j;
+        j->stages[i].index = i;
+    }
+    return j;
+}
+
+int job_run(job *j) {
+    const uint64_t start_us = tick_now_us();
+
+    pthread_mutex_lock(&j->lock);
+    while (true) {
+        start_ready_stages(j);
+        if (j->num_running == 0) {
+            break;
+        }
+        pthread_cond_wait(&j->stage_ended, &j->lock);
+    }
+    pthread_mutex_unlock(&j->lock);
+
+    for (int i = 0; i < j->desc->num_stages; ++i) {
+        if (j->stages[i].has_thread) {
+            pthread_join(j->stages[i].thread, NULL);
+        }
+    }
+
+    if (j->desc->cleanup_phase != NULL && j->progress_cb != NULL) {
+        j->progress_cb(j->desc->cleanup_phase, 0, 0, j->user_data);
+    }
+    for (int k = j->num_ended - 1; k >= 0; --k) {
+        const int i = j->ended[k];
+        if (j->stages[i].state == STAGE_DONE && j->desc->stages[i].cleanup != NULL) {
+            j->desc->stages[i].cleanup(j->ctx);
+        }
+    }
+
+    log_info("%s: %s in %.1f s", j->desc->name, j->has_failed ? "failed" : "done",
+        (double)(tick_now_us() - start_us) / 1000000.0);
+    return j->has_failed ? -1 : 0;
+}
+
+bool job_is_cancelled(job *j) {
+    return atomic_load(&j->is_cancelled);
+}
+
+void job_report_progress(job *j, int stage, uint64_t bytes_done, uint64_t bytes_total) {
+    pthread_mutex_lock(&j->lock);
+    if (j->shown == stage && j->progress_cb != NULL) {
+        j->progress_cb(j->desc->stages[stage].phase, bytes_done, bytes_total, j->user_data);
+    }
+    pthread_mutex_unlock(&j->lock);
+}
+
+void job_free(job *j) {
+    if (j == NULL) {
+        return;
+    }
+    pthread_cond_destroy(&j->stage_ended);
+    pthread_mutex_destroy(&j->lock);
+    free(j);
+}
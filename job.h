@@ -0,0 +1,146 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef JOB_H
+#define JOB_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Maximum number of stages of a job */
+#define JOB_MAX_STAGES 16
+
+/* Returned by a stage function that found nothing to do */
+#define JOB_STAGE_SKIPPED 1
+
+/* Returns a dependency mask for the stage at an index */
+#define JOB_DEP(index) (1u << (index))
+
+/* Opaque job handle */
+typedef struct job job;
+
+/**
+ * Stage function, runs on a thread of its own.
+ *
+ * @param j the job, for reporting progress and checking for cancellation
+ * @param stage index of the stage
+ * @param ctx context passed to job_create
+ * @return 0 on success, JOB_STAGE_SKIPPED if there was nothing to do, -1 on failure
+ */
+typedef int (*job_stage_fn)(job *j, int stage, void *ctx);
+
+/**
+ * Release what a stage that succeeded set up, e.g. unmount what it mounted. Runs once all stages
+ * ended, whether the job succeeded or not.
+ *
+ * @param ctx context passed to job_create
+ */
+typedef void (*job_cleanup_fn)(void *ctx);
+
+/**
+ * Progress callback of a job. Only one stage is reported at a time.
+ *
+ * @param phase description of the current phase, a string literal that stays the same for the whole phase
+ * @param bytes_done number of bytes processed in the current phase
+ * @param bytes_total total number of bytes of the current phase, 0 if the phase isn't measured in bytes
+ * @param user_data user data passed to job_create
+ */
+typedef void (*job_progress_cb)(const char *phase, uint64_t bytes_done, uint64_t bytes_total, void *user_data);
+
+/**
+ * Stage of a job
+ */
+typedef struct {
+    /* Name for log messages */
+    const char *name;
+    /* Phase shown while the stage runs, NULL to not report the stage */
+    const char *phase;
+    /* Stage function */
+    job_stage_fn run;
+    /* Cleanup function, called once all stages ended if the stage succeeded, may be NULL */
+    job_cleanup_fn cleanup;
+    /* JOB_DEP masks of the stages that must succeed before this one starts */
+    uint32_t deps;
+    /* If true, failing this stage fails and cancels the job, otherwise the failure is only logged */
+    bool required;
+} job_stage;
+
+/**
+ * Declaration of a job. Stages whose dependencies succeeded run concurrently, stages whose
+ * dependencies failed or were skipped are skipped.
+ */
+typedef struct {
+    /* Name for log messages */
+    const char *name;
+    /* Stages, dependencies may only point to earlier stages */
+    const job_stage *stages;
+    /* Number of stages */
+    int num_stages;
+    /* Phase shown while cleaning up, may be NULL */
+    const char *cleanup_phase;
+} job_desc;
+
+/**
+ * Create a job.
+ *
+ * @param desc declaration of the job, must stay valid until the job is freed
+ * @param ctx context to pass to the stage and cleanup functions
+ * @param progress_cb progress callback, may be NULL
+ * @param user_data user data to pass to the progress callback
+ * @return the job or NULL on failure
+ */
+job *job_create(const job_desc *desc, void *ctx, job_progress_cb progress_cb, void *user_data);
+
+/**
+ * Run all stages, then clean up the ones that succeeded in reverse order. Blocks until everything
+ * finished, so it is meant to be run on a worker thread.
+ *
+ * @param j the job
+ * @return 0 if all required stages succeeded, -1 otherwise
+ */
+int job_run(job *j);
+
+/**
+ * Check whether a job was cancelled because a required stage failed. Stages that didn't start yet
+ * won't, long running stages should poll this to stop early. Safe to call from any thread.
+ *
+ * @param j the job
+ * @return true if the job was cancelled
+ */
+bool job_is_cancelled(job *j);
+
+/**
+ * Report progress of a stage. Ignored while an earlier started stage is shown.
+ *
+ * @param j the job
+ * @param stage index of the stage
+ * @param bytes_done number of bytes processed so far
+ * @param bytes_total total number of bytes, 0 if unknown
+ */
+void job_report_progress(job *j, int stage, uint64_t bytes_done, uint64_t bytes_total);
+
+/**
+ * Release a job after job_run returned.
+ *
+ * @param j the job
+ */
+void job_free(job *j);
+
+#endif /* JOB_H */
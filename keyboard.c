@@ -0,0 +1,69 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "keyboard.h"
+
+#include "keyboard_layers.h"
+#include "log.h"
+
+
+/**
+ * Static variables
+ */
+
+static sq2lv_layout_id_t current_layout = SQ2LV_LAYOUT_NONE;
+
+
+/**
+ * Public functions
+ */
+
+bool keyboard_set_layout(lv_obj_t *keyboard, sq2lv_layout_id_t layout_id) {
+    if (layout_id < 0 || layout_id >= sq2lv_num_layouts || layout_id >= KEYBOARD_LAYERS_NUM_LAYOUTS) {
+        log_error("Unknown keyboard layout %d", (int)layout_id);
+        return false;
+    }
+
+    /* Layers are assigned to modes in enum order, so a mode's value is its layer index */
+    const sq2lv_layout_t *layout = &sq2lv_layouts[layout_id];
+    for (int i = 0; i < layout->num_layers; ++i) {
+        lv_keyboard_set_map(keyboard, (lv_keyboard_mode_t)i, (const char **)layout->layers[i].keycaps,
+            layout->layers[i].attributes);
+    }
+
+    current_layout = layout_id;
+    lv_keyboard_set_mode(keyboard, (lv_keyboard_mode_t)0);
+    return true;
+}
+
+bool keyboard_switch_layer(lv_obj_t *keyboard, uint16_t btn_id) {
+    if (current_layout == SQ2LV_LAYOUT_NONE || btn_id >= KEYBOARD_LAYERS_MAX_BUTTONS) {
+        return false;
+    }
+
+    const unsigned int layer = lv_keyboard_get_mode(keyboard);
+    if (layer >= KEYBOARD_LAYERS_MAX_LAYERS
+            || !(keyboard_layers_switchers[current_layout][layer] & ((uint64_t)1 << btn_id))) {
+        return false;
+    }
+
+    lv_keyboard_set_mode(keyboard, (lv_keyboard_mode_t)keyboard_layers_targets[current_layout][layer][btn_id]);
+    return true;
+}
@@ -0,0 +1,50 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef KEYBOARD_H
+#define KEYBOARD_H
+
+#include "sq2lv_layouts.h"
+
+#include "lvgl/lvgl.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Apply a keyboard layout. Each layer's map is handed to LVGL once as one of the keyboard's
+ * modes, so switching layers later only swaps maps. Selects the layout's first layer.
+ *
+ * @param keyboard keyboard widget
+ * @param layout_id layout to apply
+ * @return true on success, false if the layout doesn't exist
+ */
+bool keyboard_set_layout(lv_obj_t *keyboard, sq2lv_layout_id_t layout_id);
+
+/**
+ * Switch layers if a button is a layer switcher in the current layer.
+ *
+ * @param keyboard keyboard widget
+ * @param btn_id ID of the pressed button
+ * @return true if the button switched layers, false if it should be handled as a key press
+ */
+bool keyboard_switch_layer(lv_obj_t *keyboard, uint16_t btn_id);
+
+#endif /* KEYBOARD_H */
@@ -0,0 +1,25 @@
+/**
+ * Auto-generated with compact-layouts.py
+ **/
+
+#ifndef KEYBOARD_LAYERS_H
+#define KEYBOARD_LAYERS_H
+
+#include <stdint.h>
+
+/* Number of layouts, same order as sq2lv_layouts */
+#define KEYBOARD_LAYERS_NUM_LAYOUTS 4
+/* Largest number of layers of any layout */
+#define KEYBOARD_LAYERS_MAX_LAYERS 5
+/* Largest number of buttons of any layer */
+#define KEYBOARD_LAYERS_MAX_BUTTONS 37
+/* Marks buttons that don't switch layers */
+#define KEYBOARD_LAYERS_NONE (-1)
+
+/* Bitset of the layer switching buttons, indexed by layout and layer, bit N is button ID N */
+extern const uint64_t keyboard_layers_switchers[KEYBOARD_LAYERS_NUM_LAYOUTS][KEYBOARD_LAYERS_MAX_LAYERS];
+
+/* Layer each button switches to, indexed by layout, layer and button ID */
+extern const int8_t keyboard_layers_targets[KEYBOARD_LAYERS_NUM_LAYOUTS][KEYBOARD_LAYERS_MAX_LAYERS][KEYBOARD_LAYERS_MAX_BUTTONS];
+
+#endif /* KEYBOARD_LAYERS_H */
@@ -0,0 +1,398 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "log.h"
+
+#include "tick.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Defines
+ */
+
+/* Number of messages that can be queued */
+#define LOG_SLOTS 256
+/* Maximum length of a message including the terminator, longer messages are truncated */
+#define LOG_MESSAGE_SIZE 240
+/* Maximum length of a formatted line */
+#define LOG_LINE_SIZE (LOG_MESSAGE_SIZE + 32)
+/* Size the persisted log grows to before it is rotated, the tail spans up to twice as much */
+#define LOG_PERSIST_SIZE (32 * 1024)
+/* Size of the buffer lines are collected in before they are written */
+#define LOG_BATCH_SIZE (8 * 1024)
+/* Path of the kernel log */
+#define LOG_KMSG_PATH "/dev/kmsg"
+
+
+/**
+ * Static types
+ */
+
+/* A queued message */
+typedef struct {
+    /* Equals the queue position the slot can be written at, or that position + 1 once written */
+    atomic_size_t sequence;
+    log_level level;
+    /* Monotonic time the message was logged at */
+    uint64_t time_us;
+    char text[LOG_MESSAGE_SIZE];
+} slot;
+
+
+/**
+ * Static variables
+ */
+
+static slot slots[LOG_SLOTS];
+/* Next position to write at, shared by all producers */
+static atomic_size_t head = 0;
+/* Next position to read from, guarded by drain_lock */
+static size_t tail = 0;
+static atomic_size_t num_dropped = 0;
+
+static atomic_int max_level = LOG_LEVEL_INFO;
+static atomic_bool is_running = false;
+
+static log_sink current_sink = LOG_SINK_STDERR;
+static int sink_fd = STDERR_FILENO;
+
+static char file_path[PATH_MAX];
+static char rotated_path[PATH_MAX];
+static int persist_fd = -1;
+static size_t persist_size = 0;
+
+static sem_t pending;
+static pthread_mutex_t drain_lock = PTHREAD_MUTEX_INITIALIZER;
+static char batch[LOG_BATCH_SIZE];
+static size_t batch_len = 0;
+
+static const char level_letters[] = { 'E', 'W', 'I', 'V', 'D' };
+/* Syslog priorities of the levels */
+static const int kmsg_priorities[] = { 3, 4, 6, 7, 7 };
+
+
+/**
+ * Static prototypes
+ */
+
+/**
+ * Format a message as a line for STDERR and the persisted log.
+ *
+ * @param line buffer of LOG_LINE_SIZE bytes for writing the line into
+ * @param level level of the message
+ * @param time_us monotonic time the message was logged at
+ * @param text the message
+ * @return length of the line
+ */
+static size_t format_line(char *line, log_level level, uint64_t time_us, const char *text);
+
+/**
+ * Write a buffer in full, retrying on interruptions.
+ *
+ * @param fd file descriptor to write to
+ * @param buf the buffer
+ * @param len number of bytes
+ */
+static void write_all(int fd, const char *buf, size_t len);
+
+/**
+ * Append lines to the persisted log, rotating it if it grows too large.
+ *
+ * @param buf the lines
+ * @param len number of bytes
+ */
+static void persist(const char *buf, size_t len);
+
+/**
+ * Write and clear the current batch.
+ */
+static void flush_batch(void);
+
+/**
+ * Hand a message to the sink and the persisted log. Must be called with drain_lock held.
+ *
+ * @param level level of the message
+ * @param time_us monotonic time the message was logged at
+ * @param text the message
+ */
+static void emit(log_level level, uint64_t time_us, const char *text);
+
+/**
+ * Write all queued messages.
+ */
+static void drain(void);
+
+/**
+ * Writer thread.
+ *
+ * @param arg unused
+ * @return NULL
+ */
+static void *writer(void *arg);
+
+/**
+ * Write messages right away in forked children, which don't have the writer thread.
+ */
+static void handle_fork_child(void);
+
+
+/**
+ * Static functions
+ */
+
+static size_t format_line(char *line, log_level level, uint64_t time_us, const char *text) {
+    size_t text_len = strlen(text);
+    while (text_len > 0 && text[text_len - 1] == '\n') {
+        --text_len;
+    }
+
+    int len = snprintf(line, LOG_LINE_SIZE, "[%5llu.%06llu] %c: %.*s\n", (unsigned long long)(time_us / 1000000),
+        (unsigned long long)(time_us % 1000000), level_letters[level], (int)text_len, text);
+    return len < LOG_LINE_SIZE ? (size_t)len : LOG_LINE_SIZE - 1;
+}
+
+static void write_all(int fd, const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t written = write(fd, buf, len);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return;
+        }
+        buf += written;
+        len -= written;
+    }
+}
+
+static void persist(const char *buf, size_t len) {
+    if (persist_fd < 0) {
+        return;
+    }
+
+    if (persist_size + len > LOG_PERSIST_SIZE) {
+        close(persist_fd);
+        rename(file_path, rotated_path);
+        persist_fd = open(file_path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0600);
+        persist_size = 0;
+        if (persist_fd < 0) {
+            return;
+        }
+    }
+
+    write_all(persist_fd, buf, len);
+    persist_size += len;
+}
+
+static void flush_batch(void) {
+    if (batch_len == 0) {
+        return;
+    }
+    if (current_sink == LOG_SINK_STDERR) {
+        write_all(sink_fd, batch, batch_len);
+    }
+    persist(batch, batch_len);
+    batch_len = 0;
+}
+
+static void emit(log_level level, uint64_t time_us, const char *text) {
+    if (batch_len + LOG_LINE_SIZE > sizeof(batch)) {
+        flush_batch();
+    }
+    batch_len += format_line(batch + batch_len, level, time_us, text);
+
+    if (current_sink == LOG_SINK_KMSG) {
+        /* The kernel log takes one record per write */
+        char record[LOG_LINE_SIZE];
+        int len = snprintf(record, sizeof(record), "<%d>furios-recovery: %s", kmsg_priorities[level], text);
+        write_all(sink_fd, record, len < (int)sizeof(record) ? (size_t)len : sizeof(record) - 1);
+    }
+}
+
+static void drain(void) {
+    pthread_mutex_lock(&drain_lock);
+
+    while (true) {
+        slot *s = &slots[tail % LOG_SLOTS];
+        if (atomic_load_explicit(&s->sequence, memory_order_acquire) != tail + 1) {
+            break;
+        }
+        emit(s->level, s->time_us, s->text);
+        atomic_store_explicit(&s->sequence, tail + LOG_SLOTS, memory_order_release);
+        ++tail;
+    }
+
+    const size_t dropped = atomic_exchange(&num_dropped, 0);
+    if (dropped > 0) {
+        char text[64];
+        snprintf(text, sizeof(text), "%zu log messages dropped", dropped);
+        emit(LOG_LEVEL_WARNING, tick_now_us(), text);
+    }
+
+    flush_batch();
+    pthread_mutex_unlock(&drain_lock);
+}
+
+static void *writer(void *arg) {
+    (void)arg;
+
+    while (true) {
+        if (sem_wait(&pending) != 0 && errno == EINTR) {
+            continue;
+        }
+        drain();
+    }
+    return NULL;
+}
+
+static void handle_fork_child(void) {
+    atomic_store(&is_running, false);
+}
+
+
+/**
+ * Public functions
+ */
+
+bool log_init(log_level level, log_sink sink, const char *persist_path) {
+    atomic_store(&max_level, level);
+
+    if (sink == LOG_SINK_KMSG) {
+        int fd = open(LOG_KMSG_PATH, O_WRONLY | O_CLOEXEC);
+        if (fd < 0) {
+            log_warning("Could not open " LOG_KMSG_PATH ", logging to STDERR: %s", strerror(errno));
+        } else {
+            current_sink = LOG_SINK_KMSG;
+            sink_fd = fd;
+        }
+    }
+
+    if (persist_path != NULL) {
+        if (snprintf(file_path, sizeof(file_path), "%s", persist_path) >= (int)sizeof(file_path)
+                || snprintf(rotated_path, sizeof(rotated_path), "%s.old", persist_path) >= (int)sizeof(rotated_path)) {
+            log_warning("Log file path %s is too long, not keeping the log", persist_path);
+        } else {
+            /* Keep appending across launches, rotation bounds the size */
+            persist_fd = open(file_path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+            struct stat st;
+            if (persist_fd < 0) {
+                log_warning("Could not open log file %s: %s", file_path, strerror(errno));
+            } else if (fstat(persist_fd, &st) == 0) {
+                persist_size = st.st_size;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < LOG_SLOTS; ++i) {
+        atomic_init(&slots[i].sequence, i);
+    }
+
+    if (sem_init(&pending, 0, 0) != 0) {
+        log_error("Could not create log semaphore: %s", strerror(errno));
+        return false;
+    }
+
+    pthread_t thread;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int result = pthread_create(&thread, &attr, writer, NULL);
+    pthread_attr_destroy(&attr);
+    if (result != 0) {
+        log_error("Could not start log writer: %s", strerror(result));
+        return false;
+    }
+
+    pthread_atfork(NULL, NULL, handle_fork_child);
+    atexit(log_flush);
+    atomic_store(&is_running, true);
+    return true;
+}
+
+void log_message(log_level level, const char *format, ...) {
+    if ((int)level > atomic_load_explicit(&max_level, memory_order_relaxed)) {
+        return;
+    }
+
+    const int saved_errno = errno;
+    va_list args;
+
+    if (!atomic_load_explicit(&is_running, memory_order_acquire)) {
+        char text[LOG_MESSAGE_SIZE];
+        char line[LOG_LINE_SIZE];
+        va_start(args, format);
+        vsnprintf(text, sizeof(text), format, args);
+        va_end(args);
+        write_all(STDERR_FILENO, line, format_line(line, level, tick_now_us(), text));
+        errno = saved_errno;
+        return;
+    }
+
+    /* Claim a free slot, see Vyukov's bounded MPMC queue */
+    size_t pos = atomic_load_explicit(&head, memory_order_relaxed);
+    slot *s;
+    while (true) {
+        s = &slots[pos % LOG_SLOTS];
+        const size_t sequence = atomic_load_explicit(&s->sequence, memory_order_acquire);
+        const intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&head, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            /* The writer is behind, dropping the message beats blocking the UI */
+            atomic_fetch_add_explicit(&num_dropped, 1, memory_order_relaxed);
+            errno = saved_errno;
+            return;
+        } else {
+            pos = atomic_load_explicit(&head, memory_order_relaxed);
+        }
+    }
+
+    s->level = level;
+    s->time_us = tick_now_us();
+    errno = saved_errno;
+    va_start(args, format);
+    vsnprintf(s->text, sizeof(s->text), format, args);
+    va_end(args);
+    atomic_store_explicit(&s->sequence, pos + 1, memory_order_release);
+
+    sem_post(&pending);
+    errno = saved_errno;
+}
+
+void log_flush(void) {
+    if (atomic_load(&is_running)) {
+        drain();
+    }
+}
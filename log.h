@@ -0,0 +1,91 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LOG_H
+#define LOG_H
+
+/* NOTE: This header is included from heap.c and must not include LVGL */
+
+#include <stdbool.h>
+
+/* Log levels, from most to least severe */
+typedef enum {
+    LOG_LEVEL_ERROR = 0,
+    LOG_LEVEL_WARNING = 1,
+    LOG_LEVEL_INFO = 2,
+    LOG_LEVEL_VERBOSE = 3,
+    LOG_LEVEL_DEBUG = 4
+} log_level;
+
+/* Where log messages are written to */
+typedef enum {
+    LOG_SINK_STDERR = 0,
+    LOG_SINK_KMSG = 1
+} log_sink;
+
+/* Most detailed level that is compiled in, calls for more detailed levels are eliminated */
+#ifndef LOG_MAX_LEVEL
+#define LOG_MAX_LEVEL LOG_LEVEL_VERBOSE
+#endif
+
+/* Log a printf style message at a given level. Appends a newline. */
+#define log_write(level, ...) \
+    do { \
+        if ((level) <= LOG_MAX_LEVEL) { \
+            log_message((level), __VA_ARGS__); \
+        } \
+    } while (0)
+
+#define log_error(...) log_write(LOG_LEVEL_ERROR, __VA_ARGS__)
+#define log_warning(...) log_write(LOG_LEVEL_WARNING, __VA_ARGS__)
+#define log_info(...) log_write(LOG_LEVEL_INFO, __VA_ARGS__)
+#define log_verbose(...) log_write(LOG_LEVEL_VERBOSE, __VA_ARGS__)
+#define log_debug(...) log_write(LOG_LEVEL_DEBUG, __VA_ARGS__)
+
+/**
+ * Start the background writer. Until this is called, and in forked children, messages are written
+ * to STDERR right away. Messages queued at exit are written before the process ends.
+ *
+ * @param level most detailed level to log
+ * @param sink where to write messages to
+ * @param persist_path file to keep the tail of the log in, rotated to PATH.old when it fills up,
+ *        NULL to not keep one
+ * @return true on success, false if messages keep being written right away
+ */
+bool log_init(log_level level, log_sink sink, const char *persist_path);
+
+/**
+ * Queue a message for the writer. Never blocks, if the queue is full the message is counted as
+ * dropped. Use the log_* macros instead of calling this directly. errno is preserved, so it can
+ * still be checked after logging a failure. Pass strerror(errno) rather than using %m, which
+ * isn't ISO C.
+ *
+ * @param level level of the message
+ * @param format printf style format
+ */
+void log_message(log_level level, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+/**
+ * Write all queued messages and wait until they are written. Call before the process is replaced
+ * or the device reboots.
+ */
+void log_flush(void);
+
+#endif /* LOG_H */
@@ -18,6 +18,8 @@
  */
 
 #include "lvm.h"
+#include "log.h"
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -50,20 +52,20 @@ int is_lv_encrypted_with_luks(const char *device_path, size_t print_bytes) {
 
     fd = open(device_path, O_RDONLY);
     if (fd == -1) {
-        perror("Error opening device");
+        log_error("Error opening device: %s", strerror(errno));
         return -1;
     }
 
     buffer = malloc(print_bytes);
     if (buffer == NULL) {
-        fprintf(stderr, "Memory allocation failed\n");
+        log_error("Memory allocation failed");
         close(fd);
         return -1;
     }
 
     read_bytes = read(fd, buffer, print_bytes);
     if (read_bytes == -1) {
-        perror("Error reading device");
+        log_error("Error reading device: %s", strerror(errno));
         close(fd);
         free(buffer);
         return -1;
@@ -90,25 +92,25 @@ int mount_luks_lvm(const char *passphrase) {
 
     result = crypt_init(&cd, DEVICE);
     if (result < 0) {
-        fprintf(stderr, "crypt_init() failed: %s\n", strerror(-result));
+        log_error("crypt_init() failed: %s", strerror(-result));
         return EXIT_FAILURE;
     }
 
     // Load the LUKS header from the given header device.
     if (result < 0) {
-        fprintf(stderr, "crypt_load() failed: %s\n", strerror(-result));
+        log_error("crypt_load() failed: %s", strerror(-result));
         crypt_free(cd);
         return EXIT_FAILURE;
     }
 
     result = crypt_activate_by_passphrase(cd, NAME, CRYPT_ANY_SLOT, passphrase, strlen(passphrase), 0);
     if (result < 0) {
-        fprintf(stderr, "Activation failed: Incorrect passphrase or other error.\n");
+        log_error("Activation failed: Incorrect passphrase or other error.");
         crypt_free(cd);
         return 2;
     }
 
-    printf("LUKS device %s activated successfully.\n", NAME);
+    log_info("LUKS device %s activated successfully.", NAME);
 
     crypt_free(cd);
 
@@ -122,22 +124,22 @@ int mount_luks_lvm_droidian_helper(const char *passphrase) {
 
     int pipefd[2];
     if (pipe(pipefd) == -1) {
-        perror("pipe");
+        log_error("pipe: %s", strerror(errno));
         return EXIT_FAILURE;
     }
 
     pid_t pid = fork();
     if (pid == -1) {
-        perror("fork");
+        log_error("fork: %s", strerror(errno));
         return EXIT_FAILURE;
     }
 
     if (pid == 0) {
         close(pipefd[1]);
         if (dup2(pipefd[0], STDIN_FILENO) == -1) {
-            perror("dup2");
+            log_error("dup2: %s", strerror(errno));
             close(pipefd[0]);
-            return EXIT_FAILURE;
+            _exit(EXIT_FAILURE);
         }
         close(pipefd[0]);
 
@@ -148,8 +150,8 @@ int mount_luks_lvm_droidian_helper(const char *passphrase) {
                "--strip-newlines",
                (char *)NULL);
 
-        perror("execlp");
-        return EXIT_FAILURE;
+        log_error("execlp: %s", strerror(errno));
+        _exit(EXIT_FAILURE);
     } else {
         close(pipefd[0]);
         write(pipefd[1], passphrase, strlen(passphrase));
@@ -21,14 +21,29 @@
 
 
 #include "backends.h"
+#include "backlight.h"
 #include "command_line.h"
 #include "config.h"
+#include "deferred.h"
+#include "device_state.h"
+#include "event_loop.h"
+#include "fonts.h"
+#include "heap.h"
+#include "idle.h"
+#include "image.h"
 #include "indev.h"
+#include "keyboard.h"
+#include "log.h"
+#include "profile.h"
+#include "render.h"
+#include "startup.h"
 #include "furios-recovery.h"
 #include "terminal.h"
 #include "theme.h"
 #include "themes.h"
 #include "lvm.h"
+#include "factory_reset.h"
+#include "worker.h"
 
 #include "lv_drv_conf.h"
 
@@ -44,26 +59,22 @@
 
 #include "lvgl/lvgl.h"
 
-#include "squeek2lvgl/sq2lv.h"
-
-#include <pthread.h>
+#include <errno.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
-#include <dirent.h>
-#include <errno.h>
 
 #include <sys/reboot.h>
-#include <sys/time.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
 
 #define NUM_IMAGES 1
 #define MIN_BRIGHTNESS 5
-#define BRIGHTNESS_PATH "/sys/class/leds/lcd-backlight/brightness"
-#define MAX_BRIGHTNESS_PATH "/sys/class/leds/lcd-backlight/max_brightness"
+/* Heap arena for the password screen, which is created and deleted repeatedly */
+#define DECRYPT_ARENA_SIZE (64U * 1024U)
 
 /**
  * Static variables
@@ -72,9 +83,6 @@
 cli_opts cli_options;
 config_opts conf_opts;
 
-static lv_color_t *buf = NULL;
-static lv_disp_draw_buf_t disp_buf;
-
 bool is_alternate_theme = true;
 bool is_password_obscured = true;
 bool is_keyboard_hidden = true;
@@ -102,12 +110,25 @@ lv_obj_t *textarea_container = NULL;
 lv_obj_t *textarea = NULL;
 lv_obj_t *toggle_pw_btn = NULL;
 lv_obj_t *toggle_kb_btn = NULL;
+lv_obj_t *unlock_spinner = NULL;
+static heap_arena decrypt_arena;
+
+/* Password check */
+static worker *unlock_worker = NULL;
+static lv_timer_t *unlock_timer = NULL;
 
-LV_IMG_DECLARE(furilabs_white)
-LV_IMG_DECLARE(furilabs_black)
+/* Factory reset progress */
+static worker *reset_worker = NULL;
+static lv_timer_t *reset_timer = NULL;
+static lv_obj_t *reset_mbox = NULL;
+static lv_obj_t *reset_bar = NULL;
+static lv_obj_t *reset_status_label = NULL;
 
-const void *darkmode_imgs[] = {&furilabs_white};
-const void *lightmode_imgs[] = {&furilabs_black};
+extern const image_rle_t furilabs_white;
+extern const image_rle_t furilabs_black;
+
+const image_rle_t *darkmode_imgs[] = {&furilabs_white};
+const image_rle_t *lightmode_imgs[] = {&furilabs_black};
 
 /*
    0: FuriLabs logo
@@ -259,7 +280,7 @@ static void factory_reset_btn_clicked_cb(lv_event_t *event);
 /**
  * Handle LV_EVENT_CLICKED events from the factory reset confirmation button.
  */
-static void perform_factory_reset(lv_timer_t *timer);
+static void perform_factory_reset(void);
 
 /**
  * Handle LV_EVENT_VALUE_CHANGED events from the factory reset message box.
@@ -268,11 +289,6 @@ static void perform_factory_reset(lv_timer_t *timer);
  */
 static void factory_reset_mbox_value_changed_cb(lv_event_t *event);
 
-/**
- * Handle LV_EVENT_CLICKED events from the factory reset failed messsage box
- */
-static void close_mbox_cb(lv_event_t *event);
-
 /**
  * Handle LV_EVENT_VALUE_CHANGED events from the keyboard widget.
  *
@@ -288,38 +304,91 @@ static void keyboard_value_changed_cb(lv_event_t *event);
 static void textarea_ready_cb(lv_event_t *event);
 
 /**
- * Check password against LVM for SSH access
+ * Start unlocking LVM with the password from the textarea on a worker thread.
  *
  * @param textarea the textarea widget
  */
-static void check_password_enable_ssh(lv_obj_t *textarea);
+static void start_unlock(lv_obj_t *textarea);
 
 /**
- * Check password against LVM for factory reset
+ * Unlock worker job.
  *
- * @param textarea the textarea widget
+ * @param w the worker
+ * @param user_data heap allocated copy of the password, wiped and freed by the job
+ * @return result of mount_luks_lvm_droidian_helper
+ */
+static int unlock_job(worker *w, void *user_data);
+
+/**
+ * Wait for the unlock worker to finish and dispatch its result.
+ *
+ * @param timer the timer
+ */
+static void unlock_timer_cb(lv_timer_t *timer);
+
+/**
+ * Handle the result of unlocking LVM for SSH access
+ *
+ * @param result result of mount_luks_lvm_droidian_helper
+ */
+static void check_password_enable_ssh(int result);
+
+/**
+ * Handle the result of unlocking LVM for factory reset
+ *
+ * @param result result of mount_luks_lvm_droidian_helper
+ */
+static void check_password_factory_reset(int result);
+
+/**
+ * Start the factory reset on a worker thread and show its progress.
+ */
+static void start_factory_reset(void);
+
+/**
+ * Factory reset worker job.
+ *
+ * @param w the worker
+ * @param user_data unused
+ * @return result of factory_reset
+ */
+static int factory_reset_job(worker *w, void *user_data);
+
+/**
+ * Forward factory reset progress to the worker's event queue. Runs on the worker thread.
+ *
+ * @param phase description of the current phase
+ * @param bytes_done number of bytes processed in the current phase
+ * @param bytes_total total number of bytes of the current phase
+ * @param user_data the worker
  */
-static void check_password_factory_reset(lv_obj_t *textarea);
+static void factory_reset_progress_cb(const char *phase, uint64_t bytes_done, uint64_t bytes_total, void *user_data);
 
 /**
- * Handle LV_EVENT_CLICKED events from the password check
+ * Drain the factory reset worker's event queue and update the progress message box.
+ *
+ * @param timer the timer
  */
-static void factory_reset_password(lv_timer_t *timer);
+static void factory_reset_progress_timer_cb(lv_timer_t *timer);
 
 /**
- * Returns current slot suffix from cmdline
+ * Replace the progress message box with the factory reset's outcome.
+ *
+ * @param result result of factory_reset
  */
-static char* get_slot_suffix(void);
+static void finish_factory_reset(int result);
 
 /**
- * Drop all caches on device
+ * Show a message box about a failed factory reset.
  */
-static int drop_caches(void);
+static void show_factory_reset_failed(void);
 
 /**
- * Factory resets the device
+ * Handle LV_EVENT_VALUE_CHANGED events from the factory reset failed message box by closing it.
+ *
+ * @param event the event object
  */
-static int factory_reset(void);
+static void close_fail_mbox_cb(lv_event_t *event);
 
 /**
  * Restores the screen from the decryption page
@@ -342,39 +411,41 @@ static void reboot_device(void);
 static void shutdown(void);
 
 /**
- * Launch another instance of recovery before exiting in open_terminal
- *
- * @param unused
+ * Release the display so that another program can use it. LVGL and the object tree stay alive.
  */
-static void* run_recovery(void* arg);
+static void suspend_display(void);
 
 /**
- * Opens furios-terminal
+ * Reclaim the display after suspend_display and redraw the whole screen.
  */
-static void open_terminal(void);
+static void resume_display(void);
 
 /**
- * Handle termination signals sent to the process.
+ * Suspend the UI, run furios-terminal until it exits and resume the UI. Runs as an async call so
+ * that the input device that asked for it has finished its read.
  *
- * @param signum the signal's number
+ * @param user_data unused
  */
-static void sigaction_handler(int signum);
+static void open_terminal(void *user_data);
 
 /**
- * Read a value from given path and return the value
+ * Offer to shut down once there was no input for general.timeout seconds.
+ */
+static void idle_timeout_cb(void);
+
+/**
+ * Forward LVGL's log messages to the log.
  *
- * @paran path is the path of the file
- * @param default_value is the default value if there was an error
+ * @param buf formatted message
  */
-static int read_int_from_file(const char *path, int default_value);
+static void lvgl_log_cb(const char *buf);
 
 /**
- * Write a value to a given path
+ * Handle termination signals sent to the process.
  *
- * @paran path is the path of the file
- * @param value is the value requeted for writing
+ * @param signum the signal's number
  */
-static int write_int_to_file(const char *path, int value);
+static void sigaction_handler(int signum);
 
 /**
  * Create all buttons in the label container
@@ -396,6 +467,11 @@ static void create_ui(uint32_t hor_res, uint32_t ver_res);
  */
 static void initialize_recovery_ui(void);
 
+/**
+ * Print the startup trace and exit if requested, once the first frame is on screen
+ */
+static void first_frame_cb(void);
+
 /**
  * Static functions
  */
@@ -413,8 +489,19 @@ static void toggle_theme(void) {
 }
 
 static void update_image_mode(bool is_alternate) {
-    for (int i = 0; i < NUM_IMAGES; i++)
-        lv_img_set_src(images[i], is_alternate ? lightmode_imgs[i] : darkmode_imgs[i]);
+    const lv_coord_t max_width = lv_disp_get_hor_res(NULL) * 9 / 10;
+    const lv_coord_t max_height = lv_disp_get_ver_res(NULL) / 3;
+
+    for (int i = 0; i < NUM_IMAGES; i++) {
+        const lv_img_dsc_t *dsc = image_get(is_alternate ? lightmode_imgs[i] : darkmode_imgs[i], max_width, max_height);
+        if (dsc == NULL) {
+            /* Keep showing the other variant, releasing it would leave the widget with freed pixels */
+            continue;
+        }
+        lv_img_set_src(images[i], dsc);
+        /* Only keep the variant on screen decoded, the other one is decoded again on the next toggle */
+        image_release(is_alternate ? darkmode_imgs[i] : lightmode_imgs[i]);
+    }
 }
 
 static void set_theme(bool is_alternate) {
@@ -475,7 +562,7 @@ static void brightness_slider_changed_cb(lv_event_t *event) {
         lv_slider_set_value(slider, value, LV_ANIM_OFF);
     }
 
-    write_int_to_file(BRIGHTNESS_PATH, value);
+    backlight_set(value);
 }
 
 static void shutdown_btn_clicked_cb(lv_event_t *event) {
@@ -490,7 +577,7 @@ static void shutdown_btn_clicked_cb(lv_event_t *event) {
 static void shutdown_mbox_value_changed_cb(lv_event_t *event) {
     lv_obj_t *mbox = lv_event_get_current_target(event);
     if (lv_msgbox_get_active_btn(mbox) == 0) {
-        shutdown();
+        deferred_action_schedule("Shutting down", 3, true, shutdown);
     }
     lv_msgbox_close(mbox);
 }
@@ -507,7 +594,7 @@ static void terminal_btn_clicked_cb(lv_event_t *event) {
 static void terminal_mbox_value_changed_cb(lv_event_t *event) {
     lv_obj_t *mbox = lv_event_get_current_target(event);
     if (lv_msgbox_get_active_btn(mbox) == 0) {
-        open_terminal();
+        lv_async_call(open_terminal, NULL);
     }
     lv_msgbox_close(mbox);
 }
@@ -524,7 +611,7 @@ static void reboot_btn_clicked_cb(lv_event_t *event) {
 static void reboot_mbox_value_changed_cb(lv_event_t *event) {
     lv_obj_t *mbox = lv_event_get_current_target(event);
     if (lv_msgbox_get_active_btn(mbox) == 0) {
-        reboot_device();
+        deferred_action_schedule("Rebooting", 3, true, reboot_device);
     }
     lv_msgbox_close(mbox);
 }
@@ -540,387 +627,232 @@ static void factory_reset_btn_clicked_cb(lv_event_t *event) {
 
 static void factory_reset_mbox_value_changed_cb(lv_event_t *event) {
     lv_obj_t *mbox = lv_event_get_current_target(event);
-    if (lv_msgbox_get_active_btn(mbox) == 0) {
-        lv_msgbox_close(mbox);
-
-        lv_obj_t *resetting_mbox = lv_msgbox_create(NULL, NULL, "Resetting device...", NULL, false);
-        lv_obj_set_size(resetting_mbox, 400, LV_SIZE_CONTENT);
-        lv_obj_center(resetting_mbox);
+    bool confirmed = lv_msgbox_get_active_btn(mbox) == 0;
+    lv_msgbox_close(mbox);
 
-        lv_timer_t *timer = lv_timer_create(perform_factory_reset, 500, resetting_mbox);
-        lv_timer_set_repeat_count(timer, 1);
-    } else {
-        lv_msgbox_close(mbox);
+    if (confirmed) {
+        perform_factory_reset();
     }
 }
 
-static void perform_factory_reset(lv_timer_t *timer) {
-    lv_obj_t *resetting_mbox = (lv_obj_t *)timer->user_data;
-    const char *lvm_device_path = "/dev/droidian/droidian-reserved";
-    size_t print_bytes = 64;
-    int result = is_lv_encrypted_with_luks(lvm_device_path, print_bytes);
+static void perform_factory_reset(void) {
+    int result = device_state_get_lvm_encrypted();
 
     if (result == -1) {
         // rootfs.img in data? well we can't reset that for now
-        lv_msgbox_close(resetting_mbox);
-        static const char *btns[] = {"OK", ""};
-        lv_obj_t *fail_mbox = lv_msgbox_create(NULL, NULL, "Failed to factory reset", btns, false);
-        lv_obj_set_size(fail_mbox, 400, LV_SIZE_CONTENT);
-        lv_obj_add_event_cb(fail_mbox, close_mbox_cb, LV_EVENT_VALUE_CHANGED, NULL);
-        lv_obj_center(fail_mbox);
+        show_factory_reset_failed();
+    } else if (result == 1) {
+        enabling_ssh = false;
+        decrypt(); // Decrypt LVM if necessary
     } else {
-        if (result == 1) {
-            enabling_ssh = false;
-            decrypt(); // Decrypt LVM if necessary
-            lv_msgbox_close(resetting_mbox);
-            return;
-        }
-
         // LVM is not encrypted or unlocked, we can continue
-        int factory_reset_result = factory_reset();
-
-        lv_msgbox_close(resetting_mbox);
-
-        if (factory_reset_result == 0) {
-            static const char *btns[] = {"OK", ""};
-            lv_obj_t *success_mbox = lv_msgbox_create(NULL, NULL, "Successfully reset to factory settings", btns, false);
-            lv_obj_set_size(success_mbox, 400, LV_SIZE_CONTENT);
-            lv_obj_add_event_cb(success_mbox, close_mbox_cb, LV_EVENT_VALUE_CHANGED, NULL);
-            lv_obj_center(success_mbox);
-        } else {
-            static const char *btns[] = {"OK", ""};
-            lv_obj_t *error_mbox = lv_msgbox_create(NULL, NULL, "Failed to factory reset", btns, false);
-            lv_obj_set_size(error_mbox, 400, LV_SIZE_CONTENT);
-            lv_obj_add_event_cb(error_mbox, close_mbox_cb, LV_EVENT_VALUE_CHANGED, NULL);
-            lv_obj_center(error_mbox);
-        }
+        start_factory_reset();
     }
 }
 
-static void close_mbox_cb(lv_event_t *event) {
-    lv_obj_t *mbox = lv_event_get_current_target(event);
+static void start_factory_reset(void) {
+    reset_mbox = lv_msgbox_create(NULL, NULL, "Resetting device...", NULL, false);
+    lv_obj_set_size(reset_mbox, 400, LV_SIZE_CONTENT);
 
-    // maybe do something instead of sleep?
-    sleep(3);
-    reboot_device();
-    lv_msgbox_close(mbox);
-}
+    lv_obj_t *content = lv_msgbox_get_content(reset_mbox);
+    reset_bar = lv_bar_create(content);
+    lv_obj_set_width(reset_bar, LV_PCT(100));
+    lv_bar_set_range(reset_bar, 0, 1000);
 
-static void keyboard_value_changed_cb(lv_event_t *event) {
-    lv_obj_t *kb = lv_event_get_target(event);
+    reset_status_label = lv_label_create(content);
+    lv_obj_set_width(reset_status_label, LV_PCT(100));
+    lv_label_set_text(reset_status_label, "");
 
-    uint16_t btn_id = lv_btnmatrix_get_selected_btn(kb);
-    if (btn_id == LV_BTNMATRIX_BTN_NONE) {
-        return;
-    }
+    lv_obj_center(reset_mbox);
 
-    if (sq2lv_is_layer_switcher(kb, btn_id)) {
-        sq2lv_switch_layer(kb, btn_id);
+    reset_worker = worker_start(factory_reset_job, NULL);
+    if (reset_worker == NULL) {
+        finish_factory_reset(-1);
         return;
     }
 
-    lv_keyboard_def_event_cb(event);
+    /* Poll at display rate, the worker coalesces updates in between */
+    reset_timer = lv_timer_create(factory_reset_progress_timer_cb, LV_DISP_DEF_REFR_PERIOD, NULL);
 }
 
-static void textarea_ready_cb(lv_event_t *event) {
-    if (enabling_ssh) {
-        check_password_enable_ssh(lv_event_get_target(event));
-    } else {
-        check_password_factory_reset(lv_event_get_target(event));
-    }
+static int factory_reset_job(worker *w, void *user_data) {
+    LV_UNUSED(user_data);
+    return factory_reset(factory_reset_progress_cb, w);
 }
 
-static void check_password_enable_ssh(lv_obj_t *textarea) {
-    const char *password = lv_textarea_get_text(textarea);
-    static int attempt_count = 0;
-    int result = mount_luks_lvm_droidian_helper(password);
+static void factory_reset_progress_cb(const char *phase, uint64_t bytes_done, uint64_t bytes_total, void *user_data) {
+    worker_post_progress(user_data, phase, bytes_done, bytes_total);
+}
 
-    if (result == EXIT_SUCCESS) {
-        enable_ssh();
-        restore_main_screen();
-    } else if (result == 2) {
-        attempt_count++;
-        if (attempt_count >= 3) {
-            lv_obj_t *error_mbox = lv_msgbox_create(NULL, NULL, "Maximum password attempt reached.", NULL, false);
-            lv_obj_set_size(error_mbox, 400, LV_SIZE_CONTENT);
-            lv_obj_center(error_mbox);
+static void factory_reset_progress_timer_cb(lv_timer_t *timer) {
+    LV_UNUSED(timer);
+    worker_event event;
+
+    while (reset_worker != NULL && worker_poll(reset_worker, &event)) {
+        if (event.type == WORKER_EVENT_DONE) {
+            finish_factory_reset(event.result);
+            return;
         }
-    }
-}
 
-static void check_password_factory_reset(lv_obj_t *textarea) {
-    const char *password = lv_textarea_get_text(textarea);
-    static int attempt_count = 0;
-    int result = mount_luks_lvm_droidian_helper(password);
+        if (event.bytes_total == 0) {
+            lv_label_set_text(reset_status_label, event.phase);
+            continue;
+        }
 
-    if (result == EXIT_SUCCESS) {
-        lv_obj_t *resetting_mbox = lv_msgbox_create(NULL, NULL, "Resetting device...", NULL, false);
-        lv_obj_set_size(resetting_mbox, 400, LV_SIZE_CONTENT);
-        lv_obj_center(resetting_mbox);
-        lv_timer_t *timer = lv_timer_create(factory_reset_password, 500, resetting_mbox);
-        lv_timer_set_repeat_count(timer, 1);
-    } else if (result == 2) {
-        attempt_count++;
-        if (attempt_count >= 3) {
-            lv_obj_t *resetting_mbox = lv_msgbox_create(NULL, NULL, "Maximum password attempt reached.", NULL, false);
-            lv_obj_set_size(resetting_mbox, 400, LV_SIZE_CONTENT);
-            lv_obj_center(resetting_mbox);
+        lv_bar_set_value(reset_bar, (int32_t)(event.bytes_done * 1000 / event.bytes_total), LV_ANIM_OFF);
+
+        const unsigned long long mib = 1024 * 1024;
+        if (event.eta_seconds >= 0) {
+            lv_label_set_text_fmt(reset_status_label, "%s\n%llu / %llu MiB, %llu MiB/s, %d:%02d left", event.phase,
+                (unsigned long long)event.bytes_done / mib, (unsigned long long)event.bytes_total / mib,
+                (unsigned long long)event.bytes_per_second / mib, event.eta_seconds / 60, event.eta_seconds % 60);
+        } else {
+            lv_label_set_text_fmt(reset_status_label, "%s\n%llu / %llu MiB", event.phase,
+                (unsigned long long)event.bytes_done / mib, (unsigned long long)event.bytes_total / mib);
         }
     }
 }
 
-static void factory_reset_password(lv_timer_t *timer) {
-    lv_obj_t *resetting_mbox = (lv_obj_t *)timer->user_data;
+static void finish_factory_reset(int result) {
+    if (reset_timer != NULL) {
+        lv_timer_del(reset_timer);
+        reset_timer = NULL;
+    }
 
-    int factory_reset_result = factory_reset();
+    worker_free(reset_worker);
+    reset_worker = NULL;
 
-    lv_msgbox_close(resetting_mbox);
+    lv_msgbox_close(reset_mbox);
+    reset_mbox = NULL;
+    reset_bar = NULL;
+    reset_status_label = NULL;
 
-    if (factory_reset_result == 0) {
-        static const char *btns[] = {"OK", ""};
-        lv_obj_t *success_mbox = lv_msgbox_create(NULL, NULL, "Successfully reset to factory settings", btns, false);
-        lv_obj_set_size(success_mbox, 400, LV_SIZE_CONTENT);
-        lv_obj_add_event_cb(success_mbox, close_mbox_cb, LV_EVENT_VALUE_CHANGED, NULL);
-        lv_obj_center(success_mbox);
+    if (result == 0) {
+        deferred_action_schedule("Successfully reset to factory settings, rebooting", 3, true, reboot_device);
     } else {
-        static const char *btns[] = {"OK", ""};
-        lv_obj_t *error_mbox = lv_msgbox_create(NULL, NULL, "Failed to factory reset", btns, false);
-        lv_obj_set_size(error_mbox, 400, LV_SIZE_CONTENT);
-        lv_obj_add_event_cb(error_mbox, close_mbox_cb, LV_EVENT_VALUE_CHANGED, NULL);
-        lv_obj_center(error_mbox);
+        show_factory_reset_failed();
     }
 }
 
-static char* get_slot_suffix() {
-    FILE* cmdline = fopen("/proc/cmdline", "r");
-    if (cmdline == NULL) {
-        perror("Error opening /proc/cmdline");
-        return NULL;
-    }
-
-    char buffer[1024];
-    char* result = NULL;
-    if (fgets(buffer, sizeof(buffer), cmdline) != NULL) {
-        char* token = strstr(buffer, "androidboot.slot_suffix=");
-        if (token != NULL) {
-            token += strlen("androidboot.slot_suffix=");
-            result = malloc(3 * sizeof(char));
-            if (result != NULL) {
-                strncpy(result, token, 2);
-                result[2] = '\0';
-            }
-        }
-    }
+static void show_factory_reset_failed(void) {
+    static const char *btns[] = {"OK", ""};
+    lv_obj_t *fail_mbox = lv_msgbox_create(NULL, NULL, "Failed to factory reset", btns, false);
+    lv_obj_set_size(fail_mbox, 400, LV_SIZE_CONTENT);
+    lv_obj_add_event_cb(fail_mbox, close_fail_mbox_cb, LV_EVENT_VALUE_CHANGED, NULL);
+    lv_obj_center(fail_mbox);
+}
 
-    fclose(cmdline);
-    return result;
+static void close_fail_mbox_cb(lv_event_t *event) {
+    /* Return to the main screen so that the user can retry, reboot or shut down */
+    lv_msgbox_close(lv_event_get_current_target(event));
 }
 
-static int drop_caches() {
-    int fd = open("/proc/sys/vm/drop_caches", O_WRONLY);
-    if (fd == -1) {
-        perror("Failed to open /proc/sys/vm/drop_caches");
-        return -1;
+static void keyboard_value_changed_cb(lv_event_t *event) {
+    lv_obj_t *kb = lv_event_get_target(event);
+
+    uint16_t btn_id = lv_btnmatrix_get_selected_btn(kb);
+    if (btn_id == LV_BTNMATRIX_BTN_NONE) {
+        return;
     }
 
-    if (write(fd, "1", 1) != 1) {
-        perror("Failed to write to /proc/sys/vm/drop_caches");
-        close(fd);
-        return -1;
+    if (keyboard_switch_layer(kb, btn_id)) {
+        return;
     }
 
-    close(fd);
-    return 0;
+    lv_keyboard_def_event_cb(event);
 }
 
-static int factory_reset(void) {
-    // the reason most things here are system calls is because our ramdisk must be small and more libraries we link against the bigger the binary will get
-    // here, we're using pre existing binaries in the ramdisk to not take too much storage in the ramdisk
-    struct stat buffer;
-    int result;
-    char cmd[1024];
-    char bootimg_file[256] = "";
-    char dtboimg_file[256] = "";
-    char* slot_suffix = get_slot_suffix();
-
-    // If no slot suffix is found, default to an empty string so that single slot devices can work
-    if (slot_suffix == NULL) {
-        slot_suffix = strdup("");
-    }
-
-    drop_caches(); // tar will fill up cache, has to be cleared before writing
+static void textarea_ready_cb(lv_event_t *event) {
+    start_unlock(lv_event_get_target(event));
+}
 
-    if (stat("/dev/disk/by-partlabel/super", &buffer) == 0) {
-        // if system_a doesn't exist
-        if (stat("/dev/mapper/dynpart-system_a", &buffer) != 0) {
-            // if system_b doesn't exist
-            if (stat("/dev/mapper/dynpart-system_b", &buffer) != 0) {
-                snprintf(cmd, sizeof(cmd), "dmsetup create --concise \"$(parse-android-dynparts /dev/disk/by-partlabel/super)\"");
-                system(cmd);
-            }
-        }
+static void start_unlock(lv_obj_t *textarea) {
+    if (unlock_worker != NULL) {
+        return; /* Key derivation still running */
     }
 
-    mkdir("/system_mnt", 0755);
-    if (stat("/dev/mapper/dynpart-system_a", &buffer) == 0) {
-        result = mount("/dev/mapper/dynpart-system_a", "/system_mnt", "ext4", 0, NULL);
-        if (result != 0) {
-            printf("Failed to mount dynpart-system_a\n");
-            free(slot_suffix);
-            return -1;
-        }
-    } else if (stat("/dev/mapper/dynpart-system_b", &buffer) == 0) {
-        result = mount("/dev/mapper/dynpart-system_b", "/system_mnt", "ext4", 0, NULL);
-        if (result != 0) {
-            printf("Failed to mount dynpart-system_b\n");
-            free(slot_suffix);
-            return -1;
-        }
-    } else {
-        printf("Failed to mount dynpart-system, block device doesn't not exist\n");
-        free(slot_suffix);
-        return -1;
+    char *password = strdup(lv_textarea_get_text(textarea));
+    if (password == NULL) {
+        return;
     }
 
-    if (stat("/system_mnt/userdata.img.tar.gz", &buffer) == 0) {
-        snprintf(cmd, sizeof(cmd), "tar -xzOf /system_mnt/userdata.img.tar.gz | dd of=/dev/disk/by-partlabel/userdata bs=4M");
-    } else if (stat("/system_mnt/userdata-raw.img.tar.gz", &buffer) == 0) {
-        snprintf(cmd, sizeof(cmd), "tar -xzOf /system_mnt/userdata-raw.img.tar.gz | dd of=/dev/disk/by-partlabel/userdata bs=4M");
-    } else {
-        printf("Failed to find userdata archive\n");
-        umount("/system_mnt");
-        free(slot_suffix);
-        return -1;
+    unlock_worker = worker_start(unlock_job, password);
+    if (unlock_worker == NULL) {
+        explicit_bzero(password, strlen(password));
+        free(password);
+        return;
     }
 
-    result = system(cmd);
-    if (result != 0) {
-        printf("Failed to extract and write userdata\n");
-        umount("/system_mnt");
-        free(slot_suffix);
-        return -1;
-    }
+    /* Key derivation takes seconds, keep the screen alive meanwhile */
+    lv_obj_add_state(textarea, LV_STATE_DISABLED);
+    const lv_coord_t spinner_size = lv_obj_get_height(textarea);
+    unlock_spinner = lv_spinner_create(decrypt_container, 1000, 60);
+    lv_obj_set_size(unlock_spinner, spinner_size, spinner_size);
 
-    if (stat("/system_mnt/boot.img", &buffer) == 0) {
-        snprintf(cmd, sizeof(cmd),
-                 "dd if=/system_mnt/boot.img of=/dev/disk/by-partlabel/boot%s bs=4M",
-                 slot_suffix);
-        result = system(cmd);
-        if (result != 0) {
-            printf("Failed to flash boot image%s%s\n",
-                   *slot_suffix ? " to slot suffix " : "",
-                   *slot_suffix ? slot_suffix : "");
-        } else {
-            printf("Flashed boot.img from /system_mnt\n");
-        }
-    } else {
-        printf("No /system_mnt/boot.img found.\n");
-    }
+    unlock_timer = lv_timer_create(unlock_timer_cb, LV_DISP_DEF_REFR_PERIOD, NULL);
+}
 
-    if (stat("/system_mnt/dtbo.img", &buffer) == 0) {
-        snprintf(cmd, sizeof(cmd),
-                 "dd if=/system_mnt/dtbo.img of=/dev/disk/by-partlabel/dtbo%s bs=4M",
-                 slot_suffix);
-        result = system(cmd);
-        if (result != 0) {
-            printf("Failed to flash dtbo image%s%s\n",
-                   *slot_suffix ? " to slot suffix " : "",
-                   *slot_suffix ? slot_suffix : "");
-        } else {
-            printf("Flashed dtbo.img from /system_mnt\n");
-        }
-    } else {
-        printf("No /system_mnt/dtbo.img found.\n");
-    }
+static int unlock_job(worker *w, void *user_data) {
+    LV_UNUSED(w);
+    char *password = user_data;
 
-    if (stat("/system_mnt/boot.img", &buffer) != 0 ||
-        stat("/system_mnt/dtbo.img", &buffer) != 0) {
-        if (stat("/dev/mapper/droidian-droidian--rootfs", &buffer) == 0) {
-            mkdir("/rootfs_mnt", 0755);
+    int result = mount_luks_lvm_droidian_helper(password);
 
-            result = mount("/dev/mapper/droidian-droidian--rootfs", "/rootfs_mnt", "ext4",0, NULL);
-            if (result != 0) {
-                printf("Failed to mount droidian-droidian--rootfs\n");
-                return -1;
-            }
+    explicit_bzero(password, strlen(password));
+    free(password);
+    return result;
+}
 
-            DIR *dir = opendir("/rootfs_mnt/boot");
-            if (dir == NULL) {
-                printf("Failed to opendir /rootfs_mnt/boot\n");
-                umount("/rootfs_mnt");
-                return -1;
-            }
+static void unlock_timer_cb(lv_timer_t *timer) {
+    LV_UNUSED(timer);
+    worker_event event;
 
-            struct dirent *entry;
-            while ((entry = readdir(dir)) != NULL) {
-                if (strncmp(entry->d_name, "boot.img", strlen("boot.img")) == 0) {
-                    strncpy(bootimg_file, entry->d_name, sizeof(bootimg_file) - 1);
-                    bootimg_file[sizeof(bootimg_file) - 1] = '\0';
-                    break;
-                }
-            }
+    /* The job doesn't post progress, the only event is the result */
+    if (!worker_poll(unlock_worker, &event) || event.type != WORKER_EVENT_DONE) {
+        return;
+    }
 
-            rewinddir(dir);
-            while ((entry = readdir(dir)) != NULL) {
-                if (strncmp(entry->d_name, "dtbo.img", strlen("dtbo.img")) == 0) {
-                    strncpy(dtboimg_file, entry->d_name, sizeof(dtboimg_file) - 1);
-                    dtboimg_file[sizeof(dtboimg_file) - 1] = '\0';
-                    break;
-                }
-            }
+    lv_timer_del(unlock_timer);
+    unlock_timer = NULL;
+    worker_free(unlock_worker);
+    unlock_worker = NULL;
 
-            closedir(dir);
+    lv_obj_del(unlock_spinner);
+    unlock_spinner = NULL;
+    lv_obj_clear_state(textarea, LV_STATE_DISABLED);
 
-            if (bootimg_file[0] != '\0') {
-                char boot_path[512];
-                snprintf(boot_path, sizeof(boot_path), "/rootfs_mnt/boot/%s", bootimg_file);
+    if (enabling_ssh) {
+        check_password_enable_ssh(event.result);
+    } else {
+        check_password_factory_reset(event.result);
+    }
+}
 
-                snprintf(cmd, sizeof(cmd),
-                         "dd if=\"%s\" of=\"/dev/disk/by-partlabel/boot%s\" bs=4M",
-                         boot_path, slot_suffix);
+static void check_password_enable_ssh(int result) {
+    static int attempt_count = 0;
 
-                result = system(cmd);
-                if (result != 0) {
-                    printf("Failed to flash boot image%s%s\n",
-                           *slot_suffix ? " to slot suffix " : "",
-                           *slot_suffix ? slot_suffix : "");
-                } else {
-                    printf("Flashed boot.img from /rootfs_mnt\n");
-                }
-            } else {
-                printf("Failed to find boot image in the rootfs\n");
-            }
+    if (result == EXIT_SUCCESS) {
+        enable_ssh();
+        restore_main_screen();
+    } else if (result == 2) {
+        attempt_count++;
+        if (attempt_count >= 3) {
+            deferred_action_schedule("Maximum password attempts reached, rebooting", 10, false, reboot_device);
+        }
+    }
+}
 
-            if (dtboimg_file[0] != '\0') {
-                char dtbo_path[512];
-                snprintf(dtbo_path, sizeof(dtbo_path), "/rootfs_mnt/boot/%s", dtboimg_file);
-
-                snprintf(cmd, sizeof(cmd),
-                         "dd if=\"%s\" of=\"/dev/disk/by-partlabel/dtbo%s\" bs=4M",
-                         dtbo_path, slot_suffix);
-
-                result = system(cmd);
-                if (result != 0) {
-                    printf("Failed to flash dtbo image%s%s\n",
-                           *slot_suffix ? " to slot suffix " : "",
-                           *slot_suffix ? slot_suffix : "");
-                } else {
-                    printf("Flashed dtbo.img from /rootfs_mnt\n");
-                }
-            } else {
-                printf("Failed to find dtbo image in the rootfs\n");
-            }
+static void check_password_factory_reset(int result) {
+    static int attempt_count = 0;
 
-            umount("/rootfs_mnt");
-        } else {
-            printf("No /system_mnt images found and /dev/mapper/droidian-droidian--rootfs not available.\n");
+    if (result == EXIT_SUCCESS) {
+        start_factory_reset();
+    } else if (result == 2) {
+        attempt_count++;
+        if (attempt_count >= 3) {
+            deferred_action_schedule("Maximum password attempts reached, rebooting", 10, false, reboot_device);
         }
     }
-
-    umount("/system_mnt");
-    drop_caches();
-    free(slot_suffix);
-    return 0;
 }
 
 static void restore_main_screen(void) {
@@ -942,6 +874,7 @@ static void restore_main_screen(void) {
         textarea = NULL;
         toggle_pw_btn = NULL;
         toggle_kb_btn = NULL;
+        unlock_spinner = NULL;
     }
 
     if (keyboard != NULL) {
@@ -949,6 +882,12 @@ static void restore_main_screen(void) {
         keyboard = NULL;
     }
 
+    /* Everything the password screen allocated is gone now, so its arena starts over */
+    if (!heap_arena_reset(&decrypt_arena)) {
+        log_error("Password screen arena still holds %zu allocations (%zu bytes), not rewinding it",
+            decrypt_arena.live, decrypt_arena.live_bytes);
+    }
+
     /* Re-enable scrolling on main screen */
     lv_obj_add_flag(lv_scr_act(), LV_OBJ_FLAG_SCROLLABLE);
 }
@@ -975,7 +914,7 @@ static void decrypt(void) {
         break;
 #endif /* USE_MINUI */
     default:
-        printf("Unable to find suitable backend\n");
+        log_error("Unable to find suitable backend");
         exit(EXIT_FAILURE);
     }
 
@@ -998,6 +937,12 @@ static void decrypt(void) {
     lv_obj_add_flag(terminal_btn, LV_OBJ_FLAG_HIDDEN);
     lv_obj_add_flag(ssh_btn, LV_OBJ_FLAG_HIDDEN);
 
+    /* Keep the password screen's allocations out of the main heap */
+    if (decrypt_arena.base == NULL) {
+        heap_arena_init(&decrypt_arena, DECRYPT_ARENA_SIZE);
+    }
+    heap_arena_enter(&decrypt_arena);
+
     /* Main flexbox */
     decrypt_container = lv_obj_create(lv_scr_act());
     lv_obj_set_flex_flow(decrypt_container, LV_FLEX_FLOW_COLUMN);
@@ -1077,7 +1022,7 @@ static void decrypt(void) {
 
     /* Keyboard (after textarea / label so that key popovers are not drawn over) */
     keyboard = lv_keyboard_create(lv_scr_act());
-    lv_keyboard_set_mode(keyboard, LV_KEYBOARD_MODE_TEXT_LOWER);
+    keyboard_set_layout(keyboard, conf_opts.keyboard.layout_id);
     lv_keyboard_set_textarea(keyboard, textarea);
     lv_obj_remove_event_cb(keyboard, lv_keyboard_def_event_cb);
     lv_obj_add_event_cb(keyboard, keyboard_value_changed_cb, LV_EVENT_VALUE_CHANGED, NULL);
@@ -1087,32 +1032,25 @@ static void decrypt(void) {
 
     /* Apply textarea options */
     set_password_obscured(conf_opts.textarea.obscured);
+
+    heap_arena_leave();
 }
 
 static void reboot_device(void) {
+    log_flush();
     sync();
     reboot(RB_AUTOBOOT);
 }
 
 static void shutdown(void) {
+    log_flush();
     sync();
     reboot(RB_POWER_OFF);
 }
 
-static void* run_recovery(void* arg) {
-    LV_UNUSED(arg);
-
-    char *recovery_args[] = {"/usr/bin/furios-recovery", NULL};
-    execv(recovery_args[0], recovery_args);
-    perror("execv");
-    return NULL;
-}
-
-static void open_terminal(void) {
-    lv_obj_clean(lv_scr_act());
-    lv_deinit();
-    if (buf)
-        free(buf);
+static void suspend_display(void) {
+    /* A flush may still be running on the flush thread */
+    render_wait();
 
     switch (conf_opts.general.backend) {
 #if USE_FBDEV
@@ -1129,34 +1067,82 @@ static void open_terminal(void) {
     case BACKENDS_BACKEND_MINUI:
         minui_exit();
         break;
+#endif /* USE_MINUI */
+    }
+}
+
+static void resume_display(void) {
+    switch (conf_opts.general.backend) {
+#if USE_FBDEV
+    case BACKENDS_BACKEND_FBDEV:
+        fbdev_init();
+        break;
+#endif /* USE_FBDEV */
+#if USE_DRM
+    case BACKENDS_BACKEND_DRM:
+        drm_init();
+        break;
+#endif /* USE_DRM */
+#if USE_MINUI
+    case BACKENDS_BACKEND_MINUI:
+        minui_init();
+        break;
 #endif /* USE_MINUI */
     }
 
+    /* The other program drew over everything */
+    lv_obj_invalidate(lv_scr_act());
+    lv_obj_invalidate(lv_layer_top());
+    lv_refr_now(NULL);
+}
+
+static void open_terminal(void *user_data) {
+    LV_UNUSED(user_data);
+
+    indev_suspend();
+    suspend_display();
     terminal_reset_current_terminal();
+    /* Don't write over the terminal */
+    log_flush();
 
     pid_t pid = fork();
     if (pid == 0) {
         char *args[] = {"/usr/bin/furios-terminal", NULL};
         execv(args[0], args);
+        log_error("execv: %s", strerror(errno));
+        _exit(EXIT_FAILURE);
+    }
+
+    if (pid < 0) {
+        log_error("fork: %s", strerror(errno));
     } else {
-        waitpid(pid, NULL, 0);
-        printf("Terminal exited, reinitializing recovery\n");
-
-        pthread_t recovery_thread;
-        int thread_result = pthread_create(&recovery_thread, NULL, run_recovery, NULL);
-        if (thread_result != 0) {
-            perror("pthread_create");
-            exit(1);
+        while (waitpid(pid, NULL, 0) < 0 && errno == EINTR) {
         }
+        log_info("Terminal exited, resuming recovery");
+    }
 
-        thread_result = pthread_detach(recovery_thread);
-        if (thread_result != 0) {
-            perror("pthread_detach");
-            exit(1);
-        }
+    terminal_prepare_current_terminal();
+    resume_display();
+    indev_resume();
 
-        sleep(1); // wait for the other instance to start
-        exit(0);
+    /* Time spent in the terminal doesn't count as idle */
+    idle_notify_input();
+}
+
+static void idle_timeout_cb(void) {
+    /* Never interrupt a factory reset or an unlock */
+    if (reset_worker == NULL && unlock_worker == NULL) {
+        deferred_action_schedule("No input, shutting down", 10, true, shutdown);
+    }
+}
+
+static void lvgl_log_cb(const char *buf) {
+    if (strncmp(buf, "[Error]", 7) == 0) {
+        log_error("%s", buf);
+    } else if (strncmp(buf, "[Warn]", 6) == 0) {
+        log_warning("%s", buf);
+    } else {
+        log_verbose("%s", buf);
     }
 }
 
@@ -1203,9 +1189,7 @@ static void enable_ssh() {
 static void toggle_ssh_btn_clicked_cb(lv_event_t *event) {
     LV_UNUSED(event);
 
-    const char *lvm_device_path = "/dev/droidian/droidian-reserved";
-    size_t print_bytes = 64;
-    int result = is_lv_encrypted_with_luks(lvm_device_path, print_bytes);
+    int result = device_state_get_lvm_encrypted();
     if (result == 1) {
         enabling_ssh = true;
         decrypt();
@@ -1214,58 +1198,15 @@ static void toggle_ssh_btn_clicked_cb(lv_event_t *event) {
     }
 }
 
-static int read_int_from_file(const char *path, int default_value) {
-    FILE *file = fopen(path, "r");
-    if (file == NULL) {
-        printf("File not found: %s\n", path);
-        return default_value;
-    }
-
-    char buffer[20];
-    if (fgets(buffer, sizeof(buffer), file) != NULL) {
-        fclose(file);
-        buffer[strcspn(buffer, "\n")] = 0;
-
-        char *endptr;
-        long value = strtol(buffer, &endptr, 10);
-        if (*endptr == '\0' && value >= 0) {
-            return (int)value;
-        }
-    }
-
-    fclose(file);
-    return default_value;
-}
-
-static int write_int_to_file(const char *path, int value) {
-    FILE *file = fopen(path, "w");
-    if (file == NULL) {
-        printf("Failed to open file for writing: %s (Error: %s)\n", path, strerror(errno));
-        return -1;
-    }
-
-    int result = fprintf(file, "%d", value);
-    fclose(file);
-
-    if (result < 0) {
-        printf("Failed to write to file: %s (Error: %s)\n", path, strerror(errno));
-        return -1;
-    }
-
-    return 0;
-}
-
 static void create_buttons(lv_obj_t *label_container) {
     /* Brightness slider */
     brightness_slider = lv_slider_create(label_container);
     lv_obj_set_width(brightness_slider, LV_PCT(100));
     lv_obj_set_height(brightness_slider, 20);
 
-    int max_brightness = read_int_from_file(MAX_BRIGHTNESS_PATH, 255);
-    lv_slider_set_range(brightness_slider, 0, max_brightness);
-
-    int current_brightness = read_int_from_file(BRIGHTNESS_PATH, max_brightness);
-    lv_slider_set_value(brightness_slider, current_brightness, LV_ANIM_OFF);
+    backlight_init();
+    lv_slider_set_range(brightness_slider, 0, backlight_get_max());
+    lv_slider_set_value(brightness_slider, backlight_get(), LV_ANIM_OFF);
 
     lv_obj_add_event_cb(brightness_slider, brightness_slider_changed_cb, LV_EVENT_VALUE_CHANGED, NULL);
     lv_obj_align(brightness_slider, LV_ALIGN_TOP_MID, 0, 520);
@@ -1457,9 +1398,10 @@ static void initialize_recovery_ui(void) {
         break;
 #endif /* USE_MINUI */
     default:
-        printf("Unable to find suitable backend\n");
+        log_error("Unable to find suitable backend");
         exit(EXIT_FAILURE);
     }
+    startup_mark("backend_init");
 
     /* Override display parameters with command line options if necessary */
     if (cli_options.hor_res > 0)
@@ -1469,34 +1411,59 @@ static void initialize_recovery_ui(void) {
     if (cli_options.dpi > 0)
         dpi = cli_options.dpi;
 
-    /* Prepare display buffer */
-    const size_t buf_size = hor_res * ver_res / 10; /* At least 1/10 of the display size is recommended */
-    if (buf == NULL)
-        buf = (lv_color_t *)malloc(buf_size * sizeof(lv_color_t));
+    /* Set up the font before the theme is applied */
+    fonts_init(conf_opts.general.glyph_cache);
 
-    lv_disp_draw_buf_init(&disp_buf, buf, NULL, buf_size);
+    /* Time render and flush, before the flush may be moved onto a thread */
+    profile_attach_display_driver(&disp_drv);
+    startup_watch_first_frame(&disp_drv, first_frame_cb);
+
+    /* Prepare display buffers */
+    if (!render_init(&disp_drv, conf_opts.general.render_mode, hor_res, ver_res)) {
+        exit(EXIT_FAILURE);
+    }
 
     /* Register display driver */
-    disp_drv.draw_buf = &disp_buf;
     disp_drv.hor_res = hor_res;
     disp_drv.ver_res = ver_res;
     disp_drv.offset_x = cli_options.x_offset;
     disp_drv.offset_y = cli_options.y_offset;
     disp_drv.dpi = dpi;
-    lv_disp_drv_register(&disp_drv);
+    lv_disp_t *disp = lv_disp_drv_register(&disp_drv);
+    profile_attach_display(disp);
 
-    printf("Display resolution: %dx%d, DPI: %d, Offset: (%d, %d)\n",
+    log_info("Display resolution: %dx%d, DPI: %d, Offset: (%d, %d)",
            hor_res, ver_res, dpi, cli_options.x_offset, cli_options.y_offset);
 
     /* Connect input devices */
     indev_auto_connect(conf_opts.input.keyboard, conf_opts.input.pointer, conf_opts.input.touchscreen);
+    indev_set_low_latency(conf_opts.input.low_latency);
     indev_set_up_mouse_cursor();
+    startup_mark("indev_auto_connect");
 
     /* Initialise theme */
+    theme_prepare(&(themes_themes[conf_opts.theme.default_id]), &(themes_themes[conf_opts.theme.alternate_id]));
     set_theme(is_alternate_theme);
+    startup_mark("set_theme");
 
     /* Create UI elements */
     create_ui(hor_res, ver_res);
+    startup_mark("create_ui");
+
+    if (cli_options.profile_overlay) {
+        profile_show_overlay();
+    }
+}
+
+static void first_frame_cb(void) {
+    if (cli_options.verbose || cli_options.exit_after_first_frame) {
+        startup_print(stderr);
+    }
+
+    if (cli_options.exit_after_first_frame) {
+        terminal_reset_current_terminal();
+        exit(EXIT_SUCCESS);
+    }
 }
 
 /**
@@ -1506,12 +1473,33 @@ static void initialize_recovery_ui(void) {
 int main(int argc, char *argv[]) {
     /* Parse command line options */
     cli_parse_opts(argc, argv, &cli_options);
+    startup_mark("cli_parse_opts");
 
-    /* Parse config files */
-    config_parse(cli_options.config_files, cli_options.num_config_files, &conf_opts);
+    if (cli_options.compile_config) {
+        return config_compile(cli_options.config_snapshot, cli_options.config_files, cli_options.num_config_files)
+            ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    /* Keep slow consoles off the UI thread */
+    log_init(cli_options.verbose ? LOG_LEVEL_DEBUG : LOG_LEVEL_INFO,
+        cli_options.log_kmsg ? LOG_SINK_KMSG : LOG_SINK_STDERR, cli_options.log_file);
+    lv_log_register_print_cb(lvgl_log_cb);
+    startup_mark("log_init");
+
+    /* Probe the device while the UI is set up */
+    device_state_start();
+
+    if (cli_options.profile) {
+        profile_init(cli_options.profile_file);
+    }
+
+    /* Load the config snapshot or parse config files */
+    config_load(cli_options.config_snapshot, cli_options.config_files, cli_options.num_config_files, &conf_opts);
+    startup_mark("config_load");
 
     /* Prepare current TTY and clean up on termination */
     terminal_prepare_current_terminal();
+    startup_mark("terminal_prepare_current_terminal");
     struct sigaction action;
     memset(&action, 0, sizeof(action));
     action.sa_handler = sigaction_handler;
@@ -1520,7 +1508,17 @@ int main(int argc, char *argv[]) {
 
     initialize_recovery_ui();
 
-    /* Run lvgl in "tickless" mode */
+    /* Dim, blank and finally shut down when left alone */
+    idle_init(conf_opts.general.dim_timeout, conf_opts.general.blank_timeout, conf_opts.general.timeout, idle_timeout_cb);
+
+    /* Run lvgl in "tickless" mode, sleeping until input arrives or a timer is due */
+    if (event_loop_init()) {
+        indev_watch_fds();
+        device_state_watch();
+        event_loop_run(cli_options.verbose);
+    }
+
+    /* Fall back to polling if epoll is unavailable */
     while(1) {
         lv_task_handler();
         usleep(5000);
@@ -1529,29 +1527,3 @@ int main(int argc, char *argv[]) {
     return 0;
 }
 
-
-/**
- * Tick generation
- */
-
-/**
- * Generate tick for LVGL.
- *
- * @return tick in ms
- */
-uint32_t get_tick(void) {
-    static uint64_t start_ms = 0;
-    if (start_ms == 0) {
-        struct timeval tv_start;
-        gettimeofday(&tv_start, NULL);
-        start_ms = (tv_start.tv_sec * 1000000 + tv_start.tv_usec) / 1000;
-    }
-
-    struct timeval tv_now;
-    gettimeofday(&tv_now, NULL);
-    uint64_t now_ms;
-    now_ms = (tv_now.tv_sec * 1000000 + tv_now.tv_usec) / 1000;
-
-    uint32_t time_ms = now_ms - start_ms;
-    return time_ms;
-}
@@ -0,0 +1,46 @@
+#!/bin/sh -e
+# Copyright 2026 FuriLabs
+# SPDX-License-Identifier: GPL-3.0-or-later
+#
+# Pack a userdata image into a tar.gz made of independently compressed gzip
+# members, together with the .idx sidecar that lets furios-recovery
+# decompress it on all cores during a factory reset. The archive remains a
+# regular gzip file, so older recovery builds and tar -xzf still accept it.
+#
+# Usage: ./make-userdata-archive.sh IMAGE ARCHIVE [MEMBER_SIZE_MIB]
+
+if [ $# -lt 2 ]; then
+    echo "Usage: $0 IMAGE ARCHIVE [MEMBER_SIZE_MIB]" >&2
+    exit 1
+fi
+
+image="$1"
+archive="$2"
+member_size_mib="${3:-4}"
+
+if [ "$member_size_mib" -gt 16 ]; then
+    echo "Members larger than 16 MiB are not accepted by furios-recovery" >&2
+    exit 1
+fi
+
+tmp="$(mktemp -d)"
+trap 'rm -rf "$tmp"' EXIT
+
+tar -cf - -C "$(dirname "$image")" "$(basename "$image")" \
+    | split -b "${member_size_mib}M" -d -a 8 - "$tmp/member."
+
+ls "$tmp"/member.* | xargs -P "$(nproc)" -n 1 gzip -n -9
+
+: > "$archive"
+echo "# compressed_offset compressed_size uncompressed_offset uncompressed_size" > "$archive.idx"
+
+coff=0
+uoff=0
+for member in "$tmp"/member.*.gz; do
+    clen="$(stat -c %s "$member")"
+    ulen="$(gzip -l "$member" | awk 'NR == 2 { print $2 }')"
+    echo "$coff $clen $uoff $ulen" >> "$archive.idx"
+    cat "$member" >> "$archive"
+    coff=$((coff + clen))
+    uoff=$((uoff + ulen))
+done
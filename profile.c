@@ -0,0 +1,371 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "profile.h"
+
+#include "event_loop.h"
+#include "heap.h"
+#include "log.h"
+#include "tick.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Defines
+ */
+
+/* Number of samples kept per metric */
+#define PROFILE_RING_SIZE 4096
+/* Update interval of the overlay in ms */
+#define PROFILE_OVERLAY_PERIOD 500
+
+
+/**
+ * Static types
+ */
+
+/* Ring buffer of the most recent samples of a metric */
+typedef struct {
+    /* Durations in microseconds */
+    uint32_t samples[PROFILE_RING_SIZE];
+    /* Index the next sample is written to */
+    size_t next;
+    /* Number of valid samples */
+    size_t count;
+    /* Total number of samples ever recorded */
+    uint64_t total;
+} ring;
+
+/* Percentiles of a metric */
+typedef struct {
+    uint32_t p50;
+    uint32_t p95;
+    uint32_t p99;
+    uint32_t max;
+    size_t count;
+} summary;
+
+
+/**
+ * Static variables
+ */
+
+static const char *metric_names[PROFILE_NUM_METRICS] = {
+    "render",
+    "flush",
+    "input",
+    "latency",
+};
+
+static const char *counter_names[PROFILE_NUM_COUNTERS] = {
+    "glyph_cache_hit",
+    "glyph_cache_miss",
+};
+
+static bool enabled = false;
+static const char *dump_file = NULL;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static ring rings[PROFILE_NUM_METRICS];
+static uint64_t counters[PROFILE_NUM_COUNTERS];
+
+static pthread_t lvgl_thread;
+static void (*backend_flush_cb)(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p) = NULL;
+static void (*refr_timer_cb)(lv_timer_t *timer) = NULL;
+static uint64_t frame_flush_us = 0;
+static bool frame_rendered = false;
+/* Time of the oldest press that wasn't drawn yet, 0 if there is none */
+static uint64_t pending_input_us = 0;
+
+static lv_obj_t *overlay_label = NULL;
+
+
+/**
+ * Static prototypes
+ */
+
+/**
+ * Record a sample.
+ *
+ * @param metric metric to record into
+ * @param duration_us duration in microseconds
+ */
+static void record(profile_metric_t metric, uint64_t duration_us);
+
+/**
+ * Compute the percentiles of a metric.
+ *
+ * @param metric the metric
+ * @param result pointer for writing the percentiles into
+ */
+static void summarise(profile_metric_t metric, summary *result);
+
+/**
+ * Compare two samples for qsort.
+ *
+ * @param a first sample
+ * @param b second sample
+ * @return negative, zero or positive
+ */
+static int compare_samples(const void *a, const void *b);
+
+/**
+ * Time the backend's flush callback.
+ *
+ * @param disp_drv display driver
+ * @param area area to flush
+ * @param color_p rendered pixels of the area
+ */
+static void timed_flush_cb(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p);
+
+/**
+ * Note that a frame was rendered.
+ *
+ * @param disp_drv display driver
+ * @param time_ms render time measured by LVGL
+ * @param px number of rendered pixels
+ */
+static void monitor_cb(lv_disp_drv_t *disp_drv, uint32_t time_ms, uint32_t px);
+
+/**
+ * Time a refresh cycle of the display.
+ *
+ * @param timer the display's refresh timer
+ */
+static void timed_refr_timer_cb(lv_timer_t *timer);
+
+/**
+ * Refresh the overlay label.
+ *
+ * @param timer the timer
+ */
+static void overlay_timer_cb(lv_timer_t *timer);
+
+
+/**
+ * Static functions
+ */
+
+static void record(profile_metric_t metric, uint64_t duration_us) {
+    pthread_mutex_lock(&lock);
+    ring *r = &rings[metric];
+    r->samples[r->next] = duration_us > UINT32_MAX ? UINT32_MAX : (uint32_t)duration_us;
+    r->next = (r->next + 1) % PROFILE_RING_SIZE;
+    if (r->count < PROFILE_RING_SIZE) {
+        ++r->count;
+    }
+    ++r->total;
+    pthread_mutex_unlock(&lock);
+}
+
+static int compare_samples(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void summarise(profile_metric_t metric, summary *result) {
+    static uint32_t sorted[PROFILE_RING_SIZE];
+
+    pthread_mutex_lock(&lock);
+    size_t count = rings[metric].count;
+    memcpy(sorted, rings[metric].samples, count * sizeof(uint32_t));
+    pthread_mutex_unlock(&lock);
+
+    memset(result, 0, sizeof(summary));
+    result->count = count;
+    if (count == 0) {
+        return;
+    }
+
+    qsort(sorted, count, sizeof(uint32_t), compare_samples);
+    result->p50 = sorted[(count - 1) * 50 / 100];
+    result->p95 = sorted[(count - 1) * 95 / 100];
+    result->p99 = sorted[(count - 1) * 99 / 100];
+    result->max = sorted[count - 1];
+}
+
+static void timed_flush_cb(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p) {
+    uint64_t start = tick_now_us();
+    backend_flush_cb(disp_drv, area, color_p);
+    uint64_t duration = tick_now_us() - start;
+
+    record(PROFILE_METRIC_FLUSH, duration);
+
+    /* Synchronous flushes are part of the refresh cycle but don't count as rendering */
+    if (pthread_equal(pthread_self(), lvgl_thread)) {
+        frame_flush_us += duration;
+    }
+}
+
+static void monitor_cb(lv_disp_drv_t *disp_drv, uint32_t time_ms, uint32_t px) {
+    LV_UNUSED(disp_drv);
+    LV_UNUSED(time_ms);
+    frame_rendered = px > 0;
+}
+
+static void timed_refr_timer_cb(lv_timer_t *timer) {
+    frame_flush_us = 0;
+    frame_rendered = false;
+
+    uint64_t start = tick_now_us();
+    refr_timer_cb(timer);
+    uint64_t duration = tick_now_us() - start;
+
+    if (frame_rendered) {
+        record(PROFILE_METRIC_RENDER, duration > frame_flush_us ? duration - frame_flush_us : 0);
+
+        if (pending_input_us != 0) {
+            const uint64_t end = start + duration;
+            record(PROFILE_METRIC_LATENCY, end > pending_input_us ? end - pending_input_us : 0);
+            pending_input_us = 0;
+        }
+    }
+}
+
+static void overlay_timer_cb(lv_timer_t *timer) {
+    LV_UNUSED(timer);
+
+    char text[320];
+    size_t len = 0;
+
+    for (int i = 0; i < PROFILE_NUM_METRICS; ++i) {
+        summary s;
+        summarise(i, &s);
+        len += snprintf(text + len, sizeof(text) - len, "%s p50 %.1f p95 %.1f p99 %.1f ms\n", metric_names[i],
+            s.p50 / 1000.0, s.p95 / 1000.0, s.p99 / 1000.0);
+    }
+    len += snprintf(text + len, sizeof(text) - len, "%u wakeups/s", event_loop_get_wakeups_per_second());
+
+    const uint64_t lookups = counters[PROFILE_COUNTER_GLYPH_CACHE_HIT] + counters[PROFILE_COUNTER_GLYPH_CACHE_MISS];
+    if (lookups > 0) {
+        snprintf(text + len, sizeof(text) - len, "\nglyph cache %.1f%% hits",
+            counters[PROFILE_COUNTER_GLYPH_CACHE_HIT] * 100.0 / lookups);
+    }
+
+    lv_label_set_text(overlay_label, text);
+}
+
+
+/**
+ * Public functions
+ */
+
+void profile_init(const char *dump_path) {
+    enabled = true;
+    dump_file = dump_path;
+    lvgl_thread = pthread_self();
+    atexit(profile_dump);
+}
+
+bool profile_is_enabled(void) {
+    return enabled;
+}
+
+uint64_t profile_begin(void) {
+    return enabled ? tick_now_us() : 0;
+}
+
+void profile_end(profile_metric_t metric, uint64_t start) {
+    if (enabled) {
+        record(metric, tick_now_us() - start);
+    }
+}
+
+void profile_mark_input(uint64_t time_us) {
+    if (enabled && pending_input_us == 0) {
+        pending_input_us = time_us;
+    }
+}
+
+void profile_count(profile_counter_t counter) {
+    if (enabled) {
+        ++counters[counter];
+    }
+}
+
+void profile_attach_display_driver(lv_disp_drv_t *disp_drv) {
+    if (!enabled) {
+        return;
+    }
+
+    backend_flush_cb = disp_drv->flush_cb;
+    disp_drv->flush_cb = timed_flush_cb;
+    disp_drv->monitor_cb = monitor_cb;
+}
+
+void profile_attach_display(lv_disp_t *disp) {
+    if (!enabled || disp->refr_timer == NULL) {
+        return;
+    }
+
+    refr_timer_cb = disp->refr_timer->timer_cb;
+    disp->refr_timer->timer_cb = timed_refr_timer_cb;
+}
+
+void profile_show_overlay(void) {
+    if (!enabled || overlay_label != NULL) {
+        return;
+    }
+
+    overlay_label = lv_label_create(lv_layer_sys());
+    lv_obj_set_style_bg_color(overlay_label, lv_color_black(), LV_PART_MAIN);
+    lv_obj_set_style_bg_opa(overlay_label, LV_OPA_70, LV_PART_MAIN);
+    lv_obj_set_style_text_color(overlay_label, lv_color_white(), LV_PART_MAIN);
+    lv_obj_align(overlay_label, LV_ALIGN_TOP_RIGHT, 0, 0);
+    lv_label_set_text(overlay_label, "");
+
+    lv_timer_create(overlay_timer_cb, PROFILE_OVERLAY_PERIOD, NULL);
+}
+
+void profile_dump(void) {
+    if (!enabled) {
+        return;
+    }
+
+    FILE *out = stderr;
+    if (dump_file != NULL) {
+        out = fopen(dump_file, "w");
+        if (out == NULL) {
+            log_error("Failed to open profile dump file %s: %s", dump_file, strerror(errno));
+            out = stderr;
+        }
+    }
+
+    for (int i = 0; i < PROFILE_NUM_METRICS; ++i) {
+        summary s;
+        summarise(i, &s);
+        fprintf(out, "profile metric=%s samples=%zu total=%llu p50_us=%u p95_us=%u p99_us=%u max_us=%u\n",
+            metric_names[i], s.count, (unsigned long long)rings[i].total, s.p50, s.p95, s.p99, s.max);
+    }
+
+    for (int i = 0; i < PROFILE_NUM_COUNTERS; ++i) {
+        fprintf(out, "profile counter=%s count=%llu\n", counter_names[i], (unsigned long long)counters[i]);
+    }
+
+    heap_print_stats(out);
+
+    if (out != stderr) {
+        fclose(out);
+    }
+}
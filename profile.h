@@ -0,0 +1,122 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "lvgl/lvgl.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* NOTE: PROFILE_NUM_METRICS must stay last */
+typedef enum {
+    /* Time spent rendering a frame, excluding flushes */
+    PROFILE_METRIC_RENDER,
+    /* Time spent in the backend's flush callback */
+    PROFILE_METRIC_FLUSH,
+    /* Time spent reading an input device */
+    PROFILE_METRIC_INPUT,
+    /* Time from a press to the end of the first frame rendered after it */
+    PROFILE_METRIC_LATENCY,
+    PROFILE_NUM_METRICS
+} profile_metric_t;
+
+/* NOTE: PROFILE_NUM_COUNTERS must stay last */
+typedef enum {
+    /* Glyph lookups served from the glyph cache */
+    PROFILE_COUNTER_GLYPH_CACHE_HIT,
+    /* Glyph lookups that went to the font */
+    PROFILE_COUNTER_GLYPH_CACHE_MISS,
+    PROFILE_NUM_COUNTERS
+} profile_counter_t;
+
+/**
+ * Enable profiling. Timings are collected into ring buffers and summarised on exit.
+ *
+ * @param dump_path file to write the summary to on exit, NULL for STDERR
+ */
+void profile_init(const char *dump_path);
+
+/**
+ * Check whether profiling is enabled.
+ *
+ * @return true if profile_init was called, false otherwise
+ */
+bool profile_is_enabled(void);
+
+/**
+ * Get a timestamp for starting a measurement.
+ *
+ * @return timestamp in microseconds, 0 if profiling is disabled
+ */
+uint64_t profile_begin(void);
+
+/**
+ * Finish a measurement and record its duration. Safe to call from any thread.
+ *
+ * @param metric metric to record into
+ * @param start timestamp returned by profile_begin
+ */
+void profile_end(profile_metric_t metric, uint64_t start);
+
+/**
+ * Note the time of a press that was just handed to LVGL. The next rendered frame records the
+ * latency from it, later presses before that frame are ignored. Must be called from the LVGL
+ * thread.
+ *
+ * @param time_us time of the input event in microseconds on the monotonic clock
+ */
+void profile_mark_input(uint64_t time_us);
+
+/**
+ * Increment a counter. Must be called from the LVGL thread.
+ *
+ * @param counter counter to increment
+ */
+void profile_count(profile_counter_t counter);
+
+/**
+ * Time the render and flush phases of a display driver. Call this with flush_cb set, before
+ * render_init and lv_disp_drv_register.
+ *
+ * @param disp_drv display driver
+ */
+void profile_attach_display_driver(lv_disp_drv_t *disp_drv);
+
+/**
+ * Time the refresh cycles of a registered display.
+ *
+ * @param disp display
+ */
+void profile_attach_display(lv_disp_t *disp);
+
+/**
+ * Show live percentiles in a label on the system layer.
+ */
+void profile_show_overlay(void);
+
+/**
+ * Write the p50/p95/p99 summary of all metrics, the counters and the heap statistics. Runs
+ * automatically on exit.
+ */
+void profile_dump(void);
+
+#endif /* PROFILE_H */
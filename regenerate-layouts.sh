@@ -28,3 +28,6 @@ pipenv run python squeek2lvgl.py \
     --output .. \
     --surround-space-with-arrows \
     --shift-keycap '\xef\x8d\x9b'
+
+cd ..
+./compact-layouts.py sq2lv_layouts.c .
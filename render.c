@@ -0,0 +1,259 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "render.h"
+
+#include "log.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/**
+ * Static types
+ */
+
+/* Flush thread state */
+typedef struct {
+    /* Flush thread */
+    pthread_t thread;
+    /* True while the flush thread is running */
+    bool running;
+    /* Protects the fields below */
+    pthread_mutex_t lock;
+    /* Signalled when a flush is queued, finished or the thread is asked to stop */
+    pthread_cond_t cond;
+    /* The backend's flush callback */
+    void (*backend_flush_cb)(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p);
+    /* Arguments of the queued flush */
+    lv_disp_drv_t *disp_drv;
+    lv_area_t area;
+    lv_color_t *color_p;
+    /* True while a flush is queued or in progress */
+    bool pending;
+    /* True if the thread should exit */
+    bool stop;
+} flusher_state;
+
+
+/**
+ * Static variables
+ */
+
+static lv_disp_draw_buf_t draw_buf;
+static lv_color_t *bufs[2] = { NULL, NULL };
+static flusher_state flusher;
+
+
+/**
+ * Static prototypes
+ */
+
+/**
+ * Flush thread main function. Runs queued flushes through the backend.
+ *
+ * @param arg unused
+ * @return NULL
+ */
+static void *flush_thread(void *arg);
+
+/**
+ * Queue a flush for the flush thread. Replaces the backend's flush_cb in the double buffered modes.
+ *
+ * @param disp_drv display driver
+ * @param area area to flush
+ * @param color_p rendered pixels of the area
+ */
+static void async_flush_cb(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p);
+
+/**
+ * Block until the queued flush finished instead of letting LVGL spin on the flushing flag.
+ *
+ * @param disp_drv display driver
+ */
+static void async_wait_cb(lv_disp_drv_t *disp_drv);
+
+/**
+ * Start the flush thread for a display driver and hook it up.
+ *
+ * @param disp_drv display driver
+ * @return true on success, false otherwise
+ */
+static bool start_flusher(lv_disp_drv_t *disp_drv);
+
+
+/**
+ * Static functions
+ */
+
+static void *flush_thread(void *arg) {
+    LV_UNUSED(arg);
+
+    pthread_mutex_lock(&flusher.lock);
+    while (true) {
+        while (!flusher.pending && !flusher.stop) {
+            pthread_cond_wait(&flusher.cond, &flusher.lock);
+        }
+        if (flusher.stop) {
+            break;
+        }
+
+        lv_disp_drv_t *disp_drv = flusher.disp_drv;
+        lv_area_t area = flusher.area;
+        lv_color_t *color_p = flusher.color_p;
+        pthread_mutex_unlock(&flusher.lock);
+
+        /* The backend calls lv_disp_flush_ready(), which only clears LVGL's volatile flushing flag */
+        flusher.backend_flush_cb(disp_drv, &area, color_p);
+
+        pthread_mutex_lock(&flusher.lock);
+        flusher.pending = false;
+        pthread_cond_broadcast(&flusher.cond);
+    }
+    pthread_mutex_unlock(&flusher.lock);
+
+    return NULL;
+}
+
+static void async_flush_cb(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p) {
+    pthread_mutex_lock(&flusher.lock);
+    /* LVGL only starts a flush after the previous one finished, so nothing is pending here */
+    flusher.disp_drv = disp_drv;
+    flusher.area = *area;
+    flusher.color_p = color_p;
+    flusher.pending = true;
+    pthread_cond_broadcast(&flusher.cond);
+    pthread_mutex_unlock(&flusher.lock);
+}
+
+static void async_wait_cb(lv_disp_drv_t *disp_drv) {
+    LV_UNUSED(disp_drv);
+
+    pthread_mutex_lock(&flusher.lock);
+    while (flusher.pending) {
+        pthread_cond_wait(&flusher.cond, &flusher.lock);
+    }
+    pthread_mutex_unlock(&flusher.lock);
+}
+
+static bool start_flusher(lv_disp_drv_t *disp_drv) {
+    memset(&flusher, 0, sizeof(flusher));
+    pthread_mutex_init(&flusher.lock, NULL);
+    pthread_cond_init(&flusher.cond, NULL);
+    flusher.backend_flush_cb = disp_drv->flush_cb;
+
+    if (pthread_create(&flusher.thread, NULL, flush_thread, NULL) != 0) {
+        log_error("pthread_create: %s", strerror(errno));
+        pthread_cond_destroy(&flusher.cond);
+        pthread_mutex_destroy(&flusher.lock);
+        return false;
+    }
+
+    flusher.running = true;
+    disp_drv->flush_cb = async_flush_cb;
+    disp_drv->wait_cb = async_wait_cb;
+    return true;
+}
+
+
+/**
+ * Public functions
+ */
+
+const char *render_modes[] = {
+    "single",
+    "double",
+    "full",
+    NULL
+};
+
+render_mode_id_t render_find_mode_with_name(const char *name) {
+    for (int i = 0; render_modes[i] != NULL; ++i) {
+        if (strcmp(render_modes[i], name) == 0) {
+            return i;
+        }
+    }
+    log_warning("Render mode %s not found", name);
+    return RENDER_MODE_NONE;
+}
+
+bool render_init(lv_disp_drv_t *disp_drv, render_mode_id_t mode, uint32_t hor_res, uint32_t ver_res) {
+    render_deinit();
+
+    /* At least 1/10 of the display size is recommended for partial buffers */
+    const size_t partial_size = hor_res * ver_res / 10;
+    const size_t buf_size = mode == RENDER_MODE_FULL ? hor_res * ver_res : partial_size;
+
+    if (mode != RENDER_MODE_SINGLE) {
+        bufs[0] = malloc(buf_size * sizeof(lv_color_t));
+        bufs[1] = malloc(buf_size * sizeof(lv_color_t));
+
+        if (bufs[0] != NULL && bufs[1] != NULL && start_flusher(disp_drv)) {
+            lv_disp_draw_buf_init(&draw_buf, bufs[0], bufs[1], buf_size);
+            disp_drv->draw_buf = &draw_buf;
+            log_info("Rendering with two buffers of %zu pixels", buf_size);
+            return true;
+        }
+
+        log_warning("Could not set up %s rendering, falling back to single", render_modes[mode]);
+        free(bufs[0]);
+        free(bufs[1]);
+        bufs[0] = bufs[1] = NULL;
+    }
+
+    bufs[0] = malloc(partial_size * sizeof(lv_color_t));
+    if (bufs[0] == NULL) {
+        log_error("Could not allocate draw buffer");
+        return false;
+    }
+
+    lv_disp_draw_buf_init(&draw_buf, bufs[0], NULL, partial_size);
+    disp_drv->draw_buf = &draw_buf;
+    return true;
+}
+
+void render_wait(void) {
+    if (flusher.running) {
+        async_wait_cb(NULL);
+    }
+}
+
+void render_deinit(void) {
+    if (flusher.running) {
+        pthread_mutex_lock(&flusher.lock);
+        while (flusher.pending) {
+            pthread_cond_wait(&flusher.cond, &flusher.lock);
+        }
+        flusher.stop = true;
+        pthread_cond_broadcast(&flusher.cond);
+        pthread_mutex_unlock(&flusher.lock);
+
+        pthread_join(flusher.thread, NULL);
+        pthread_cond_destroy(&flusher.cond);
+        pthread_mutex_destroy(&flusher.lock);
+        flusher.running = false;
+    }
+
+    free(bufs[0]);
+    free(bufs[1]);
+    bufs[0] = bufs[1] = NULL;
+}
@@ -0,0 +1,74 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef RENDER_H
+#define RENDER_H
+
+#include "lvgl/lvgl.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* NOTE: Only RENDER_MODE_NONE is ought to have an explicit value assigned */
+typedef enum {
+    RENDER_MODE_NONE = -1,
+    /* One partial buffer of 1/10 of the screen, rendering and flushing alternate */
+    RENDER_MODE_SINGLE,
+    /* Two partial buffers, the next strip is rendered while the previous one is flushed */
+    RENDER_MODE_DOUBLE,
+    /* Two screen-sized buffers, every dirty area is rendered and flushed in one piece */
+    RENDER_MODE_FULL,
+} render_mode_id_t;
+
+/* Render mode names, indexed by render_mode_id_t */
+extern const char *render_modes[];
+
+/**
+ * Find the render mode with a given name.
+ *
+ * @param name render mode name
+ * @return ID of the matching mode or RENDER_MODE_NONE if no mode matched
+ */
+render_mode_id_t render_find_mode_with_name(const char *name);
+
+/**
+ * Allocate the draw buffers for a render mode and attach them to a display driver. In the double
+ * buffered modes, the driver's flush_cb is moved onto a flush thread, so it must already be set and
+ * must call lv_disp_flush_ready() when done. Falls back to RENDER_MODE_SINGLE if memory is short.
+ *
+ * @param disp_drv display driver with flush_cb set, not yet registered
+ * @param mode render mode
+ * @param hor_res horizontal resolution
+ * @param ver_res vertical resolution
+ * @return true on success, false if not even a single buffer could be allocated
+ */
+bool render_init(lv_disp_drv_t *disp_drv, render_mode_id_t mode, uint32_t hor_res, uint32_t ver_res);
+
+/**
+ * Wait until no flush is in progress, e.g. before the backend is shut down.
+ */
+void render_wait(void);
+
+/**
+ * Stop the flush thread and release the draw buffers.
+ */
+void render_deinit(void);
+
+#endif /* RENDER_H */
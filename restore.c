@@ -0,0 +1,1098 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#define _GNU_SOURCE
+
+#include "restore.h"
+
+#include "log.h"
+#include "tick.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <linux/fs.h>
+
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+/**
+ * Defines
+ */
+
+/* Size of a tar block */
+#define TAR_BLOCK_SIZE 512
+/* Upper bound for pax extended headers we are willing to buffer */
+#define TAR_PAX_MAX_SIZE (64 * 1024)
+/* Size of the writes issued to the target device, same as the former dd bs=4M */
+#define RESTORE_CHUNK_SIZE (4 * 1024 * 1024)
+/* Alignment of the chunk buffer, suitable for block devices with 4K sectors */
+#define RESTORE_CHUNK_ALIGN 4096
+/* Size of zlib's internal input buffer */
+#define RESTORE_GZ_BUFFER_SIZE (128 * 1024)
+/* Suffix of the gzip member index that enables parallel decompression */
+#define RESTORE_INDEX_SUFFIX ".idx"
+/* Upper bound for the uncompressed size of a single indexed gzip member */
+#define RESTORE_MAX_MEMBER_SIZE (16 * 1024 * 1024)
+/* Upper bound for the number of decompression threads */
+#define RESTORE_MAX_THREADS 8
+/* Granularity of zero block detection in sparse mode, must divide RESTORE_CHUNK_SIZE */
+#define RESTORE_SPARSE_BLOCK_SIZE (64 * 1024)
+/* Written data is handed to writeback and evicted from the page cache in windows of this size */
+#define RESTORE_WRITEBACK_WINDOW (32 * 1024 * 1024)
+
+
+/**
+ * Static types
+ */
+
+/* Target device of a restore */
+typedef struct {
+    /* File descriptor */
+    int fd;
+    /* If true, the target is known to read back as zeroes and zero blocks are not written */
+    bool skip_zeroes;
+} restore_target;
+
+/* Writeback state of one writer. Every writer keeps at most two windows of the target in the page cache. */
+typedef struct {
+    /* Written range whose writeback wasn't started yet */
+    uint64_t dirty_start;
+    uint64_t dirty_end;
+    /* Range whose writeback was started but not waited for */
+    uint64_t flushing_start;
+    uint64_t flushing_end;
+} writeback_state;
+
+/* An independently decompressible gzip member, as listed in the index */
+typedef struct {
+    /* Offset of the member in the archive */
+    uint64_t compressed_offset;
+    /* Compressed size of the member */
+    uint64_t compressed_size;
+    /* Offset of the member's data in the uncompressed tar stream */
+    uint64_t uncompressed_offset;
+    /* Uncompressed size of the member */
+    uint64_t uncompressed_size;
+} index_entry;
+
+/* State shared between the decompression threads */
+typedef struct {
+    /* Archive file descriptor */
+    int archive_fd;
+    /* Target device */
+    const restore_target *target;
+    /* Restore options, for progress reporting */
+    const restore_opts *opts;
+    /* Index entries */
+    const index_entry *entries;
+    /* Number of index entries */
+    size_t num_entries;
+    /* Largest compressed member size */
+    size_t max_compressed_size;
+    /* Largest uncompressed member size */
+    size_t max_uncompressed_size;
+    /* Offset of the restored file's data in the uncompressed tar stream */
+    uint64_t data_offset;
+    /* Size of the restored file */
+    uint64_t data_size;
+    /* Protects the fields below */
+    pthread_mutex_t lock;
+    /* Index of the next entry to process */
+    size_t next_entry;
+    /* Set by the first thread that fails */
+    bool failed;
+    /* Number of bytes of the restored file covered so far */
+    uint64_t bytes_restored;
+    /* Number of bytes actually written to the target */
+    uint64_t bytes_written;
+} parallel_job;
+
+
+/**
+ * Static prototypes
+ */
+
+/**
+ * Check whether the restore should stop.
+ *
+ * @param opts restore options
+ * @return true if the cancellation check asked to stop
+ */
+static bool is_cancelled(const restore_opts *opts);
+
+/**
+ * Read exactly len bytes from a gzip stream.
+ *
+ * @param gz gzip stream
+ * @param buf buffer to read into
+ * @param len number of bytes to read
+ * @return true on success, false on error or premature end of stream
+ */
+static bool gz_read_full(gzFile gz, void *buf, size_t len);
+
+/**
+ * Skip a number of bytes in a gzip stream.
+ *
+ * @param gz gzip stream
+ * @param len number of bytes to skip
+ * @return true on success, false on error or premature end of stream
+ */
+static bool gz_skip(gzFile gz, uint64_t len);
+
+/**
+ * Write a buffer to a file descriptor at a given offset, retrying on short writes and EINTR.
+ *
+ * @param fd file descriptor
+ * @param buf buffer to write
+ * @param len number of bytes to write
+ * @param offset offset to write at
+ * @return true on success, false otherwise
+ */
+static bool pwrite_full(int fd, const void *buf, size_t len, uint64_t offset);
+
+/**
+ * Read a buffer from a file descriptor at a given offset, retrying on short reads and EINTR.
+ *
+ * @param fd file descriptor
+ * @param buf buffer to read into
+ * @param len number of bytes to read
+ * @param offset offset to read from
+ * @return true on success, false otherwise
+ */
+static bool pread_full(int fd, void *buf, size_t len, uint64_t offset);
+
+/**
+ * Check whether a buffer consists only of zero bytes.
+ *
+ * @param buf buffer
+ * @param len length of the buffer
+ * @return true if the buffer is all zeroes, false otherwise
+ */
+static bool is_zero(const unsigned char *buf, size_t len);
+
+/**
+ * Write data to the target. In sparse mode, runs of zero blocks are skipped.
+ *
+ * @param target restore target
+ * @param buf data to write
+ * @param len length of the data
+ * @param offset offset on the target to write at
+ * @param written pointer for accumulating the number of bytes actually written
+ * @return true on success, false otherwise
+ */
+static bool write_data(const restore_target *target, const unsigned char *buf, size_t len, uint64_t offset, uint64_t *written);
+
+/**
+ * Start writeback of the dirty window, then wait for the previous window and evict it from the page cache.
+ *
+ * @param target restore target
+ * @param wb writeback state of the writer
+ */
+static void writeback_kick(const restore_target *target, writeback_state *wb);
+
+/**
+ * Account a written range for writeback. Once a window is full, or the range isn't contiguous
+ * with the previous one, the window is handed to writeback.
+ *
+ * @param target restore target
+ * @param wb writeback state of the writer
+ * @param offset offset of the range on the target
+ * @param len length of the range
+ */
+static void writeback_add(const restore_target *target, writeback_state *wb, uint64_t offset, uint64_t len);
+
+/**
+ * Write back and evict everything a writer still holds in the page cache.
+ *
+ * @param target restore target
+ * @param wb writeback state of the writer
+ */
+static void writeback_finish(const restore_target *target, writeback_state *wb);
+
+/**
+ * Evict a consumed range of the archive from the page cache.
+ *
+ * @param archive_fd archive file descriptor
+ * @param offset start of the range
+ * @param len length of the range
+ */
+static void drop_archive_range(int archive_fd, uint64_t offset, uint64_t len);
+
+/**
+ * Check whether the kernel can zero a block device without writing zero pages, i.e. whether
+ * BLKZEROOUT maps to a WRITE ZEROES command.
+ *
+ * @param fd block device file descriptor
+ * @return true if zeroing is offloaded, false otherwise
+ */
+static bool is_write_zeroes_offloaded(int fd);
+
+/**
+ * Discard the whole target and, where this is cheap, zero it so that zero blocks can be skipped.
+ *
+ * @param fd target file descriptor
+ * @param device_path target path, for logging
+ * @return true if the target now reads back as zeroes, false otherwise
+ */
+static bool prepare_sparse_target(int fd, const char *device_path);
+
+/**
+ * Parse a numeric tar header field. Both the octal and the base-256 (GNU) encoding are supported.
+ *
+ * @param field start of the field
+ * @param len length of the field
+ * @return parsed value
+ */
+static uint64_t parse_tar_number(const char *field, size_t len);
+
+/**
+ * Extract the "size" record from a pax extended header.
+ *
+ * @param data pax header data
+ * @param len length of the data
+ * @param size pointer for writing the size into if the record exists
+ * @return true if a size record was found, false otherwise
+ */
+static bool parse_pax_size(const char *data, size_t len, uint64_t *size);
+
+/**
+ * Check whether a tar block consists only of zero bytes.
+ *
+ * @param block the block
+ * @return true if the block is all zeroes, false otherwise
+ */
+static bool is_zero_block(const unsigned char *block);
+
+/**
+ * Stream a tar member's data onto the target.
+ *
+ * @param gz gzip stream positioned at the start of the member's data
+ * @param archive_fd file descriptor of the gzip stream, for page cache control
+ * @param target restore target
+ * @param size size of the member's data
+ * @param opts restore options, for progress reporting
+ * @param bytes_written pointer for accumulating the number of bytes actually written
+ * @return true on success, false otherwise
+ */
+static bool stream_member(gzFile gz, int archive_fd, const restore_target *target, uint64_t size, const restore_opts *opts, uint64_t *bytes_written);
+
+/**
+ * Advance a gzip stream to the data of the first regular file in the tar archive.
+ *
+ * @param gz gzip stream positioned at the start of the archive
+ * @param archive_path archive path, for logging
+ * @param size pointer for writing the size of the file into
+ * @return true if a regular file was found, false otherwise
+ */
+static bool find_member(gzFile gz, const char *archive_path, uint64_t *size);
+
+/**
+ * Load and validate the gzip member index of an archive.
+ *
+ * @param index_path path of the index file
+ * @param archive_size size of the archive
+ * @param entries pointer for writing the allocated entries into
+ * @param num_entries pointer for writing the number of entries into
+ * @return true if a valid index was loaded, false otherwise
+ */
+static bool load_index(const char *index_path, uint64_t archive_size, index_entry **entries, size_t *num_entries);
+
+/**
+ * Decompress a complete gzip member.
+ *
+ * @param in compressed data
+ * @param in_len size of the compressed data
+ * @param out buffer for the uncompressed data
+ * @param out_len expected uncompressed size
+ * @return true if the member decompressed to exactly out_len bytes, false otherwise
+ */
+static bool inflate_member(const unsigned char *in, size_t in_len, unsigned char *out, size_t out_len);
+
+/**
+ * Decompression thread main function. Processes index entries until none are left or a thread failed.
+ *
+ * @param arg the shared parallel_job
+ * @return NULL
+ */
+static void *parallel_worker(void *arg);
+
+/**
+ * Decompress indexed gzip members on all available cores and write the restored file's data to the target.
+ *
+ * @param job shared job state with all fields above the lock initialised
+ * @return true on success, false otherwise
+ */
+static bool restore_parallel(parallel_job *job);
+
+
+/**
+ * Static functions
+ */
+
+static bool is_cancelled(const restore_opts *opts) {
+    return opts->cancel_cb != NULL && opts->cancel_cb(opts->user_data);
+}
+
+static bool gz_read_full(gzFile gz, void *buf, size_t len) {
+    unsigned char *p = buf;
+
+    while (len > 0) {
+        unsigned int request = len > INT_MAX ? INT_MAX : (unsigned int)len;
+        int n = gzread(gz, p, request);
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        len -= n;
+    }
+
+    return true;
+}
+
+static bool gz_skip(gzFile gz, uint64_t len) {
+    unsigned char scratch[TAR_BLOCK_SIZE * 8];
+
+    while (len > 0) {
+        size_t request = len > sizeof(scratch) ? sizeof(scratch) : (size_t)len;
+        if (!gz_read_full(gz, scratch, request)) {
+            return false;
+        }
+        len -= request;
+    }
+
+    return true;
+}
+
+static bool pwrite_full(int fd, const void *buf, size_t len, uint64_t offset) {
+    const unsigned char *p = buf;
+
+    while (len > 0) {
+        ssize_t n = pwrite(fd, p, len, (off_t)offset);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            log_error("Failed to write to target device: %s", strerror(errno));
+            return false;
+        }
+        p += n;
+        len -= n;
+        offset += n;
+    }
+
+    return true;
+}
+
+static bool pread_full(int fd, void *buf, size_t len, uint64_t offset) {
+    unsigned char *p = buf;
+
+    while (len > 0) {
+        ssize_t n = pread(fd, p, len, (off_t)offset);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        len -= n;
+        offset += n;
+    }
+
+    return true;
+}
+
+static bool is_zero(const unsigned char *buf, size_t len) {
+    /* Compare the buffer against itself shifted by one byte after checking the first byte */
+    return len == 0 || (buf[0] == 0 && memcmp(buf, buf + 1, len - 1) == 0);
+}
+
+static bool write_data(const restore_target *target, const unsigned char *buf, size_t len, uint64_t offset, uint64_t *written) {
+    if (!target->skip_zeroes) {
+        if (!pwrite_full(target->fd, buf, len, offset)) {
+            return false;
+        }
+        *written += len;
+        return true;
+    }
+
+    /* Coalesce consecutive non-zero blocks into a single write */
+    size_t extent_start = 0;
+    size_t extent_len = 0;
+
+    for (size_t pos = 0; pos < len; pos += RESTORE_SPARSE_BLOCK_SIZE) {
+        size_t block_len = len - pos < RESTORE_SPARSE_BLOCK_SIZE ? len - pos : RESTORE_SPARSE_BLOCK_SIZE;
+
+        if (!is_zero(buf + pos, block_len)) {
+            if (extent_len == 0) {
+                extent_start = pos;
+            }
+            extent_len += block_len;
+            continue;
+        }
+
+        if (extent_len > 0) {
+            if (!pwrite_full(target->fd, buf + extent_start, extent_len, offset + extent_start)) {
+                return false;
+            }
+            *written += extent_len;
+            extent_len = 0;
+        }
+    }
+
+    if (extent_len > 0) {
+        if (!pwrite_full(target->fd, buf + extent_start, extent_len, offset + extent_start)) {
+            return false;
+        }
+        *written += extent_len;
+    }
+
+    return true;
+}
+
+static void writeback_kick(const restore_target *target, writeback_state *wb) {
+    if (wb->dirty_end > wb->dirty_start) {
+        sync_file_range(target->fd, (off_t)wb->dirty_start, (off_t)(wb->dirty_end - wb->dirty_start), SYNC_FILE_RANGE_WRITE);
+    }
+
+    /* The previous window had a whole window's worth of time to reach the device, so this rarely blocks */
+    if (wb->flushing_end > wb->flushing_start) {
+        const off_t offset = (off_t)wb->flushing_start;
+        const off_t len = (off_t)(wb->flushing_end - wb->flushing_start);
+        sync_file_range(target->fd, offset, len, SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+        posix_fadvise(target->fd, offset, len, POSIX_FADV_DONTNEED);
+    }
+
+    wb->flushing_start = wb->dirty_start;
+    wb->flushing_end = wb->dirty_end;
+    wb->dirty_start = wb->dirty_end = 0;
+}
+
+static void writeback_add(const restore_target *target, writeback_state *wb, uint64_t offset, uint64_t len) {
+    const bool has_dirty = wb->dirty_end > wb->dirty_start;
+    if (has_dirty && (offset != wb->dirty_end || wb->dirty_end - wb->dirty_start >= RESTORE_WRITEBACK_WINDOW)) {
+        writeback_kick(target, wb);
+    }
+
+    if (wb->dirty_end == wb->dirty_start) {
+        wb->dirty_start = offset;
+    }
+    wb->dirty_end = offset + len;
+}
+
+static void writeback_finish(const restore_target *target, writeback_state *wb) {
+    /* Once for the dirty window, once more to wait for it */
+    writeback_kick(target, wb);
+    writeback_kick(target, wb);
+}
+
+static void drop_archive_range(int archive_fd, uint64_t offset, uint64_t len) {
+    if (len > 0) {
+        posix_fadvise(archive_fd, (off_t)offset, (off_t)len, POSIX_FADV_DONTNEED);
+    }
+}
+
+static bool is_write_zeroes_offloaded(int fd) {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISBLK(st.st_mode)) {
+        return false;
+    }
+
+    /* Partitions don't have their own queue directory, it lives on the parent disk */
+    static const char *candidates[] = { "queue", "../queue" };
+    for (size_t i = 0; i < sizeof(candidates) / sizeof(candidates[0]); ++i) {
+        char path[128];
+        snprintf(path, sizeof(path), "/sys/dev/block/%u:%u/%s/write_zeroes_max_bytes",
+            major(st.st_rdev), minor(st.st_rdev), candidates[i]);
+
+        FILE *file = fopen(path, "r");
+        if (file == NULL) {
+            continue;
+        }
+
+        unsigned long long max_bytes = 0;
+        bool found = fscanf(file, "%llu", &max_bytes) == 1;
+        fclose(file);
+
+        if (found) {
+            return max_bytes > 0;
+        }
+    }
+
+    return false;
+}
+
+static bool prepare_sparse_target(int fd, const char *device_path) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        return false;
+    }
+
+    if (S_ISREG(st.st_mode)) {
+        /* Image files (e.g. for testing) are zeroed by truncating them */
+        return ftruncate(fd, 0) == 0;
+    }
+
+    uint64_t size = 0;
+    if (ioctl(fd, BLKGETSIZE64, &size) != 0) {
+        log_error("Failed to get target device size: %s", strerror(errno));
+        return false;
+    }
+
+    uint64_t range[2] = { 0, size };
+
+    if (ioctl(fd, BLKDISCARD, range) == 0) {
+        log_info("Discarded %llu bytes on %s", (unsigned long long)size, device_path);
+    } else {
+        log_error("Could not discard %s (Error: %s)", device_path, strerror(errno));
+    }
+
+    /* Discarded blocks aren't guaranteed to read back as zeroes. Only skip zero blocks if the
+     * device can be explicitly zeroed without actually writing the whole partition. */
+    if (!is_write_zeroes_offloaded(fd)) {
+        log_warning("Writing zeroes is not offloaded on %s, zero blocks will be written", device_path);
+        return false;
+    }
+
+    if (ioctl(fd, BLKZEROOUT, range) != 0) {
+        log_error("Could not zero %s (Error: %s)", device_path, strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
+static uint64_t parse_tar_number(const char *field, size_t len) {
+    const unsigned char *p = (const unsigned char *)field;
+    uint64_t value = 0;
+
+    if (p[0] & 0x80) {
+        /* GNU base-256 encoding, used for members of 8 GiB and more */
+        value = p[0] & 0x7f;
+        for (size_t i = 1; i < len; ++i) {
+            value = (value << 8) | p[i];
+        }
+        return value;
+    }
+
+    size_t i = 0;
+    while (i < len && (p[i] == ' ' || p[i] == '\0')) {
+        ++i;
+    }
+    for (; i < len && p[i] >= '0' && p[i] <= '7'; ++i) {
+        value = (value << 3) | (uint64_t)(p[i] - '0');
+    }
+
+    return value;
+}
+
+static bool parse_pax_size(const char *data, size_t len, uint64_t *size) {
+    size_t offset = 0;
+
+    /* Records have the form "<length> <key>=<value>\n" */
+    while (offset < len) {
+        char *end = NULL;
+        unsigned long record_len = strtoul(data + offset, &end, 10);
+        if (record_len == 0 || end == NULL || *end != ' ' || offset + record_len > len) {
+            return false;
+        }
+
+        const char *key = end + 1;
+        const char *record_end = data + offset + record_len;
+        if (record_end - key > 5 && strncmp(key, "size=", 5) == 0) {
+            *size = strtoull(key + 5, NULL, 10);
+            return true;
+        }
+
+        offset += record_len;
+    }
+
+    return false;
+}
+
+static bool is_zero_block(const unsigned char *block) {
+    for (int i = 0; i < TAR_BLOCK_SIZE; ++i) {
+        if (block[i] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool stream_member(gzFile gz, int archive_fd, const restore_target *target, uint64_t size, const restore_opts *opts, uint64_t *bytes_written) {
+    void *chunk = NULL;
+    if (posix_memalign(&chunk, RESTORE_CHUNK_ALIGN, RESTORE_CHUNK_SIZE) != 0) {
+        log_error("Could not allocate restore buffer");
+        return false;
+    }
+
+    uint64_t offset = 0;
+    bool ok = true;
+    writeback_state wb = { 0 };
+    uint64_t archive_dropped = 0;
+
+    while (offset < size) {
+        if (is_cancelled(opts)) {
+            ok = false;
+            break;
+        }
+
+        size_t len = size - offset > RESTORE_CHUNK_SIZE ? RESTORE_CHUNK_SIZE : (size_t)(size - offset);
+
+        if (!gz_read_full(gz, chunk, len)) {
+            log_error("Archive ended prematurely, %llu bytes missing", (unsigned long long)(size - offset));
+            ok = false;
+            break;
+        }
+
+        if (!write_data(target, chunk, len, offset, bytes_written)) {
+            ok = false;
+            break;
+        }
+        writeback_add(target, &wb, offset, len);
+
+        /* zlib only reads ahead by its buffer size, everything before that was consumed */
+        const z_off_t consumed = gzoffset(gz);
+        if (consumed > 0 && (uint64_t)consumed > archive_dropped + RESTORE_WRITEBACK_WINDOW) {
+            drop_archive_range(archive_fd, archive_dropped, (uint64_t)consumed - archive_dropped);
+            archive_dropped = (uint64_t)consumed;
+        }
+
+        offset += len;
+
+        if (opts->progress_cb != NULL) {
+            opts->progress_cb(offset, size, opts->user_data);
+        }
+    }
+
+    writeback_finish(target, &wb);
+    free(chunk);
+    return ok;
+}
+
+static bool find_member(gzFile gz, const char *archive_path, uint64_t *size) {
+    unsigned char header[TAR_BLOCK_SIZE];
+    uint64_t pax_size = 0;
+    bool have_pax_size = false;
+
+    while (true) {
+        if (!gz_read_full(gz, header, sizeof(header))) {
+            log_error("Failed to read tar header from %s", archive_path);
+            return false;
+        }
+
+        if (is_zero_block(header)) {
+            log_error("No regular file found in %s", archive_path);
+            return false;
+        }
+
+        char type = (char)header[156];
+        uint64_t member_size = have_pax_size ? pax_size : parse_tar_number((const char *)header + 124, 12);
+        uint64_t padded_size = (member_size + TAR_BLOCK_SIZE - 1) / TAR_BLOCK_SIZE * TAR_BLOCK_SIZE;
+        have_pax_size = false;
+
+        if (type == '0' || type == '\0' || type == '7') {
+            log_info("Found %.100s (%llu bytes) in %s", (const char *)header, (unsigned long long)member_size, archive_path);
+            *size = member_size;
+            return true;
+        }
+
+        if (type == 'x') {
+            /* pax extended header, may carry the size of the next member */
+            if (member_size > TAR_PAX_MAX_SIZE) {
+                log_error("Oversized pax header in %s", archive_path);
+                return false;
+            }
+            char *pax = malloc(padded_size);
+            if (pax == NULL || !gz_read_full(gz, pax, padded_size)) {
+                log_error("Failed to read pax header from %s", archive_path);
+                free(pax);
+                return false;
+            }
+            have_pax_size = parse_pax_size(pax, member_size, &pax_size);
+            free(pax);
+            continue;
+        }
+
+        /* Directories, links, GNU long names and global headers carry nothing we need */
+        if (!gz_skip(gz, padded_size)) {
+            log_error("Failed to skip tar member in %s", archive_path);
+            return false;
+        }
+    }
+}
+
+static bool load_index(const char *index_path, uint64_t archive_size, index_entry **entries, size_t *num_entries) {
+    FILE *file = fopen(index_path, "r");
+    if (file == NULL) {
+        return false;
+    }
+
+    size_t capacity = 0;
+    size_t count = 0;
+    index_entry *list = NULL;
+    char line[256];
+    bool ok = true;
+
+    while (ok && fgets(line, sizeof(line), file) != NULL) {
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+
+        unsigned long long coff, clen, uoff, ulen;
+        if (sscanf(line, "%llu %llu %llu %llu", &coff, &clen, &uoff, &ulen) != 4) {
+            log_error("Malformed line in %s", index_path);
+            ok = false;
+            break;
+        }
+
+        if (count == capacity) {
+            capacity = capacity == 0 ? 256 : capacity * 2;
+            index_entry *grown = realloc(list, capacity * sizeof(index_entry));
+            if (grown == NULL) {
+                log_error("Could not allocate memory for %s", index_path);
+                ok = false;
+                break;
+            }
+            list = grown;
+        }
+
+        /* Members must be contiguous in both the compressed and the uncompressed stream */
+        uint64_t expected_coff = count == 0 ? 0 : list[count - 1].compressed_offset + list[count - 1].compressed_size;
+        uint64_t expected_uoff = count == 0 ? 0 : list[count - 1].uncompressed_offset + list[count - 1].uncompressed_size;
+        if (coff != expected_coff || uoff != expected_uoff || clen == 0 || ulen == 0 || ulen > RESTORE_MAX_MEMBER_SIZE) {
+            log_error("Inconsistent entry %zu in %s", count, index_path);
+            ok = false;
+            break;
+        }
+
+        list[count].compressed_offset = coff;
+        list[count].compressed_size = clen;
+        list[count].uncompressed_offset = uoff;
+        list[count].uncompressed_size = ulen;
+        ++count;
+    }
+
+    fclose(file);
+
+    if (ok && (count == 0 || list[count - 1].compressed_offset + list[count - 1].compressed_size != archive_size)) {
+        log_error("Index %s does not cover the whole archive", index_path);
+        ok = false;
+    }
+
+    if (!ok) {
+        free(list);
+        return false;
+    }
+
+    *entries = list;
+    *num_entries = count;
+    return true;
+}
+
+static bool inflate_member(const unsigned char *in, size_t in_len, unsigned char *out, size_t out_len) {
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+
+    /* 16 + MAX_WBITS selects gzip framing */
+    if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK) {
+        return false;
+    }
+
+    stream.next_in = (unsigned char *)in;
+    stream.avail_in = (uInt)in_len;
+    stream.next_out = out;
+    stream.avail_out = (uInt)out_len;
+
+    int ret = inflate(&stream, Z_FINISH);
+    bool ok = ret == Z_STREAM_END && stream.total_out == out_len;
+
+    inflateEnd(&stream);
+    return ok;
+}
+
+static void *parallel_worker(void *arg) {
+    parallel_job *job = arg;
+    unsigned char *in = malloc(job->max_compressed_size);
+    unsigned char *out = malloc(job->max_uncompressed_size);
+
+    if (in == NULL || out == NULL) {
+        log_error("Could not allocate decompression buffers");
+        pthread_mutex_lock(&job->lock);
+        job->failed = true;
+        pthread_mutex_unlock(&job->lock);
+    }
+
+    const uint64_t data_end = job->data_offset + job->data_size;
+    writeback_state wb = { 0 };
+
+    while (in != NULL && out != NULL) {
+        const bool cancelled = is_cancelled(job->opts);
+
+        pthread_mutex_lock(&job->lock);
+        job->failed = job->failed || cancelled;
+        bool done = job->failed || job->next_entry >= job->num_entries;
+        size_t i = job->next_entry++;
+        pthread_mutex_unlock(&job->lock);
+
+        if (done) {
+            break;
+        }
+
+        const index_entry *entry = &job->entries[i];
+        uint64_t start = entry->uncompressed_offset;
+        uint64_t end = start + entry->uncompressed_size;
+
+        /* Skip members that only hold tar headers or trailing padding */
+        if (end <= job->data_offset || start >= data_end) {
+            continue;
+        }
+
+        bool ok = pread_full(job->archive_fd, in, entry->compressed_size, entry->compressed_offset);
+        drop_archive_range(job->archive_fd, entry->compressed_offset, entry->compressed_size);
+        if (!ok) {
+            log_error("Failed to read gzip member %zu", i);
+        } else if (!(ok = inflate_member(in, entry->compressed_size, out, entry->uncompressed_size))) {
+            log_error("Failed to decompress gzip member %zu", i);
+        }
+
+        /* Clip the member to the restored file's data */
+        uint64_t write_start = start > job->data_offset ? start : job->data_offset;
+        uint64_t write_end = end < data_end ? end : data_end;
+        size_t len = (size_t)(write_end - write_start);
+
+        uint64_t written = 0;
+        if (ok) {
+            ok = write_data(job->target, out + (write_start - start), len, write_start - job->data_offset, &written);
+        }
+        if (ok) {
+            writeback_add(job->target, &wb, write_start - job->data_offset, len);
+        }
+
+        pthread_mutex_lock(&job->lock);
+        if (ok) {
+            job->bytes_restored += len;
+            job->bytes_written += written;
+            /* Called under the lock so that updates are serialised and never go backwards */
+            if (job->opts->progress_cb != NULL) {
+                job->opts->progress_cb(job->bytes_restored, job->data_size, job->opts->user_data);
+            }
+        } else {
+            job->failed = true;
+        }
+        pthread_mutex_unlock(&job->lock);
+    }
+
+    writeback_finish(job->target, &wb);
+    free(in);
+    free(out);
+    return NULL;
+}
+
+static bool restore_parallel(parallel_job *job) {
+    long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t num_threads = num_cpus > 0 ? (size_t)num_cpus : 1;
+    if (num_threads > RESTORE_MAX_THREADS) {
+        num_threads = RESTORE_MAX_THREADS;
+    }
+    if (num_threads > job->num_entries) {
+        num_threads = job->num_entries;
+    }
+
+    job->max_compressed_size = 0;
+    job->max_uncompressed_size = 0;
+    for (size_t i = 0; i < job->num_entries; ++i) {
+        if (job->entries[i].compressed_size > job->max_compressed_size) {
+            job->max_compressed_size = job->entries[i].compressed_size;
+        }
+        if (job->entries[i].uncompressed_size > job->max_uncompressed_size) {
+            job->max_uncompressed_size = job->entries[i].uncompressed_size;
+        }
+    }
+
+    pthread_mutex_init(&job->lock, NULL);
+    job->next_entry = 0;
+    job->failed = false;
+    job->bytes_restored = 0;
+    job->bytes_written = 0;
+
+    log_info("Decompressing %zu gzip members on %zu threads", job->num_entries, num_threads);
+
+    pthread_t threads[RESTORE_MAX_THREADS];
+    size_t num_started = 0;
+    for (; num_started < num_threads; ++num_started) {
+        if (pthread_create(&threads[num_started], NULL, parallel_worker, job) != 0) {
+            log_error("pthread_create: %s", strerror(errno));
+            break;
+        }
+    }
+
+    if (num_started == 0) {
+        /* Nothing could be started, do the work on the calling thread */
+        parallel_worker(job);
+    }
+
+    for (size_t i = 0; i < num_started; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&job->lock);
+
+    if (!job->failed && job->bytes_restored != job->data_size) {
+        log_error("Index does not cover the restored file, %llu of %llu bytes restored",
+            (unsigned long long)job->bytes_restored, (unsigned long long)job->data_size);
+        return false;
+    }
+
+    return !job->failed;
+}
+
+
+/**
+ * Public functions
+ */
+
+int restore_archive_to_device(const char *archive_path, const char *device_path, const restore_opts *opts, restore_stats *stats) {
+    uint64_t start_us = tick_now_us();
+    uint64_t bytes_written = 0;
+    uint64_t size = 0;
+    bool restored = false;
+
+    int archive_fd = open(archive_path, O_RDONLY | O_CLOEXEC);
+    if (archive_fd < 0) {
+        log_error("Failed to open archive %s (Error: %s)", archive_path, strerror(errno));
+        return -1;
+    }
+
+    off_t archive_size = lseek(archive_fd, 0, SEEK_END);
+    lseek(archive_fd, 0, SEEK_SET);
+    posix_fadvise(archive_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    /* Archives made of independent gzip members ship an index that allows decompressing them in parallel */
+    char index_path[PATH_MAX];
+    index_entry *entries = NULL;
+    size_t num_entries = 0;
+    snprintf(index_path, sizeof(index_path), "%s%s", archive_path, RESTORE_INDEX_SUFFIX);
+    if (archive_size > 0 && load_index(index_path, (uint64_t)archive_size, &entries, &num_entries)) {
+        log_info("Using gzip member index %s", index_path);
+    }
+
+    /* gzdopen takes ownership of the descriptor, the parallel path needs its own */
+    int parallel_fd = entries != NULL ? dup(archive_fd) : -1;
+
+    gzFile gz = gzdopen(archive_fd, "rb");
+    if (gz == NULL) {
+        log_error("Failed to open gzip stream for %s", archive_path);
+        close(archive_fd);
+        if (parallel_fd >= 0) {
+            close(parallel_fd);
+        }
+        free(entries);
+        return -1;
+    }
+    gzbuffer(gz, RESTORE_GZ_BUFFER_SIZE);
+
+    int device_fd = open(device_path, O_WRONLY | O_CLOEXEC);
+    if (device_fd < 0) {
+        log_error("Failed to open target device %s (Error: %s)", device_path, strerror(errno));
+        gzclose(gz);
+        if (parallel_fd >= 0) {
+            close(parallel_fd);
+        }
+        free(entries);
+        return -1;
+    }
+
+    restore_target target = {
+        .fd = device_fd,
+        .skip_zeroes = false
+    };
+
+    if (find_member(gz, archive_path, &size)) {
+        if (opts->sparse) {
+            target.skip_zeroes = prepare_sparse_target(device_fd, device_path);
+        }
+
+        log_info("Restoring %llu bytes to %s%s", (unsigned long long)size, device_path,
+            target.skip_zeroes ? ", skipping zero blocks" : "");
+
+        if (parallel_fd >= 0) {
+            parallel_job job = {
+                .archive_fd = parallel_fd,
+                .target = &target,
+                .opts = opts,
+                .entries = entries,
+                .num_entries = num_entries,
+                .data_offset = (uint64_t)gztell(gz),
+                .data_size = size
+            };
+            restored = restore_parallel(&job);
+            bytes_written = job.bytes_written;
+        } else {
+            restored = stream_member(gz, archive_fd, &target, size, opts, &bytes_written);
+        }
+
+        if (!restored && is_cancelled(opts)) {
+            log_warning("Restore of %s cancelled", device_path);
+        }
+
+        /* Skipped trailing zero blocks don't extend image files */
+        struct stat st;
+        if (restored && target.skip_zeroes && fstat(device_fd, &st) == 0 && S_ISREG(st.st_mode)) {
+            restored = ftruncate(device_fd, (off_t)size) == 0;
+        }
+    }
+
+    if (fsync(device_fd) != 0) {
+        log_error("Failed to sync target device: %s", strerror(errno));
+        restored = false;
+    }
+    close(device_fd);
+    gzclose(gz);
+    if (parallel_fd >= 0) {
+        close(parallel_fd);
+    }
+    free(entries);
+
+    uint64_t elapsed_us = tick_now_us() - start_us;
+
+    if (stats != NULL) {
+        stats->bytes_read = archive_size > 0 ? (uint64_t)archive_size : 0;
+        stats->bytes_written = bytes_written;
+        stats->bytes_skipped = restored ? size - bytes_written : 0;
+        stats->elapsed_us = elapsed_us;
+    }
+
+    double elapsed_s = elapsed_us / 1000000.0;
+    log_info("Restored %llu bytes (%llu written) in %.1f s (%.1f MiB/s)", (unsigned long long)size,
+        (unsigned long long)bytes_written, elapsed_s, elapsed_s > 0 ? size / elapsed_s / (1024 * 1024) : 0.0);
+
+    return restored ? 0 : -1;
+}
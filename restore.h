@@ -0,0 +1,87 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef RESTORE_H
+#define RESTORE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Progress callback, invoked from the restoring thread(s) but never concurrently.
+ *
+ * @param bytes_done number of bytes of the image restored so far
+ * @param bytes_total size of the image
+ * @param user_data user data from the restore options
+ */
+typedef void (*restore_progress_cb)(uint64_t bytes_done, uint64_t bytes_total, void *user_data);
+
+/**
+ * Cancellation check, polled from the restoring thread(s) before every chunk.
+ *
+ * @param user_data user data from the restore options
+ * @return true to stop the restore, which then fails
+ */
+typedef bool (*restore_cancel_cb)(void *user_data);
+
+/**
+ * Options for a restore
+ */
+typedef struct {
+    /* If true, discard the target and skip zero blocks where possible */
+    bool sparse;
+    /* Progress callback, may be NULL */
+    restore_progress_cb progress_cb;
+    /* Cancellation check, may be NULL */
+    restore_cancel_cb cancel_cb;
+    /* User data for the callbacks */
+    void *user_data;
+} restore_opts;
+
+/**
+ * Statistics collected while restoring an archive
+ */
+typedef struct {
+    /* Number of compressed bytes read from the archive */
+    uint64_t bytes_read;
+    /* Number of bytes written to the target device */
+    uint64_t bytes_written;
+    /* Number of zero bytes that did not need to be written in sparse mode */
+    uint64_t bytes_skipped;
+    /* Wall time spent on the restore in microseconds */
+    uint64_t elapsed_us;
+} restore_stats;
+
+/**
+ * Stream the first regular file of a gzip compressed tar archive onto a block device. This is the
+ * in-process equivalent of "tar -xzOf ARCHIVE | dd of=DEVICE bs=4M".
+ *
+ * In sparse mode the whole target is discarded first. If the device can then also be zeroed cheaply,
+ * zero blocks in the image are skipped instead of written.
+ *
+ * @param archive_path path of the .tar.gz archive
+ * @param device_path path of the target block device
+ * @param opts restore options
+ * @param stats pointer for writing statistics into, may be NULL
+ * @return 0 on success, -1 on failure or if the restore was cancelled
+ */
+int restore_archive_to_device(const char *archive_path, const char *device_path, const restore_opts *opts, restore_stats *stats);
+
+#endif /* RESTORE_H */
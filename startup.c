@@ -0,0 +1,189 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "startup.h"
+
+#include "tick.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * Defines
+ */
+
+/* Maximum number of recorded stages */
+#define STARTUP_MAX_STAGES 16
+
+
+/**
+ * Static types
+ */
+
+/* A completed startup stage */
+typedef struct {
+    /* Stage name */
+    const char *name;
+    /* Completion time in CLOCK_BOOTTIME microseconds */
+    uint64_t time_us;
+} stage;
+
+
+/**
+ * Static variables
+ */
+
+static stage stages[STARTUP_MAX_STAGES];
+static int num_stages = 0;
+static bool first_frame_done = false;
+/* Set by the flush callback, which may run on the flush thread, 0 until the first frame was flushed */
+static atomic_uint_least64_t first_frame_us = 0;
+
+static void (*backend_flush_cb)(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p) = NULL;
+static void (*first_frame_cb)(void) = NULL;
+
+
+/**
+ * Static prototypes
+ */
+
+/**
+ * Get the time the process was started at, from /proc/self/stat.
+ *
+ * @return time in CLOCK_BOOTTIME microseconds, 0 if unknown
+ */
+static uint64_t exec_time_us(void);
+
+/**
+ * Detect the end of the first frame.
+ *
+ * @param disp_drv display driver
+ * @param area area to flush
+ * @param color_p rendered pixels of the area
+ */
+static void watched_flush_cb(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p);
+
+/**
+ * Record the first frame and run the callback on the LVGL thread once it was flushed.
+ *
+ * @param timer the timer
+ */
+static void first_frame_timer_cb(lv_timer_t *timer);
+
+
+/**
+ * Static functions
+ */
+
+static uint64_t exec_time_us(void) {
+    FILE *file = fopen("/proc/self/stat", "r");
+    if (file == NULL) {
+        return 0;
+    }
+
+    char buffer[1024];
+    size_t len = fread(buffer, 1, sizeof(buffer) - 1, file);
+    fclose(file);
+    buffer[len] = '\0';
+
+    /* The command name may contain spaces, fields are counted from its closing parenthesis */
+    char *p = strrchr(buffer, ')');
+    unsigned long long start_ticks = 0;
+    if (p == NULL || sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %*u %*u %*d %*d %*d %*d %*d %*d %llu",
+            &start_ticks) != 1) {
+        return 0;
+    }
+
+    long ticks_per_second = sysconf(_SC_CLK_TCK);
+    return ticks_per_second > 0 ? start_ticks * 1000000 / ticks_per_second : 0;
+}
+
+static void watched_flush_cb(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p) {
+    /* Read before flushing, lv_disp_flush_ready() resets it */
+    bool is_last = lv_disp_flush_is_last(disp_drv);
+
+    backend_flush_cb(disp_drv, area, color_p);
+
+    if (is_last && atomic_load(&first_frame_us) == 0) {
+        atomic_store(&first_frame_us, tick_boot_us());
+    }
+}
+
+static void first_frame_timer_cb(lv_timer_t *timer) {
+    const uint64_t time_us = atomic_load(&first_frame_us);
+    if (time_us == 0) {
+        return;
+    }
+    lv_timer_del(timer);
+
+    if (num_stages < STARTUP_MAX_STAGES) {
+        stages[num_stages].name = "first_frame";
+        stages[num_stages].time_us = time_us;
+        ++num_stages;
+    }
+    first_frame_done = true;
+
+    if (first_frame_cb != NULL) {
+        first_frame_cb();
+    }
+}
+
+
+/**
+ * Public functions
+ */
+
+void startup_mark(const char *stage) {
+    if (first_frame_done || num_stages == STARTUP_MAX_STAGES) {
+        return;
+    }
+
+    stages[num_stages].name = stage;
+    stages[num_stages].time_us = tick_boot_us();
+    ++num_stages;
+}
+
+void startup_watch_first_frame(lv_disp_drv_t *disp_drv, void (*cb)(void)) {
+    backend_flush_cb = disp_drv->flush_cb;
+    first_frame_cb = cb;
+    disp_drv->flush_cb = watched_flush_cb;
+
+    /* Polled at display rate, like the factory reset progress, until the first frame is done */
+    lv_timer_create(first_frame_timer_cb, LV_DISP_DEF_REFR_PERIOD, NULL);
+}
+
+void startup_print(FILE *out) {
+    uint64_t exec_us = exec_time_us();
+    uint64_t previous_us = exec_us;
+
+    fprintf(out, "startup stage=exec boottime_us=%llu since_exec_us=0 delta_us=0\n", (unsigned long long)exec_us);
+
+    for (int i = 0; i < num_stages; ++i) {
+        fprintf(out, "startup stage=%s boottime_us=%llu since_exec_us=%llu delta_us=%llu\n", stages[i].name,
+            (unsigned long long)stages[i].time_us, (unsigned long long)(stages[i].time_us - exec_us),
+            (unsigned long long)(stages[i].time_us - previous_us));
+        previous_us = stages[i].time_us;
+    }
+
+    fflush(out);
+}
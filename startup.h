@@ -0,0 +1,53 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef STARTUP_H
+#define STARTUP_H
+
+#include "lvgl/lvgl.h"
+
+#include <stdio.h>
+
+/**
+ * Record that a startup stage completed. Stages after the first frame are ignored.
+ *
+ * @param stage stage name, must be a string literal
+ */
+void startup_mark(const char *stage);
+
+/**
+ * Record the "first_frame" stage once the first frame was completely flushed and run a callback.
+ * Call this after lv_init with flush_cb set, before render_init and lv_disp_drv_register.
+ *
+ * @param disp_drv display driver
+ * @param cb callback to run after the first frame, may be NULL. Always runs on the LVGL thread, also
+ *        in the double buffered render modes that flush on a thread of their own.
+ */
+void startup_watch_first_frame(lv_disp_drv_t *disp_drv, void (*cb)(void));
+
+/**
+ * Print all recorded stages, one key=value line each. Timestamps are CLOCK_BOOTTIME microseconds, so
+ * they can be compared against the kernel log.
+ *
+ * @param out stream to print to
+ */
+void startup_print(FILE *out);
+
+#endif /* STARTUP_H */
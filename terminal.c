@@ -20,10 +20,11 @@
 
 #include "terminal.h"
 
+#include "log.h"
+
 #include <fcntl.h>
 #include <stdbool.h>
 #include <unistd.h>
-#include <stdio.h>
 
 #include <linux/kd.h>
 
@@ -66,7 +67,7 @@ static bool reopen_current_terminal(void) {
 
     current_fd = open("/dev/tty0", O_RDWR);
     if (current_fd < 0) {
-        printf("Could not open /dev/tty0\n");
+        log_error("Could not open /dev/tty0");
         return false;
     }
 
@@ -91,7 +92,7 @@ void terminal_prepare_current_terminal(void) {
     reopen_current_terminal();
 
     if (current_fd < 0) {
-        printf("Could not prepare current terminal\n");
+        log_error("Could not prepare current terminal");
         return;
     }
 
@@ -99,25 +100,25 @@ void terminal_prepare_current_terminal(void) {
     // https://gitlab.com/cherrypicker/unl0kr/-/issues/34 for further info.
 
     if (ioctl(current_fd, KDGKBMODE, &original_kb_mode) != 0) {
-        printf("Could not get terminal keyboard mode\n");
+        log_error("Could not get terminal keyboard mode");
     }
 
     if (ioctl(current_fd, KDSKBMODE, K_OFF) != 0) {
-        printf("Could not set terminal keyboard mode to off\n");
+        log_error("Could not set terminal keyboard mode to off");
     }
 
     if (ioctl(current_fd, KDGETMODE, &original_mode) != 0) {
-        printf("Could not get terminal mode\n");
+        log_error("Could not get terminal mode");
     }
 
     if (ioctl(current_fd, KDSETMODE, KD_GRAPHICS) != 0) {
-        printf("Could not set terminal mode to graphics\n");
+        log_error("Could not set terminal mode to graphics");
     }
 }
 
 void terminal_reset_current_terminal(void) {
     if (current_fd < 0) {
-        printf("Could not reset current terminal\n");
+        log_error("Could not reset current terminal");
         return;
     }
 
@@ -125,11 +126,11 @@ void terminal_reset_current_terminal(void) {
     // https://gitlab.com/cherrypicker/unl0kr/-/issues/34 for further info.
 
     if (ioctl(current_fd, KDSETMODE, original_mode) != 0) {
-        printf("Could not reset terminal mode\n");
+        log_error("Could not reset terminal mode");
     }
 
     if (ioctl(current_fd, KDSKBMODE, original_kb_mode) != 0) {
-        printf("Could not reset terminal keyboard mode\n");
+        log_error("Could not reset terminal keyboard mode");
     }
 
     close_current_terminal();
@@ -20,21 +20,28 @@
 
 #include "theme.h"
 
+#include "fonts.h"
+#include "log.h"
 #include "sq2lv_layouts.h"
 #include "furios-recovery.h"
 
 #include "lvgl/lvgl.h"
 
-#include <stdio.h>
 
 /**
- * Static variables
+ * Defines
  */
 
-static theme current_theme;
-static lv_theme_t lv_theme;
+/* Number of themes whose styles are kept built, enough for the default and alternate theme */
+#define THEME_NUM_STYLE_SETS 2
+
 
-static struct {
+/**
+ * Static types
+ */
+
+/* All styles derived from a theme */
+typedef struct {
     lv_style_t widget;
     lv_style_t window;
     lv_style_t header;
@@ -56,9 +63,29 @@ static struct {
     lv_style_t msgbox_background;
     lv_style_t bar;
     lv_style_t bar_indicator;
-} styles; 
+} style_set;
+
+/* Styles built for a theme */
+typedef struct {
+    /* Theme the styles were built from, NULL if the slot is free */
+    const theme *theme;
+    /* The styles */
+    style_set styles;
+} prebuilt_style_set;
+
+
+/**
+ * Static variables
+ */
+
+static const theme *current_theme = NULL;
+static lv_theme_t lv_theme;
 
-static bool are_styles_initialised = false;
+/* Styles attached to objects. Switching themes copies a prebuilt set in, which only swaps the
+   pointers to the property arrays owned by the prebuilt set. Never reset or modify these. */
+static style_set styles;
+
+static prebuilt_style_set prebuilt[THEME_NUM_STYLE_SETS];
 
 
 /**
@@ -66,18 +93,27 @@ static bool are_styles_initialised = false;
  */
 
 /**
- * Set up the static styles for a specific theme.
+ * Set up a style set for a specific theme.
  *
+ * @param set style set to initialise, must not be initialised yet or have been reset
  * @param theme theme to derive the styles from
  */
-static void init_styles(const theme *theme);
+static void init_styles(style_set *set, const theme *theme);
 
 /**
- * Initialise or reset a style.
+ * Reset all styles of a style set.
  *
- * @param style style to reset
+ * @param set style set to reset
  */
-static void reset_style(lv_style_t *style);
+static void reset_styles(style_set *set);
+
+/**
+ * Get the prebuilt styles for a theme, building them if necessary.
+ *
+ * @param theme the theme
+ * @return the style set
+ */
+static const style_set *get_styles(const theme *theme);
 
 /**
  * Apply a theme to an object.
@@ -99,148 +135,168 @@ static void keyboard_draw_part_begin_cb(lv_event_t *event);
  * Static functions
  */
 
-static void init_styles(const theme *theme) {
-    reset_style(&(styles.widget));
-    lv_style_set_text_font(&(styles.widget), &font_32);
-
-    reset_style(&(styles.window));
-    lv_style_set_bg_opa(&(styles.window), LV_OPA_COVER);
-    lv_style_set_bg_color(&(styles.window), lv_color_hex(theme->window.bg_color));
-
-    reset_style(&(styles.header));
-    lv_style_set_bg_opa(&(styles.header), LV_OPA_COVER);
-    lv_style_set_bg_color(&(styles.header), lv_color_hex(theme->header.bg_color));
-    lv_style_set_border_side(&(styles.header), LV_BORDER_SIDE_BOTTOM);
-    lv_style_set_border_width(&(styles.header), lv_dpx(theme->header.border_width));
-    lv_style_set_border_color(&(styles.header), lv_color_hex(theme->header.border_color));
-    lv_style_set_pad_all(&(styles.header), lv_dpx(theme->header.pad));
-    lv_style_set_pad_gap(&(styles.header), lv_dpx(theme->header.gap));
-
-    reset_style(&(styles.keyboard));
-    lv_style_set_bg_opa(&(styles.keyboard), LV_OPA_COVER);
-    lv_style_set_bg_color(&(styles.keyboard), lv_color_hex(theme->keyboard.bg_color));
-    lv_style_set_border_side(&(styles.keyboard), LV_BORDER_SIDE_TOP);
-    lv_style_set_border_width(&(styles.keyboard), lv_dpx(theme->keyboard.border_width));
-    lv_style_set_border_color(&(styles.keyboard), lv_color_hex(theme->keyboard.border_color));
-    lv_style_set_pad_all(&(styles.keyboard), lv_dpx(theme->keyboard.pad));
-    lv_style_set_pad_gap(&(styles.keyboard), lv_dpx(theme->keyboard.gap));
-
-    reset_style(&(styles.key));
-    lv_style_set_bg_opa(&(styles.key), LV_OPA_COVER);
-    lv_style_set_border_side(&(styles.key), LV_BORDER_SIDE_FULL);
-    lv_style_set_border_width(&(styles.key), lv_dpx(theme->keyboard.keys.border_width));
-    lv_style_set_radius(&(styles.key), lv_dpx(theme->keyboard.keys.corner_radius));
-
-    reset_style(&(styles.button));
-    lv_style_set_text_color(&(styles.button), lv_color_hex(theme->button.normal.fg_color));
-    lv_style_set_bg_opa(&(styles.button), LV_OPA_COVER);
-    lv_style_set_bg_color(&(styles.button), lv_color_hex(theme->button.normal.bg_color));
-    lv_style_set_border_side(&(styles.button), LV_BORDER_SIDE_FULL);
-    lv_style_set_border_width(&(styles.button), lv_dpx(theme->button.border_width));
-    lv_style_set_border_color(&(styles.button), lv_color_hex(theme->button.normal.border_color));
-    lv_style_set_radius(&(styles.button), lv_dpx(theme->button.corner_radius));
-    lv_style_set_pad_all(&(styles.button), lv_dpx(theme->button.pad));
-
-    reset_style(&(styles.button_pressed));
-    lv_style_set_text_color(&(styles.button_pressed), lv_color_hex(theme->button.pressed.fg_color));
-    lv_style_set_bg_color(&(styles.button_pressed), lv_color_hex(theme->button.pressed.bg_color));
-    lv_style_set_border_color(&(styles.button_pressed), lv_color_hex(theme->button.pressed.border_color));
-
-    reset_style(&(styles.textarea));
-    lv_style_set_text_color(&(styles.textarea), lv_color_hex(theme->textarea.fg_color));
-    lv_style_set_bg_opa(&(styles.textarea), LV_OPA_COVER);
-    lv_style_set_bg_color(&(styles.textarea), lv_color_hex(theme->textarea.bg_color));  
-    lv_style_set_border_side(&(styles.textarea), LV_BORDER_SIDE_FULL);
-    lv_style_set_border_width(&(styles.textarea), lv_dpx(theme->textarea.border_width));
-    lv_style_set_border_color(&(styles.textarea), lv_color_hex(theme->textarea.border_color));
-    lv_style_set_radius(&(styles.textarea), lv_dpx(theme->textarea.corner_radius));
-    lv_style_set_pad_all(&(styles.textarea), lv_dpx(theme->textarea.pad));
-
-    reset_style(&(styles.textarea_placeholder));
-    lv_style_set_text_color(&(styles.textarea_placeholder), lv_color_hex(theme->textarea.placeholder_color));
-
-    reset_style(&(styles.textarea_cursor));
-    lv_style_set_border_side(&(styles.textarea_cursor), LV_BORDER_SIDE_LEFT);
-    lv_style_set_border_width(&(styles.textarea_cursor), lv_dpx(theme->textarea.cursor.width));
-    lv_style_set_border_color(&(styles.textarea_cursor), lv_color_hex(theme->textarea.cursor.color));
-    lv_style_set_anim_time(&(styles.textarea_cursor), theme->textarea.cursor.period);
-
-    reset_style(&(styles.dropdown));
-    lv_style_set_text_color(&(styles.dropdown), lv_color_hex(theme->dropdown.button.normal.fg_color));
-    lv_style_set_bg_opa(&(styles.dropdown), LV_OPA_COVER);
-    lv_style_set_bg_color(&(styles.dropdown), lv_color_hex(theme->dropdown.button.normal.bg_color));
-    lv_style_set_border_side(&(styles.dropdown), LV_BORDER_SIDE_FULL);
-    lv_style_set_border_width(&(styles.dropdown), lv_dpx(theme->dropdown.button.border_width));
-    lv_style_set_border_color(&(styles.dropdown), lv_color_hex(theme->dropdown.button.normal.border_color));
-    lv_style_set_radius(&(styles.dropdown), lv_dpx(theme->dropdown.button.corner_radius));
-    lv_style_set_pad_all(&(styles.dropdown), lv_dpx(theme->dropdown.button.pad));
-
-    reset_style(&(styles.dropdown_pressed));
-    lv_style_set_text_color(&(styles.dropdown_pressed), lv_color_hex(theme->dropdown.button.pressed.fg_color));
-    lv_style_set_bg_color(&(styles.dropdown_pressed), lv_color_hex(theme->dropdown.button.pressed.bg_color));
-    lv_style_set_border_color(&(styles.dropdown_pressed), lv_color_hex(theme->dropdown.button.pressed.border_color));
-
-    reset_style(&(styles.dropdown_list));
-    lv_style_set_text_color(&(styles.dropdown_list), lv_color_hex(theme->dropdown.list.fg_color));
-    lv_style_set_bg_opa(&(styles.dropdown_list), LV_OPA_COVER);
-    lv_style_set_bg_color(&(styles.dropdown_list), lv_color_hex(theme->dropdown.list.bg_color));
-    lv_style_set_border_side(&(styles.dropdown_list), LV_BORDER_SIDE_FULL);
-    lv_style_set_border_width(&(styles.dropdown_list), lv_dpx(theme->dropdown.list.border_width));
-    lv_style_set_border_color(&(styles.dropdown_list), lv_color_hex(theme->dropdown.list.border_color));
-    lv_style_set_radius(&(styles.dropdown_list), lv_dpx(theme->dropdown.list.corner_radius));
-    lv_style_set_pad_all(&(styles.dropdown_list), lv_dpx(theme->dropdown.list.pad));
-
-    reset_style(&(styles.dropdown_list_selected));
-    lv_style_set_text_color(&(styles.dropdown_list_selected), lv_color_hex(theme->dropdown.list.selection_fg_color));
-    lv_style_set_bg_opa(&(styles.dropdown_list_selected), LV_OPA_COVER);
-    lv_style_set_bg_color(&(styles.dropdown_list_selected), lv_color_hex(theme->dropdown.list.selection_bg_color));
-
-    reset_style(&(styles.label));
-    lv_style_set_text_color(&(styles.label), lv_color_hex(theme->label.fg_color));
-
-    reset_style(&(styles.msgbox));
-    lv_style_set_text_color(&(styles.msgbox), lv_color_hex(theme->msgbox.fg_color));
-    lv_style_set_bg_opa(&(styles.msgbox), LV_OPA_COVER);
-    lv_style_set_bg_color(&(styles.msgbox), lv_color_hex(theme->msgbox.bg_color));
-    lv_style_set_border_side(&(styles.msgbox), LV_BORDER_SIDE_FULL);
-    lv_style_set_border_width(&(styles.msgbox), lv_dpx(theme->msgbox.border_width));
-    lv_style_set_border_color(&(styles.msgbox), lv_color_hex(theme->msgbox.border_color));
-    lv_style_set_radius(&(styles.msgbox), lv_dpx(theme->msgbox.corner_radius));
-    lv_style_set_pad_all(&(styles.msgbox), lv_dpx(theme->msgbox.pad));
-
-    reset_style(&(styles.msgbox_label));
-    lv_style_set_text_align(&(styles.msgbox_label), LV_TEXT_ALIGN_CENTER);
-    lv_style_set_pad_bottom(&(styles.msgbox_label), lv_dpx(theme->msgbox.gap));
-
-    reset_style(&(styles.msgbox_btnmatrix));
-    lv_style_set_pad_gap(&(styles.msgbox_btnmatrix), lv_dpx(theme->msgbox.buttons.gap));
-    lv_style_set_min_width(&(styles.msgbox_btnmatrix), LV_PCT(100));
-
-    reset_style(&(styles.msgbox_background));
-    lv_style_set_bg_color(&(styles.msgbox_background), lv_color_hex(theme->msgbox.dimming.color));
-    lv_style_set_bg_opa(&(styles.msgbox_background), theme->msgbox.dimming.opacity);
-
-    reset_style(&(styles.bar));
-    lv_style_set_border_side(&(styles.bar), LV_BORDER_SIDE_FULL);
-    lv_style_set_border_width(&(styles.bar), lv_dpx(theme->bar.border_width));
-    lv_style_set_border_color(&(styles.bar), lv_color_hex(theme->bar.border_color));
-    lv_style_set_radius(&(styles.bar), lv_dpx(theme->bar.corner_radius));
-
-    reset_style(&(styles.bar_indicator));
-    lv_style_set_bg_opa(&(styles.bar_indicator), LV_OPA_COVER);
-    lv_style_set_bg_color(&(styles.bar_indicator), lv_color_hex(theme->bar.indicator.bg_color));
-
-    are_styles_initialised = true;
+static void init_styles(style_set *set, const theme *theme) {
+    lv_style_init(&(set->widget));
+    lv_style_set_text_font(&(set->widget), fonts_get());
+
+    lv_style_init(&(set->window));
+    lv_style_set_bg_opa(&(set->window), LV_OPA_COVER);
+    lv_style_set_bg_color(&(set->window), lv_color_hex(theme->window.bg_color));
+
+    lv_style_init(&(set->header));
+    lv_style_set_bg_opa(&(set->header), LV_OPA_COVER);
+    lv_style_set_bg_color(&(set->header), lv_color_hex(theme->header.bg_color));
+    lv_style_set_border_side(&(set->header), LV_BORDER_SIDE_BOTTOM);
+    lv_style_set_border_width(&(set->header), lv_dpx(theme->header.border_width));
+    lv_style_set_border_color(&(set->header), lv_color_hex(theme->header.border_color));
+    lv_style_set_pad_all(&(set->header), lv_dpx(theme->header.pad));
+    lv_style_set_pad_gap(&(set->header), lv_dpx(theme->header.gap));
+
+    lv_style_init(&(set->keyboard));
+    lv_style_set_bg_opa(&(set->keyboard), LV_OPA_COVER);
+    lv_style_set_bg_color(&(set->keyboard), lv_color_hex(theme->keyboard.bg_color));
+    lv_style_set_border_side(&(set->keyboard), LV_BORDER_SIDE_TOP);
+    lv_style_set_border_width(&(set->keyboard), lv_dpx(theme->keyboard.border_width));
+    lv_style_set_border_color(&(set->keyboard), lv_color_hex(theme->keyboard.border_color));
+    lv_style_set_pad_all(&(set->keyboard), lv_dpx(theme->keyboard.pad));
+    lv_style_set_pad_gap(&(set->keyboard), lv_dpx(theme->keyboard.gap));
+
+    lv_style_init(&(set->key));
+    lv_style_set_bg_opa(&(set->key), LV_OPA_COVER);
+    lv_style_set_border_side(&(set->key), LV_BORDER_SIDE_FULL);
+    lv_style_set_border_width(&(set->key), lv_dpx(theme->keyboard.keys.border_width));
+    lv_style_set_radius(&(set->key), lv_dpx(theme->keyboard.keys.corner_radius));
+
+    lv_style_init(&(set->button));
+    lv_style_set_text_color(&(set->button), lv_color_hex(theme->button.normal.fg_color));
+    lv_style_set_bg_opa(&(set->button), LV_OPA_COVER);
+    lv_style_set_bg_color(&(set->button), lv_color_hex(theme->button.normal.bg_color));
+    lv_style_set_border_side(&(set->button), LV_BORDER_SIDE_FULL);
+    lv_style_set_border_width(&(set->button), lv_dpx(theme->button.border_width));
+    lv_style_set_border_color(&(set->button), lv_color_hex(theme->button.normal.border_color));
+    lv_style_set_radius(&(set->button), lv_dpx(theme->button.corner_radius));
+    lv_style_set_pad_all(&(set->button), lv_dpx(theme->button.pad));
+
+    lv_style_init(&(set->button_pressed));
+    lv_style_set_text_color(&(set->button_pressed), lv_color_hex(theme->button.pressed.fg_color));
+    lv_style_set_bg_color(&(set->button_pressed), lv_color_hex(theme->button.pressed.bg_color));
+    lv_style_set_border_color(&(set->button_pressed), lv_color_hex(theme->button.pressed.border_color));
+
+    lv_style_init(&(set->textarea));
+    lv_style_set_text_color(&(set->textarea), lv_color_hex(theme->textarea.fg_color));
+    lv_style_set_bg_opa(&(set->textarea), LV_OPA_COVER);
+    lv_style_set_bg_color(&(set->textarea), lv_color_hex(theme->textarea.bg_color));  
+    lv_style_set_border_side(&(set->textarea), LV_BORDER_SIDE_FULL);
+    lv_style_set_border_width(&(set->textarea), lv_dpx(theme->textarea.border_width));
+    lv_style_set_border_color(&(set->textarea), lv_color_hex(theme->textarea.border_color));
+    lv_style_set_radius(&(set->textarea), lv_dpx(theme->textarea.corner_radius));
+    lv_style_set_pad_all(&(set->textarea), lv_dpx(theme->textarea.pad));
+
+    lv_style_init(&(set->textarea_placeholder));
+    lv_style_set_text_color(&(set->textarea_placeholder), lv_color_hex(theme->textarea.placeholder_color));
+
+    lv_style_init(&(set->textarea_cursor));
+    lv_style_set_border_side(&(set->textarea_cursor), LV_BORDER_SIDE_LEFT);
+    lv_style_set_border_width(&(set->textarea_cursor), lv_dpx(theme->textarea.cursor.width));
+    lv_style_set_border_color(&(set->textarea_cursor), lv_color_hex(theme->textarea.cursor.color));
+    lv_style_set_anim_time(&(set->textarea_cursor), theme->textarea.cursor.period);
+
+    lv_style_init(&(set->dropdown));
+    lv_style_set_text_color(&(set->dropdown), lv_color_hex(theme->dropdown.button.normal.fg_color));
+    lv_style_set_bg_opa(&(set->dropdown), LV_OPA_COVER);
+    lv_style_set_bg_color(&(set->dropdown), lv_color_hex(theme->dropdown.button.normal.bg_color));
+    lv_style_set_border_side(&(set->dropdown), LV_BORDER_SIDE_FULL);
+    lv_style_set_border_width(&(set->dropdown), lv_dpx(theme->dropdown.button.border_width));
+    lv_style_set_border_color(&(set->dropdown), lv_color_hex(theme->dropdown.button.normal.border_color));
+    lv_style_set_radius(&(set->dropdown), lv_dpx(theme->dropdown.button.corner_radius));
+    lv_style_set_pad_all(&(set->dropdown), lv_dpx(theme->dropdown.button.pad));
+
+    lv_style_init(&(set->dropdown_pressed));
+    lv_style_set_text_color(&(set->dropdown_pressed), lv_color_hex(theme->dropdown.button.pressed.fg_color));
+    lv_style_set_bg_color(&(set->dropdown_pressed), lv_color_hex(theme->dropdown.button.pressed.bg_color));
+    lv_style_set_border_color(&(set->dropdown_pressed), lv_color_hex(theme->dropdown.button.pressed.border_color));
+
+    lv_style_init(&(set->dropdown_list));
+    lv_style_set_text_color(&(set->dropdown_list), lv_color_hex(theme->dropdown.list.fg_color));
+    lv_style_set_bg_opa(&(set->dropdown_list), LV_OPA_COVER);
+    lv_style_set_bg_color(&(set->dropdown_list), lv_color_hex(theme->dropdown.list.bg_color));
+    lv_style_set_border_side(&(set->dropdown_list), LV_BORDER_SIDE_FULL);
+    lv_style_set_border_width(&(set->dropdown_list), lv_dpx(theme->dropdown.list.border_width));
+    lv_style_set_border_color(&(set->dropdown_list), lv_color_hex(theme->dropdown.list.border_color));
+    lv_style_set_radius(&(set->dropdown_list), lv_dpx(theme->dropdown.list.corner_radius));
+    lv_style_set_pad_all(&(set->dropdown_list), lv_dpx(theme->dropdown.list.pad));
+
+    lv_style_init(&(set->dropdown_list_selected));
+    lv_style_set_text_color(&(set->dropdown_list_selected), lv_color_hex(theme->dropdown.list.selection_fg_color));
+    lv_style_set_bg_opa(&(set->dropdown_list_selected), LV_OPA_COVER);
+    lv_style_set_bg_color(&(set->dropdown_list_selected), lv_color_hex(theme->dropdown.list.selection_bg_color));
+
+    lv_style_init(&(set->label));
+    lv_style_set_text_color(&(set->label), lv_color_hex(theme->label.fg_color));
+
+    lv_style_init(&(set->msgbox));
+    lv_style_set_text_color(&(set->msgbox), lv_color_hex(theme->msgbox.fg_color));
+    lv_style_set_bg_opa(&(set->msgbox), LV_OPA_COVER);
+    lv_style_set_bg_color(&(set->msgbox), lv_color_hex(theme->msgbox.bg_color));
+    lv_style_set_border_side(&(set->msgbox), LV_BORDER_SIDE_FULL);
+    lv_style_set_border_width(&(set->msgbox), lv_dpx(theme->msgbox.border_width));
+    lv_style_set_border_color(&(set->msgbox), lv_color_hex(theme->msgbox.border_color));
+    lv_style_set_radius(&(set->msgbox), lv_dpx(theme->msgbox.corner_radius));
+    lv_style_set_pad_all(&(set->msgbox), lv_dpx(theme->msgbox.pad));
+
+    lv_style_init(&(set->msgbox_label));
+    lv_style_set_text_align(&(set->msgbox_label), LV_TEXT_ALIGN_CENTER);
+    lv_style_set_pad_bottom(&(set->msgbox_label), lv_dpx(theme->msgbox.gap));
+
+    lv_style_init(&(set->msgbox_btnmatrix));
+    lv_style_set_pad_gap(&(set->msgbox_btnmatrix), lv_dpx(theme->msgbox.buttons.gap));
+    lv_style_set_min_width(&(set->msgbox_btnmatrix), LV_PCT(100));
+
+    lv_style_init(&(set->msgbox_background));
+    lv_style_set_bg_color(&(set->msgbox_background), lv_color_hex(theme->msgbox.dimming.color));
+    lv_style_set_bg_opa(&(set->msgbox_background), theme->msgbox.dimming.opacity);
+
+    lv_style_init(&(set->bar));
+    lv_style_set_border_side(&(set->bar), LV_BORDER_SIDE_FULL);
+    lv_style_set_border_width(&(set->bar), lv_dpx(theme->bar.border_width));
+    lv_style_set_border_color(&(set->bar), lv_color_hex(theme->bar.border_color));
+    lv_style_set_radius(&(set->bar), lv_dpx(theme->bar.corner_radius));
+
+    lv_style_init(&(set->bar_indicator));
+    lv_style_set_bg_opa(&(set->bar_indicator), LV_OPA_COVER);
+    lv_style_set_bg_color(&(set->bar_indicator), lv_color_hex(theme->bar.indicator.bg_color));
 }
 
-static void reset_style(lv_style_t *style) {
-    if (are_styles_initialised) {
-        lv_style_reset(style);
-    } else {
-        lv_style_init(style);
+static void reset_styles(style_set *set) {
+    lv_style_t *style = (lv_style_t *)set;
+    for (size_t i = 0; i < sizeof(style_set) / sizeof(lv_style_t); ++i) {
+        lv_style_reset(&style[i]);
     }
 }
 
+static const style_set *get_styles(const theme *theme) {
+    prebuilt_style_set *slot = NULL;
+
+    for (int i = 0; i < THEME_NUM_STYLE_SETS; ++i) {
+        if (prebuilt[i].theme == theme) {
+            return &(prebuilt[i].styles);
+        }
+        if (slot == NULL && prebuilt[i].theme == NULL) {
+            slot = &prebuilt[i];
+        }
+    }
+
+    if (slot == NULL) {
+        /* Only reachable with more than two themes in use. Recycle a set that isn't on screen. */
+        slot = prebuilt[0].theme == current_theme ? &prebuilt[1] : &prebuilt[0];
+        reset_styles(&(slot->styles));
+    }
+
+    init_styles(&(slot->styles), theme);
+    slot->theme = theme;
+    return &(slot->styles);
+}
+
 static void apply_theme_cb(lv_theme_t *theme, lv_obj_t *obj) {
     LV_UNUSED(theme);
 
@@ -346,13 +402,13 @@ static void keyboard_draw_part_begin_cb(lv_event_t *event) {
     theme_key *key = NULL;
 
     if ((btnm->ctrl_bits[dsc->id] & SQ2LV_CTRL_MOD_INACTIVE) == SQ2LV_CTRL_MOD_INACTIVE) {
-        key = &(current_theme.keyboard.keys.key_mod_inact);
+        key = &(current_theme->keyboard.keys.key_mod_inact);
     } else if ((btnm->ctrl_bits[dsc->id] & SQ2LV_CTRL_MOD_ACTIVE) == SQ2LV_CTRL_MOD_ACTIVE) {
-        key = &(current_theme.keyboard.keys.key_mod_act);
+        key = &(current_theme->keyboard.keys.key_mod_act);
     } else if ((btnm->ctrl_bits[dsc->id] & SQ2LV_CTRL_NON_CHAR) == SQ2LV_CTRL_NON_CHAR) {
-        key = &(current_theme.keyboard.keys.key_non_char);
+        key = &(current_theme->keyboard.keys.key_non_char);
     } else {
-        key = &(current_theme.keyboard.keys.key_char);
+        key = &(current_theme->keyboard.keys.key_char);
     }
 
     bool pressed = lv_btnmatrix_get_selected_btn(obj) == dsc->id && lv_obj_has_state(obj, LV_STATE_PRESSED);
@@ -371,22 +427,37 @@ void theme_prepare_keyboard(lv_obj_t *keyboard) {
     lv_obj_add_event_cb(keyboard, keyboard_draw_part_begin_cb, LV_EVENT_DRAW_PART_BEGIN, NULL);
 }
 
+void theme_prepare(const theme *default_theme, const theme *alternate_theme) {
+    get_styles(default_theme);
+    get_styles(alternate_theme);
+}
+
 void theme_apply(const theme *theme) {
     if (!theme) {
-        printf("Could not apply theme from NULL pointer\n");
+        log_error("Could not apply theme from NULL pointer");
+        return;
+    }
+
+    if (theme == current_theme) {
         return;
     }
 
-    lv_theme.disp = NULL;
-    lv_theme.font_small = &font_32;
-    lv_theme.font_normal = &font_32;
-    lv_theme.font_large = &font_32;
-    lv_theme.apply_cb = apply_theme_cb;
+    const bool is_first = current_theme == NULL;
+    styles = *get_styles(theme);
+    current_theme = theme;
+
+    if (is_first) {
+        lv_theme.disp = NULL;
+        lv_theme.font_small = fonts_get();
+        lv_theme.font_normal = fonts_get();
+        lv_theme.font_large = fonts_get();
+        lv_theme.apply_cb = apply_theme_cb;
 
-    current_theme = *theme;
-    init_styles(theme);
+        lv_disp_set_theme(NULL, &lv_theme);
+        lv_theme_apply(lv_scr_act());
+        return;
+    }
 
+    /* Objects keep their styles, only the values behind them changed */
     lv_obj_report_style_change(NULL);
-    lv_disp_set_theme(NULL, &lv_theme);
-    lv_theme_apply(lv_scr_act());
 }
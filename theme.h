@@ -196,7 +196,16 @@ typedef struct {
 void theme_prepare_keyboard(lv_obj_t *keyboard);
 
 /**
- * Apply a UI theme.
+ * Build the styles of the default and the alternate theme up front, so switching between them
+ * only swaps style values. Call this after the display was registered.
+ *
+ * @param default_theme default theme
+ * @param alternate_theme alternate theme
+ */
+void theme_prepare(const theme *default_theme, const theme *alternate_theme);
+
+/**
+ * Apply a UI theme. The theme must stay valid while it is applied.
  *
  * @param theme the theme to apply
  */
@@ -20,7 +20,8 @@
 
 #include "themes.h"
 
-#include <stdio.h>
+#include "log.h"
+
 
 /**
  * Static variables
@@ -670,10 +671,10 @@ const theme themes_themes[] = {
 themes_theme_id_t themes_find_theme_with_name(const char *name) {
     for (int i = 0; i < themes_num_themes; ++i) {
         if (strcmp(themes_themes[i].name, name) == 0) {
-            printf("Found theme: %s\n", name);
+            log_verbose("Found theme: %s", name);
             return i;
         }
     }
-    printf("Theme %s not found\n", name);
+    log_warning("Theme %s not found", name);
     return THEMES_THEME_NONE;
 }
@@ -0,0 +1,51 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef TICK_H
+#define TICK_H
+
+/* NOTE: This header is included from lv_conf.h and must not include LVGL */
+
+#include <stdint.h>
+
+/**
+ * Get the current time of the monotonic clock. It doesn't jump when the wall clock is set, and
+ * libinput event times use the same clock.
+ *
+ * @return time in microseconds
+ */
+uint64_t tick_now_us(void);
+
+/**
+ * Get the time since boot, including time spent suspended. Comparable to the process start
+ * times in /proc.
+ *
+ * @return time in microseconds
+ */
+uint64_t tick_boot_us(void);
+
+/**
+ * Get the tick for LVGL. Used as LV_TICK_CUSTOM_SYS_TIME_EXPR.
+ *
+ * @return milliseconds since the first call, wrapping after 49 days like LVGL expects
+ */
+uint32_t tick_get_ms(void);
+
+#endif /* TICK_H */
@@ -0,0 +1,205 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "worker.h"
+
+#include "log.h"
+#include "tick.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Defines
+ */
+
+/* Capacity of the event queue. Progress updates are coalesced, so this only needs to hold a few phases. */
+#define WORKER_QUEUE_SIZE 16
+
+
+/**
+ * Static types
+ */
+
+struct worker {
+    /* Worker thread */
+    pthread_t thread;
+    /* Job function */
+    worker_fn fn;
+    /* User data for the job function */
+    void *user_data;
+    /* Protects the fields below */
+    pthread_mutex_t lock;
+    /* Ring buffer of pending events */
+    worker_event queue[WORKER_QUEUE_SIZE];
+    /* Index of the oldest pending event */
+    size_t head;
+    /* Number of pending events */
+    size_t count;
+    /* Phase of the last progress update */
+    const char *phase;
+    /* Start of the last progress update's phase in microseconds */
+    uint64_t phase_start_us;
+};
+
+
+/**
+ * Static prototypes
+ */
+
+/**
+ * Append an event to the queue, dropping the oldest progress event if the queue is full. Must be
+ * called with the lock held.
+ *
+ * @param w the worker
+ * @param event the event to append
+ */
+static void push_event(worker *w, const worker_event *event);
+
+/**
+ * Worker thread main function.
+ *
+ * @param arg the worker
+ * @return NULL
+ */
+static void *worker_main(void *arg);
+
+
+/**
+ * Static functions
+ */
+
+static void push_event(worker *w, const worker_event *event) {
+    if (w->count == WORKER_QUEUE_SIZE) {
+        /* Only reachable with pathological phase churn, losing an intermediate update is harmless */
+        w->head = (w->head + 1) % WORKER_QUEUE_SIZE;
+        --w->count;
+    }
+
+    w->queue[(w->head + w->count) % WORKER_QUEUE_SIZE] = *event;
+    ++w->count;
+}
+
+static void *worker_main(void *arg) {
+    worker *w = arg;
+    int result = w->fn(w, w->user_data);
+
+    worker_event event;
+    memset(&event, 0, sizeof(event));
+    event.type = WORKER_EVENT_DONE;
+    event.eta_seconds = -1;
+    event.result = result;
+
+    pthread_mutex_lock(&w->lock);
+    push_event(w, &event);
+    pthread_mutex_unlock(&w->lock);
+
+    return NULL;
+}
+
+
+/**
+ * Public functions
+ */
+
+worker *worker_start(worker_fn fn, void *user_data) {
+    worker *w = calloc(1, sizeof(worker));
+    if (w == NULL) {
+        log_error("Could not allocate worker");
+        return NULL;
+    }
+
+    w->fn = fn;
+    w->user_data = user_data;
+    pthread_mutex_init(&w->lock, NULL);
+
+    if (pthread_create(&w->thread, NULL, worker_main, w) != 0) {
+        log_error("pthread_create: %s", strerror(errno));
+        pthread_mutex_destroy(&w->lock);
+        free(w);
+        return NULL;
+    }
+
+    return w;
+}
+
+void worker_post_progress(worker *w, const char *phase, uint64_t bytes_done, uint64_t bytes_total) {
+    uint64_t now = tick_now_us();
+
+    pthread_mutex_lock(&w->lock);
+
+    if (phase != w->phase) {
+        w->phase = phase;
+        w->phase_start_us = now;
+    }
+
+    worker_event event;
+    memset(&event, 0, sizeof(event));
+    event.type = WORKER_EVENT_PROGRESS;
+    event.phase = phase;
+    event.bytes_done = bytes_done;
+    event.bytes_total = bytes_total;
+    event.eta_seconds = -1;
+
+    uint64_t elapsed_us = now - w->phase_start_us;
+    if (elapsed_us > 0 && bytes_done > 0) {
+        event.bytes_per_second = (uint64_t)((double)bytes_done * 1000000 / elapsed_us);
+        if (bytes_total >= bytes_done && event.bytes_per_second > 0) {
+            event.eta_seconds = (int)((bytes_total - bytes_done) / event.bytes_per_second);
+        }
+    }
+
+    /* Replace a pending update of the same phase, the UI only ever needs the latest one */
+    worker_event *last = w->count > 0 ? &w->queue[(w->head + w->count - 1) % WORKER_QUEUE_SIZE] : NULL;
+    if (last != NULL && last->type == WORKER_EVENT_PROGRESS && last->phase == phase) {
+        *last = event;
+    } else {
+        push_event(w, &event);
+    }
+
+    pthread_mutex_unlock(&w->lock);
+}
+
+bool worker_poll(worker *w, worker_event *event) {
+    bool found = false;
+
+    pthread_mutex_lock(&w->lock);
+    if (w->count > 0) {
+        *event = w->queue[w->head];
+        w->head = (w->head + 1) % WORKER_QUEUE_SIZE;
+        --w->count;
+        found = true;
+    }
+    pthread_mutex_unlock(&w->lock);
+
+    return found;
+}
+
+void worker_free(worker *w) {
+    if (w == NULL) {
+        return;
+    }
+
+    pthread_join(w->thread, NULL);
+    pthread_mutex_destroy(&w->lock);
+    free(w);
+}
@@ -0,0 +1,103 @@
+/**
+ * Copyright 2026 FuriLabs
+ *
+ * This file is part of furios-recovery, hereafter referred to as the program.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef WORKER_H
+#define WORKER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Event types */
+typedef enum {
+    /* The job made progress */
+    WORKER_EVENT_PROGRESS = 0,
+    /* The job finished, no further events will follow */
+    WORKER_EVENT_DONE = 1
+} worker_event_type;
+
+/**
+ * Event posted from a worker thread to the UI thread
+ */
+typedef struct {
+    /* Event type */
+    worker_event_type type;
+    /* Description of the current phase, must be a string literal */
+    const char *phase;
+    /* Number of bytes processed in the current phase */
+    uint64_t bytes_done;
+    /* Total number of bytes of the current phase, 0 if unknown */
+    uint64_t bytes_total;
+    /* Average throughput of the current phase in bytes per second */
+    uint64_t bytes_per_second;
+    /* Estimated remaining time of the current phase in seconds, -1 if unknown */
+    int eta_seconds;
+    /* Return value of the job function, only set for WORKER_EVENT_DONE */
+    int result;
+} worker_event;
+
+/* Opaque worker handle */
+typedef struct worker worker;
+
+/**
+ * Job function run on the worker thread.
+ *
+ * @param w the worker, for posting progress
+ * @param user_data user data passed to worker_start
+ * @return result delivered with the WORKER_EVENT_DONE event
+ */
+typedef int (*worker_fn)(worker *w, void *user_data);
+
+/**
+ * Run a job on a new background thread.
+ *
+ * @param fn job function
+ * @param user_data user data to pass to the job function
+ * @return worker handle or NULL if the thread could not be started
+ */
+worker *worker_start(worker_fn fn, void *user_data);
+
+/**
+ * Post a progress update from the worker thread. Consecutive updates for the same phase are coalesced
+ * so that the queue never fills up, no matter how often this is called.
+ *
+ * @param w the worker
+ * @param phase description of the current phase, must be a string literal
+ * @param bytes_done number of bytes processed in the current phase
+ * @param bytes_total total number of bytes of the current phase, 0 if unknown
+ */
+void worker_post_progress(worker *w, const char *phase, uint64_t bytes_done, uint64_t bytes_total);
+
+/**
+ * Take the oldest pending event from the worker's queue. Call this from the UI thread.
+ *
+ * @param w the worker
+ * @param event pointer for writing the event into
+ * @return true if an event was taken, false if the queue was empty
+ */
+bool worker_poll(worker *w, worker_event *event);
+
+/**
+ * Wait for the worker thread to exit and release the worker. Call this after WORKER_EVENT_DONE was received.
+ *
+ * @param w the worker
+ */
+void worker_free(worker *w);
+
+#endif /* WORKER_H */